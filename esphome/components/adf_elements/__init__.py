@@ -0,0 +1,5 @@
+"""Generic ADF-Pipeline elements (tone generator, filters, ...)."""
+
+CODEOWNERS = ["@gnumpi"]
+AUTO_LOAD = ["adf_pipeline"]
+DEPENDENCIES = ["adf_pipeline"]
@@ -0,0 +1,871 @@
+"""ADF-Pipeline platform implementation of generic audio elements."""
+
+import re
+
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome import automation
+from esphome.automation import register_action
+from esphome.components import esp32, sensor
+
+from esphome.const import (
+    CONF_FROM,
+    CONF_ID,
+    CONF_MODEL,
+    CONF_NAME,
+    CONF_TO,
+    CONF_TRIGGER_ID,
+    CONF_TYPE,
+    STATE_CLASS_MEASUREMENT,
+)
+
+from ... import adf_pipeline as esp_adf
+from ... import voice_assistant
+from ...i2s_audio.adf_pipeline import ADFElementI2SIn, ADFElementI2SOut
+
+CODEOWNERS = ["@gnumpi"]
+AUTO_LOAD = ["adf_pipeline", "sensor"]
+DEPENDENCIES = ["adf_pipeline"]
+
+ADF_ELEMENT_TONE = "tone"
+ADF_ELEMENT_EQUALIZER = "equalizer"
+ADF_ELEMENT_GAIN = "gain"
+ADF_ELEMENT_COMPRESSOR = "compressor"
+ADF_ELEMENT_AEC = "aec"
+ADF_ELEMENT_NOISE_SUPPRESSION = "noise_suppression"
+ADF_ELEMENT_CHANNEL_MIXER = "channel_mixer"
+ADF_ELEMENT_BIT_DEPTH_CONVERTER = "bit_depth_converter"
+ADF_ELEMENT_BEAMFORMER = "beamformer"
+ADF_ELEMENT_WAKE_WORD = "wake_word"
+ADF_ELEMENT_RESAMPLER = "resampler"
+ADF_ELEMENT_LEVEL_METER = "level_meter"
+ADF_ELEMENT_OPUS_ENCODER = "opus_encoder"
+ADF_ELEMENT_HIGH_PASS = "high_pass"
+ADF_ELEMENT_CROSSFADE = "crossfade"
+ADF_ELEMENT_FILE_SOURCE = "file_source"
+ADF_ELEMENT_FILE_SINK = "file_sink"
+
+CONF_TONES = "tones"
+CONF_STEPS = "steps"
+CONF_ATTACK = "attack"
+CONF_RELEASE = "release"
+CONF_FREQUENCY = "frequency"
+CONF_TO_FREQUENCY = "to_frequency"
+CONF_DURATION = "duration"
+CONF_AMPLITUDE = "amplitude"
+CONF_TONE = "tone"
+CONF_BANDS = "bands"
+CONF_GAIN = "gain"
+CONF_Q = "q"
+CONF_RAMP_TIME = "ramp_time"
+CONF_MODE = "mode"
+CONF_THRESHOLD = "threshold"
+CONF_RATIO = "ratio"
+CONF_LOOKAHEAD = "lookahead"
+CONF_MAKEUP_GAIN = "makeup_gain"
+CONF_BYPASS = "bypass"
+CONF_PLAYBACK = "playback"
+CONF_CAPTURE = "capture"
+CONF_FILTER_LENGTH = "filter_length"
+CONF_MIC_CHANNEL = "mic_channel"
+CONF_TASK_CORE = "task_core"
+CONF_TASK_PRIORITY = "task_priority"
+CONF_TASK_STACK_SIZE = "task_stack_size"
+CONF_NOISE_SUPPRESSION_LEVEL = "noise_suppression_level"
+CONF_AUTO_GAIN = "auto_gain"
+CONF_MAX_GAIN = "max_gain"
+CONF_MAP = "map"
+CONF_BITS_PER_SAMPLE = "bits_per_sample"
+CONF_GAIN_LOG_2 = "gain_log2"
+CONF_MIC_CHANNELS = "mic_channels"
+CONF_MAX_MIC_DISTANCE = "max_mic_distance"
+CONF_MODEL_PARTITION = "model_partition"
+CONF_DETECTION_MODE = "detection_mode"
+CONF_VOICE_ASSISTANT = "voice_assistant"
+CONF_HIGH_PASS = "high_pass"
+CONF_PRE_ROLL = "pre_roll"
+CONF_ON_WAKE_WORD_DETECTED = "on_wake_word_detected"
+CONF_QUALITY = "quality"
+CONF_RMS = "rms"
+CONF_PEAK = "peak"
+CONF_BITRATE = "bitrate"
+CONF_COMPLEXITY = "complexity"
+CONF_FRAME_DURATION = "frame_duration"
+CONF_NORMALIZATION = "normalization"
+CONF_TARGET_LOUDNESS = "target_loudness"
+CONF_ADJUST_TIME = "adjust_time"
+CONF_PATH = "path"
+CONF_FORMAT = "format"
+CONF_SAMPLE_RATE = "sample_rate"
+CONF_CHANNELS = "channels"
+CONF_BUFFER_SIZE = "buffer_size"
+
+COMPRESSOR_MODES = ["compressor", "limiter"]
+
+ADFToneSource = esp_adf.esp_adf_ns.class_(
+    "ADFToneSource",
+    esp_adf.ADFPipelineSource,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ADFEqualizer = esp_adf.esp_adf_ns.class_(
+    "ADFEqualizer",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ADFGain = esp_adf.ADFGain
+
+ADFCompressor = esp_adf.esp_adf_ns.class_(
+    "ADFCompressor",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ADFAEC = esp_adf.esp_adf_ns.class_(
+    "ADFAEC",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ADFNoiseSuppression = esp_adf.esp_adf_ns.class_(
+    "ADFNoiseSuppression",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ADFChannelMixer = esp_adf.ADFChannelMixer
+ADFBitDepthConverter = esp_adf.ADFBitDepthConverter
+
+ADFHighPass = esp_adf.esp_adf_ns.class_(
+    "ADFHighPass",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ChannelMixMode = esp_adf.esp_adf_ns.enum("ChannelMixMode", is_class=True)
+CHANNEL_MIX_MODES = {
+    "auto": ChannelMixMode.AUTO,
+    "left": ChannelMixMode.LEFT,
+    "right": ChannelMixMode.RIGHT,
+    "average": ChannelMixMode.AVERAGE,
+    "map": ChannelMixMode.MAP,
+}
+# special sources of a mapped output channel, see ChannelMap
+CHANNEL_MAP_SOURCES = {
+    "silent": -1,
+    "average": -2,
+}
+
+ADFBeamformer = esp_adf.esp_adf_ns.class_(
+    "ADFBeamformer",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ADFWakeWord = esp_adf.esp_adf_ns.class_(
+    "ADFWakeWord",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+WakeWordDetectedTrigger = esp_adf.esp_adf_ns.class_(
+    "WakeWordDetectedTrigger", automation.Trigger.template(cg.std_string)
+)
+
+DetectionMode = cg.global_ns.enum("det_mode_t")
+DETECTION_MODES = {
+    "normal": DetectionMode.DET_MODE_90,
+    "aggressive": DetectionMode.DET_MODE_95,
+}
+
+ADFResampler = esp_adf.ADFResampler
+
+ADFLevelMeter = esp_adf.esp_adf_ns.class_(
+    "ADFLevelMeter",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.PollingComponent,
+)
+
+ADFOpusEncoder = esp_adf.esp_adf_ns.class_(
+    "ADFOpusEncoder",
+    esp_adf.ADFPipelineProcess,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ResampleQuality = esp_adf.esp_adf_ns.enum("ResampleQuality", is_class=True)
+RESAMPLE_QUALITIES = {
+    "adf": ResampleQuality.ADF,
+    "low": ResampleQuality.LOW,
+    "medium": ResampleQuality.MEDIUM,
+    "high": ResampleQuality.HIGH,
+}
+
+AECMode = cg.global_ns.enum("aec_mode_t")
+AEC_MODES = {
+    "sr_low_cost": AECMode.AEC_MODE_SR_LOW_COST,
+    "sr_high_perf": AECMode.AEC_MODE_SR_HIGH_PERF,
+    "voip_low_cost": AECMode.AEC_MODE_VOIP_LOW_COST,
+    "voip_high_perf": AECMode.AEC_MODE_VOIP_HIGH_PERF,
+}
+
+EqBandType = esp_adf.esp_adf_ns.enum("EqBandType", is_class=True)
+EQ_BAND_TYPES = {
+    "peaking": EqBandType.PEAKING,
+    "low_shelf": EqBandType.LOW_SHELF,
+    "high_shelf": EqBandType.HIGH_SHELF,
+    "low_pass": EqBandType.LOW_PASS,
+    "high_pass": EqBandType.HIGH_PASS,
+}
+
+ADFFileSource = esp_adf.esp_adf_ns.class_(
+    "ADFFileSource",
+    esp_adf.ADFPipelineSource,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+ADFFileSink = esp_adf.esp_adf_ns.class_(
+    "ADFFileSink",
+    esp_adf.ADFPipelineSink,
+    esp_adf.ADFPipelineElement,
+    cg.Component,
+)
+
+FileFormat = esp_adf.esp_adf_ns.enum("FileFormat", is_class=True)
+FILE_FORMATS = {
+    "wav": FileFormat.WAV,
+    "raw": FileFormat.RAW,
+}
+
+PlayToneAction = esp_adf.esp_adf_ns.class_(
+    "PlayToneAction", automation.Action, cg.Parented.template(ADFToneSource)
+)
+PlayFileAction = esp_adf.esp_adf_ns.class_(
+    "PlayFileAction", automation.Action, cg.Parented.template(ADFFileSource)
+)
+RecordFileAction = esp_adf.esp_adf_ns.class_(
+    "RecordFileAction", automation.Action, cg.Parented.template(ADFFileSink)
+)
+StopRecordingAction = esp_adf.esp_adf_ns.class_(
+    "StopRecordingAction", automation.Action, cg.Parented.template(ADFFileSink)
+)
+
+TONE_STEP_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_FREQUENCY): cv.int_range(min=0, max=20000),
+        cv.Optional(CONF_TO_FREQUENCY): cv.int_range(min=0, max=20000),
+        cv.Required(CONF_DURATION): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=65535)),
+        ),
+        cv.Optional(CONF_AMPLITUDE, default="50%"): cv.percentage,
+    }
+)
+
+TONE_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_NAME): cv.string_strict,
+        cv.Optional(CONF_ATTACK, default="5ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_RELEASE, default="5ms"): cv.positive_time_period_milliseconds,
+        cv.Required(CONF_STEPS): cv.All(cv.ensure_list(TONE_STEP_SCHEMA), cv.Length(min=1)),
+    }
+)
+
+CONFIG_SCHEMA_TONE = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFToneSource),
+        cv.Required(CONF_TONES): cv.All(cv.ensure_list(TONE_SCHEMA), cv.Length(min=1)),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+EQ_BAND_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_TYPE, default="peaking"): cv.enum(EQ_BAND_TYPES, lower=True),
+        cv.Required(CONF_FREQUENCY): cv.All(cv.frequency, cv.Range(min=10, max=24000)),
+        cv.Optional(CONF_GAIN, default=0.0): cv.All(cv.float_, cv.Range(min=-15, max=15)),
+        cv.Optional(CONF_Q, default=0.707): cv.All(cv.float_, cv.Range(min=0.1, max=20)),
+    }
+)
+
+CONFIG_SCHEMA_EQUALIZER = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFEqualizer),
+        cv.Required(CONF_BANDS): cv.All(cv.ensure_list(EQ_BAND_SCHEMA), cv.Length(min=1)),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_GAIN = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFGain),
+        cv.Optional(CONF_GAIN, default=0.0): cv.All(cv.float_, cv.Range(min=-48, max=18)),
+        cv.Optional(CONF_RAMP_TIME, default="25ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=1000)),
+        ),
+        cv.Optional(CONF_NORMALIZATION): cv.Schema(
+            {
+                cv.Optional(CONF_TARGET_LOUDNESS, default=-18.0): cv.All(
+                    cv.float_, cv.Range(min=-40, max=-5)
+                ),
+                cv.Optional(CONF_MAX_GAIN, default=12.0): cv.All(
+                    cv.float_, cv.Range(min=0, max=18)
+                ),
+                cv.Optional(CONF_ADJUST_TIME, default="5s"): cv.All(
+                    cv.positive_time_period_milliseconds,
+                    cv.Range(
+                        min=cv.TimePeriod(milliseconds=500),
+                        max=cv.TimePeriod(seconds=60),
+                    ),
+                ),
+            }
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_COMPRESSOR = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFCompressor),
+        cv.Optional(CONF_MODE, default="compressor"): cv.one_of(
+            *COMPRESSOR_MODES, lower=True
+        ),
+        cv.Optional(CONF_THRESHOLD, default=-12.0): cv.All(
+            cv.float_, cv.Range(min=-60, max=0)
+        ),
+        cv.Optional(CONF_RATIO, default=4.0): cv.All(
+            cv.float_, cv.Range(min=1, max=100)
+        ),
+        cv.Optional(CONF_ATTACK, default="5ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=500)),
+        ),
+        cv.Optional(CONF_RELEASE, default="100ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=5000)),
+        ),
+        cv.Optional(CONF_LOOKAHEAD, default="5ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=20)),
+        ),
+        cv.Optional(CONF_MAKEUP_GAIN, default=0.0): cv.All(
+            cv.float_, cv.Range(min=0, max=24)
+        ),
+        cv.Optional(CONF_BYPASS, default=False): cv.boolean,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_AEC = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFAEC),
+        cv.Required(CONF_PLAYBACK): cv.use_id(ADFElementI2SOut),
+        cv.Required(CONF_CAPTURE): cv.use_id(ADFElementI2SIn),
+        cv.Optional(CONF_MODE, default="sr_low_cost"): cv.enum(AEC_MODES, lower=True),
+        cv.Optional(CONF_FILTER_LENGTH, default=4): cv.int_range(min=1, max=8),
+        cv.Optional(CONF_MIC_CHANNEL, default=0): cv.int_range(min=0, max=7),
+        cv.Optional(CONF_TASK_CORE, default=1): cv.int_range(min=0, max=1),
+        cv.Optional(CONF_TASK_PRIORITY, default=8): cv.int_range(min=1, max=24),
+        cv.Optional(CONF_TASK_STACK_SIZE, default=8192): cv.int_range(
+            min=4096, max=32768
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_NOISE_SUPPRESSION = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFNoiseSuppression),
+        cv.Optional(CONF_NOISE_SUPPRESSION_LEVEL, default=2): cv.int_range(0, 3),
+        cv.Optional(CONF_AUTO_GAIN, default="3dBFS"): cv.All(
+            cv.float_with_unit("decibel full scale", "(dBFS|dbfs|DBFS)"),
+            cv.int_range(0, 31),
+        ),
+        cv.Optional(CONF_MAX_GAIN, default=15): cv.int_range(0, 90),
+        cv.Optional(CONF_MIC_CHANNEL, default=0): cv.int_range(min=0, max=7),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+
+def channel_map_source(value):
+    if isinstance(value, str) and value.lower() in CHANNEL_MAP_SOURCES:
+        return CHANNEL_MAP_SOURCES[value.lower()]
+    return cv.int_range(min=0, max=15)(value)
+
+
+def validate_channel_mixer(config):
+    if CONF_MAP in config and config[CONF_MODE] != "map":
+        raise cv.Invalid(f"'{CONF_MAP}' requires mode 'map'")
+    if config[CONF_MODE] == "map" and CONF_MAP not in config:
+        raise cv.Invalid(f"mode 'map' requires '{CONF_MAP}'")
+    return config
+
+
+CONFIG_SCHEMA_CHANNEL_MIXER = cv.All(
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(ADFChannelMixer),
+            cv.Optional(CONF_MODE, default="auto"): cv.one_of(
+                *CHANNEL_MIX_MODES, lower=True
+            ),
+            cv.Optional(CONF_MAP): cv.All(
+                cv.ensure_list(channel_map_source), cv.Length(min=1, max=16)
+            ),
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    validate_channel_mixer,
+)
+
+CONFIG_SCHEMA_BIT_DEPTH_CONVERTER = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFBitDepthConverter),
+        cv.Optional(CONF_BITS_PER_SAMPLE, default="16bit"): cv.All(
+            cv.float_with_unit("bits", "bit"), cv.one_of(16, 24, 32, int=True)
+        ),
+        cv.Optional(CONF_GAIN_LOG_2, default=0): cv.int_range(0, 7),
+        cv.Optional(CONF_HIGH_PASS): esp_adf.HIGH_PASS_SCHEMA,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_CROSSFADE = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(esp_adf.ADFCrossfade),
+        cv.Optional(CONF_DURATION, default="1s"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(
+                min=cv.TimePeriod(milliseconds=100), max=cv.TimePeriod(seconds=5)
+            ),
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_HIGH_PASS = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFHighPass),
+    }
+).extend(esp_adf.HIGH_PASS_SCHEMA).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_BEAMFORMER = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFBeamformer),
+        cv.Optional(CONF_MIC_CHANNELS): cv.All(
+            cv.ensure_list(cv.int_range(min=0, max=7)),
+            cv.Length(min=2, max=8),
+        ),
+        cv.Optional(CONF_MAX_MIC_DISTANCE, default="100mm"): cv.All(
+            cv.distance, cv.Range(min=0.005, max=0.5)
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+def wake_word_model(value):
+    value = cv.string_strict(value).lower()
+    if re.fullmatch(r"wn\d+_[a-z0-9_]+", value) is None:
+        raise cv.Invalid(f"'{value}' is not a WakeNet model name, e.g. 'wn9_hiesp'")
+    return value
+
+
+CONFIG_SCHEMA_WAKE_WORD = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFWakeWord),
+        cv.Optional(CONF_MODEL, default="wn9_hiesp"): wake_word_model,
+        cv.Optional(CONF_MODEL_PARTITION, default="model"): cv.string_strict,
+        cv.Optional(CONF_DETECTION_MODE, default="normal"): cv.enum(
+            DETECTION_MODES, lower=True
+        ),
+        cv.Optional(CONF_MIC_CHANNEL, default=0): cv.int_range(min=0, max=7),
+        cv.Optional(CONF_VOICE_ASSISTANT): cv.use_id(voice_assistant.VoiceAssistant),
+        cv.Optional(CONF_PRE_ROLL, default="1000ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=2000)),
+        ),
+        cv.Optional(CONF_ON_WAKE_WORD_DETECTED): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(WakeWordDetectedTrigger),
+            }
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_RESAMPLER = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFResampler),
+        cv.Optional(CONF_QUALITY, default="medium"): cv.enum(
+            RESAMPLE_QUALITIES, lower=True
+        ),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+LEVEL_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement="dBFS",
+    icon="mdi:waveform",
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_MEASUREMENT,
+)
+
+
+def validate_meter_band(config):
+    if config[CONF_FROM] >= config[CONF_TO]:
+        raise cv.Invalid(f"'{CONF_FROM}' has to be below '{CONF_TO}'")
+    return config
+
+
+CONFIG_SCHEMA_LEVEL_METER = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFLevelMeter),
+        cv.Optional(CONF_RMS): LEVEL_SENSOR_SCHEMA,
+        cv.Optional(CONF_PEAK): LEVEL_SENSOR_SCHEMA,
+        cv.Optional(CONF_BANDS): cv.All(
+            cv.ensure_list(
+                cv.All(
+                    LEVEL_SENSOR_SCHEMA.extend(
+                        {
+                            cv.Required(CONF_FROM): cv.frequency,
+                            cv.Required(CONF_TO): cv.frequency,
+                        }
+                    ),
+                    validate_meter_band,
+                )
+            ),
+            cv.Length(min=1, max=8),
+        ),
+    }
+).extend(cv.polling_component_schema("1s"))
+
+def opus_bitrate(value):
+    if isinstance(value, str):
+        match = re.fullmatch(r"(\d+(?:\.\d+)?)\s*(k?)bps", value.strip().lower())
+        if match is None:
+            raise cv.Invalid(f"'{value}' is not a bitrate, e.g. '24kbps'")
+        value = float(match.group(1)) * (1000 if match.group(2) else 1)
+    return cv.int_range(min=6000, max=128000)(int(value))
+
+
+def opus_frame_duration(value):
+    value = cv.positive_time_period_milliseconds(value)
+    if value.total_milliseconds not in (10, 20, 40, 60):
+        raise cv.Invalid("Opus frame duration has to be 10ms, 20ms, 40ms or 60ms")
+    return value
+
+
+CONFIG_SCHEMA_OPUS_ENCODER = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFOpusEncoder),
+        cv.Optional(CONF_BITRATE, default="24kbps"): opus_bitrate,
+        cv.Optional(CONF_COMPLEXITY, default=5): cv.int_range(0, 10),
+        cv.Optional(CONF_FRAME_DURATION, default="20ms"): opus_frame_duration,
+        cv.Optional(CONF_VOICE_ASSISTANT): cv.use_id(voice_assistant.VoiceAssistant),
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+FILE_BITS_PER_SAMPLE = cv.All(
+    cv.float_with_unit("bits", "bit"), cv.one_of(16, 24, 32, int=True)
+)
+
+FILE_BUFFER_SIZE = cv.All(cv.validate_bytes, cv.int_range(min=512, max=65536))
+
+CONFIG_SCHEMA_FILE_SOURCE = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFFileSource),
+        cv.Optional(CONF_PATH, default=""): cv.string,
+        cv.Optional(CONF_FORMAT, default="wav"): cv.enum(FILE_FORMATS, lower=True),
+        # format of raw files, WAV files bring their own
+        cv.Optional(CONF_SAMPLE_RATE, default=16000): cv.int_range(min=1000, max=96000),
+        cv.Optional(CONF_BITS_PER_SAMPLE, default="16bit"): FILE_BITS_PER_SAMPLE,
+        cv.Optional(CONF_CHANNELS, default=1): cv.int_range(min=1, max=8),
+        cv.Optional(CONF_BUFFER_SIZE, default="8kB"): FILE_BUFFER_SIZE,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA_FILE_SINK = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(ADFFileSink),
+        cv.Optional(CONF_PATH, default=""): cv.string,
+        cv.Optional(CONF_FORMAT, default="wav"): cv.enum(FILE_FORMATS, lower=True),
+        # requested from the pipeline, what arrives is recorded if not set
+        cv.Optional(CONF_SAMPLE_RATE): cv.int_range(min=1000, max=96000),
+        cv.Optional(CONF_BITS_PER_SAMPLE): FILE_BITS_PER_SAMPLE,
+        cv.Optional(CONF_CHANNELS): cv.int_range(min=1, max=8),
+        cv.Optional(CONF_BUFFER_SIZE, default="8kB"): FILE_BUFFER_SIZE,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+CONFIG_SCHEMA = cv.typed_schema(
+    {
+        ADF_ELEMENT_TONE: CONFIG_SCHEMA_TONE,
+        ADF_ELEMENT_EQUALIZER: CONFIG_SCHEMA_EQUALIZER,
+        ADF_ELEMENT_GAIN: CONFIG_SCHEMA_GAIN,
+        ADF_ELEMENT_COMPRESSOR: CONFIG_SCHEMA_COMPRESSOR,
+        ADF_ELEMENT_AEC: CONFIG_SCHEMA_AEC,
+        ADF_ELEMENT_NOISE_SUPPRESSION: CONFIG_SCHEMA_NOISE_SUPPRESSION,
+        ADF_ELEMENT_CHANNEL_MIXER: CONFIG_SCHEMA_CHANNEL_MIXER,
+        ADF_ELEMENT_BIT_DEPTH_CONVERTER: CONFIG_SCHEMA_BIT_DEPTH_CONVERTER,
+        ADF_ELEMENT_BEAMFORMER: CONFIG_SCHEMA_BEAMFORMER,
+        ADF_ELEMENT_WAKE_WORD: CONFIG_SCHEMA_WAKE_WORD,
+        ADF_ELEMENT_RESAMPLER: CONFIG_SCHEMA_RESAMPLER,
+        ADF_ELEMENT_LEVEL_METER: CONFIG_SCHEMA_LEVEL_METER,
+        ADF_ELEMENT_OPUS_ENCODER: CONFIG_SCHEMA_OPUS_ENCODER,
+        ADF_ELEMENT_HIGH_PASS: CONFIG_SCHEMA_HIGH_PASS,
+        ADF_ELEMENT_CROSSFADE: CONFIG_SCHEMA_CROSSFADE,
+        ADF_ELEMENT_FILE_SOURCE: CONFIG_SCHEMA_FILE_SOURCE,
+        ADF_ELEMENT_FILE_SINK: CONFIG_SCHEMA_FILE_SINK,
+    },
+    lower=True,
+    space="-",
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    if config["type"] == ADF_ELEMENT_TONE:
+        for tone in config[CONF_TONES]:
+            cg.add(
+                var.add_tone(
+                    tone[CONF_NAME],
+                    tone[CONF_ATTACK].total_milliseconds,
+                    tone[CONF_RELEASE].total_milliseconds,
+                )
+            )
+            for step in tone[CONF_STEPS]:
+                freq = step[CONF_FREQUENCY]
+                cg.add(
+                    var.add_tone_step(
+                        freq,
+                        step.get(CONF_TO_FREQUENCY, freq),
+                        step[CONF_DURATION].total_milliseconds,
+                        int(step[CONF_AMPLITUDE] * 32767),
+                    )
+                )
+
+    elif config["type"] == ADF_ELEMENT_EQUALIZER:
+        for band in config[CONF_BANDS]:
+            cg.add(
+                var.add_band(
+                    band[CONF_TYPE], band[CONF_FREQUENCY], band[CONF_GAIN], band[CONF_Q]
+                )
+            )
+
+    elif config["type"] == ADF_ELEMENT_GAIN:
+        cg.add(var.set_gain_db(config[CONF_GAIN]))
+        cg.add(var.set_ramp_time(config[CONF_RAMP_TIME].total_milliseconds))
+        if CONF_NORMALIZATION in config:
+            norm = config[CONF_NORMALIZATION]
+            cg.add(
+                var.set_normalization(
+                    norm[CONF_TARGET_LOUDNESS],
+                    norm[CONF_MAX_GAIN],
+                    norm[CONF_ADJUST_TIME].total_milliseconds,
+                )
+            )
+
+    elif config["type"] == ADF_ELEMENT_COMPRESSOR:
+        cg.add(var.set_threshold_db(config[CONF_THRESHOLD]))
+        if config[CONF_MODE] == "limiter":
+            cg.add(var.set_ratio(0))
+        else:
+            cg.add(var.set_ratio(config[CONF_RATIO]))
+        cg.add(var.set_attack_time(config[CONF_ATTACK].total_milliseconds))
+        cg.add(var.set_release_time(config[CONF_RELEASE].total_milliseconds))
+        cg.add(var.set_lookahead_time(config[CONF_LOOKAHEAD].total_milliseconds))
+        cg.add(var.set_makeup_gain_db(config[CONF_MAKEUP_GAIN]))
+        cg.add(var.set_bypass(config[CONF_BYPASS]))
+
+    elif config["type"] == ADF_ELEMENT_AEC:
+        cg.add(var.set_mode(config[CONF_MODE]))
+        cg.add(var.set_filter_length(config[CONF_FILTER_LENGTH]))
+        cg.add(var.set_mic_channel(config[CONF_MIC_CHANNEL]))
+        cg.add(var.set_task_core(config[CONF_TASK_CORE]))
+        cg.add(var.set_task_priority(config[CONF_TASK_PRIORITY]))
+        cg.add(var.set_task_stack_size(config[CONF_TASK_STACK_SIZE]))
+        playback = await cg.get_variable(config[CONF_PLAYBACK])
+        cg.add(playback.set_echo_reference(var.get_echo_reference()))
+        capture = await cg.get_variable(config[CONF_CAPTURE])
+        cg.add(capture.set_echo_reference(var.get_echo_reference()))
+
+    elif config["type"] == ADF_ELEMENT_NOISE_SUPPRESSION:
+        cg.add(var.set_noise_suppression_level(config[CONF_NOISE_SUPPRESSION_LEVEL]))
+        cg.add(var.set_auto_gain(config[CONF_AUTO_GAIN]))
+        cg.add(var.set_max_gain(config[CONF_MAX_GAIN]))
+        cg.add(var.set_mic_channel(config[CONF_MIC_CHANNEL]))
+
+    elif config["type"] == ADF_ELEMENT_CHANNEL_MIXER:
+        cg.add(var.set_mode(CHANNEL_MIX_MODES[config[CONF_MODE]]))
+        if CONF_MAP in config:
+            cg.add(var.set_map(config[CONF_MAP]))
+
+    elif config["type"] == ADF_ELEMENT_BIT_DEPTH_CONVERTER:
+        cg.add(var.set_bits_per_sample(int(config[CONF_BITS_PER_SAMPLE])))
+        cg.add(var.set_gain_log2(config[CONF_GAIN_LOG_2]))
+        if CONF_HIGH_PASS in config:
+            cg.add(var.set_high_pass(*esp_adf.high_pass_args(config[CONF_HIGH_PASS])))
+
+    elif config["type"] == ADF_ELEMENT_BEAMFORMER:
+        if CONF_MIC_CHANNELS in config:
+            cg.add(var.set_mic_channels(config[CONF_MIC_CHANNELS]))
+        cg.add(var.set_max_mic_distance(config[CONF_MAX_MIC_DISTANCE]))
+
+    elif config["type"] == ADF_ELEMENT_WAKE_WORD:
+        esp32.add_idf_sdkconfig_option("CONFIG_USE_WAKENET", True)
+        esp32.add_idf_sdkconfig_option(f"CONFIG_SR_WN_{config[CONF_MODEL].upper()}", True)
+        cg.add(var.set_model(config[CONF_MODEL]))
+        cg.add(var.set_model_partition(config[CONF_MODEL_PARTITION]))
+        cg.add(var.set_detection_mode(config[CONF_DETECTION_MODE]))
+        cg.add(var.set_mic_channel(config[CONF_MIC_CHANNEL]))
+        if CONF_VOICE_ASSISTANT in config:
+            va = await cg.get_variable(config[CONF_VOICE_ASSISTANT])
+            cg.add(va.set_local_wake_word(True))
+            cg.add(va.set_wake_word_pre_roll(config[CONF_PRE_ROLL].total_milliseconds))
+            cg.add(
+                var.add_on_wake_word_detected_callback(
+                    cg.LambdaExpression(
+                        f"{va}->on_wake_word_detected(wake_word);",
+                        [(cg.std_string.operator("const").operator("ref"), "wake_word")],
+                    )
+                )
+            )
+        for conf in config.get(CONF_ON_WAKE_WORD_DETECTED, []):
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+            await automation.build_automation(
+                trigger, [(cg.std_string, "wake_word")], conf
+            )
+
+    elif config["type"] == ADF_ELEMENT_RESAMPLER:
+        cg.add(var.set_quality(config[CONF_QUALITY]))
+
+    elif config["type"] == ADF_ELEMENT_LEVEL_METER:
+        if CONF_RMS in config:
+            sens = await sensor.new_sensor(config[CONF_RMS])
+            cg.add(var.set_rms_sensor(sens))
+        if CONF_PEAK in config:
+            sens = await sensor.new_sensor(config[CONF_PEAK])
+            cg.add(var.set_peak_sensor(sens))
+        for band in config.get(CONF_BANDS, []):
+            sens = await sensor.new_sensor(band)
+            cg.add(var.add_band(band[CONF_FROM], band[CONF_TO], sens))
+
+    elif config["type"] == ADF_ELEMENT_OPUS_ENCODER:
+        cg.add_define("USE_ADF_OPUS_ENCODER")
+        frame_duration = config[CONF_FRAME_DURATION].total_milliseconds
+        cg.add(var.set_bitrate(config[CONF_BITRATE]))
+        cg.add(var.set_complexity(config[CONF_COMPLEXITY]))
+        cg.add(var.set_frame_duration(frame_duration))
+        if CONF_VOICE_ASSISTANT in config:
+            va = await cg.get_variable(config[CONF_VOICE_ASSISTANT])
+            cg.add(va.set_opus_frame_duration(frame_duration))
+            cg.add(
+                va.add_on_opus_audio_callback(
+                    cg.LambdaExpression(
+                        f"{var}->set_enabled(opus);", [(cg.bool_, "opus")]
+                    )
+                )
+            )
+
+    elif config["type"] == ADF_ELEMENT_HIGH_PASS:
+        dc_blocker, frequency = esp_adf.high_pass_args(config)
+        cg.add(var.set_dc_blocker(dc_blocker))
+        cg.add(var.set_frequency(frequency))
+
+    elif config["type"] == ADF_ELEMENT_CROSSFADE:
+        cg.add(var.set_duration(config[CONF_DURATION].total_milliseconds))
+
+    elif config["type"] == ADF_ELEMENT_FILE_SOURCE:
+        cg.add(var.set_path(config[CONF_PATH]))
+        cg.add(var.set_file_format(config[CONF_FORMAT]))
+        cg.add(
+            var.set_raw_format(
+                config[CONF_SAMPLE_RATE],
+                int(config[CONF_BITS_PER_SAMPLE]),
+                config[CONF_CHANNELS],
+            )
+        )
+        cg.add(var.set_buffer_size(config[CONF_BUFFER_SIZE]))
+
+    elif config["type"] == ADF_ELEMENT_FILE_SINK:
+        cg.add(var.set_path(config[CONF_PATH]))
+        cg.add(var.set_file_format(config[CONF_FORMAT]))
+        if CONF_SAMPLE_RATE in config:
+            cg.add(var.set_sample_rate(config[CONF_SAMPLE_RATE]))
+        if CONF_BITS_PER_SAMPLE in config:
+            cg.add(var.set_bits_per_sample(int(config[CONF_BITS_PER_SAMPLE])))
+        if CONF_CHANNELS in config:
+            cg.add(var.set_channels(config[CONF_CHANNELS]))
+        cg.add(var.set_buffer_size(config[CONF_BUFFER_SIZE]))
+
+
+@register_action(
+    "adf_elements.play_tone",
+    PlayToneAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(ADFToneSource),
+            cv.Required(CONF_TONE): cv.templatable(cv.string),
+        }
+    ),
+)
+async def adf_elements_play_tone_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    templ = await cg.templatable(config[CONF_TONE], args, cg.std_string)
+    cg.add(var.set_tone(templ))
+    return var
+
+
+@register_action(
+    "adf_elements.play_file",
+    PlayFileAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(ADFFileSource),
+            cv.Optional(CONF_PATH, default=""): cv.templatable(cv.string),
+        }
+    ),
+)
+async def adf_elements_play_file_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    templ = await cg.templatable(config[CONF_PATH], args, cg.std_string)
+    cg.add(var.set_path(templ))
+    return var
+
+
+@register_action(
+    "adf_elements.record_file",
+    RecordFileAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(ADFFileSink),
+            cv.Optional(CONF_PATH, default=""): cv.templatable(cv.string),
+        }
+    ),
+)
+async def adf_elements_record_file_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    templ = await cg.templatable(config[CONF_PATH], args, cg.std_string)
+    cg.add(var.set_path(templ))
+    return var
+
+
+@register_action(
+    "adf_elements.stop_recording",
+    StopRecordingAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(ADFFileSink),
+        }
+    ),
+)
+async def adf_elements_stop_recording_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
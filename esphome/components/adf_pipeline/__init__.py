@@ -11,6 +11,7 @@ from esphome.core import coroutine_with_priority, ID
 
 
 CODEOWNERS = ["@gnumpi"]
+AUTO_LOAD = ["audio_kernels"]
 DEPENDENCIES = []
 
 IS_PLATFORM_COMPONENT = True
@@ -18,6 +19,8 @@ IS_PLATFORM_COMPONENT = True
 CONF_ADF_COMPONENT_TYPE = "type"
 CONF_ADF_PIPELINE = "pipeline"
 CONF_ADF_KEEP_PIPELINE_ALIVE = "keep_pipeline_alive"
+CONF_DC_BLOCKER = "dc_blocker"
+CONF_FREQUENCY = "frequency"
 
 esp_adf_ns = cg.esphome_ns.namespace("esp_adf")
 ADFPipelineController = esp_adf_ns.class_("ADFPipelineController")
@@ -27,7 +30,28 @@ ADFPipelineSink = esp_adf_ns.class_("ADFPipelineSinkElement", ADFPipelineElement
 ADFPipelineSource = esp_adf_ns.class_("ADFPipelineSourceElement", ADFPipelineElement)
 ADFPipelineProcess = esp_adf_ns.class_("ADFPipelineProcessElement", ADFPipelineElement)
 
-BUILT_IN_AUDIO_ELEMENT_IDS = ["resampler"]
+ADFResampler = esp_adf_ns.class_(
+    "ADFResampler", ADFPipelineProcess, ADFPipelineElement, cg.Component
+)
+ADFGain = esp_adf_ns.class_("ADFGain", ADFPipelineProcess, ADFPipelineElement)
+ADFChannelMixer = esp_adf_ns.class_(
+    "ADFChannelMixer", ADFPipelineProcess, ADFPipelineElement
+)
+ADFBitDepthConverter = esp_adf_ns.class_(
+    "ADFBitDepthConverter", ADFPipelineProcess, ADFPipelineElement
+)
+ADFCrossfade = esp_adf_ns.class_(
+    "ADFCrossfade", ADFPipelineProcess, ADFPipelineElement, cg.Component
+)
+
+# elements which can be added to a pipeline by name, without declaring them
+BUILT_IN_AUDIO_ELEMENTS = {
+    "resampler": ADFResampler,
+    "volume": ADFGain,
+    "channel_mixer": ADFChannelMixer,
+    "bit_depth_converter": ADFBitDepthConverter,
+}
+BUILT_IN_AUDIO_ELEMENT_IDS = list(BUILT_IN_AUDIO_ELEMENTS)
 
 # Pipeline Controller
 
@@ -48,8 +72,6 @@ ADF_PIPELINE_CONTROLLER_SCHEMA = cv.Schema(
     }
 )
 
-ADFResampler = esp_adf_ns.class_("ADFResampler", ADFPipelineProcess, ADFPipelineElement)
-
 
 async def setup_pipeline_controller(cntrl, config: dict) -> None:
     """Set controller parameter and register elements to pipeline."""
@@ -62,9 +84,9 @@ async def setup_pipeline_controller(cntrl, config: dict) -> None:
                 cg.add(cntrl.append_own_elements())
             elif comp_id in BUILT_IN_AUDIO_ELEMENT_IDS:
                 element_id = ID(
-                    cv.validate_id_name(config[CONF_ID].id + "_resampler"),
+                    cv.validate_id_name(config[CONF_ID].id + "_" + comp_id),
                     is_declaration=True,
-                    type=ADFResampler,
+                    type=BUILT_IN_AUDIO_ELEMENTS[comp_id],
                 )
                 comp = cg.new_Pvariable(element_id)
                 cg.add(cntrl.add_element_to_pipeline(comp))
@@ -77,11 +99,18 @@ async def setup_pipeline_controller(cntrl, config: dict) -> None:
 
 ADF_PIPELINE_ELEMENT_SCHEMA = cv.Schema({})
 
-element_classes = {
-    "resampler": esp_adf_ns.class_(
-        "ADFResampler", ADFPipelineProcess, ADFPipelineElement
-    )
-}
+# DC blocker and optional high-pass, see HighPassFilter
+HIGH_PASS_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_DC_BLOCKER, default=True): cv.boolean,
+        cv.Optional(CONF_FREQUENCY): cv.All(cv.frequency, cv.Range(min=20, max=1000)),
+    }
+)
+
+
+def high_pass_args(config: dict) -> tuple:
+    """Arguments of set_high_pass for a validated HIGH_PASS_SCHEMA."""
+    return config[CONF_DC_BLOCKER], config.get(CONF_FREQUENCY, 0.0)
 
 
 @coroutine_with_priority(55.0)
@@ -0,0 +1,334 @@
+#include "adf_aec.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <esp_cpu.h>
+#include <esp_timer.h>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_aec";
+
+// reference history, needs to cover the driver queues and the echo path
+static const size_t REF_BUFFER_FRAMES = AEC_SAMPLE_RATE / 2;
+// playback frames mixed down and resampled at a time
+static const size_t REF_BLOCK_FRAMES = 256;
+// playback is considered stopped if the sink didn't write for this long
+static const int64_t PLAYBACK_GAP_US = 200000;
+
+// delay estimation, all values in frames at 16 kHz
+static const size_t EST_WINDOW = 1024;
+static const int32_t EST_MIN_LAG = -80;
+static const int32_t EST_MAX_LAG = 480;
+static const uint32_t EST_INTERVAL_CHUNKS = 64;
+// mean absolute reference level required for an estimation
+static const int32_t EST_MIN_LEVEL = 64;
+// correlation peak vs. mean absolute correlation
+static const int64_t EST_MIN_CONFIDENCE = 4;
+
+EchoReference::EchoReference() : buffer_(REF_BUFFER_FRAMES, 0) {}
+
+void EchoReference::on_playback(const uint8_t *data, size_t len, const pcm_format &format, uint32_t queued_frames) {
+  if (format.channels == 0 || format.rate == 0) {
+    return;
+  }
+  const int64_t now = esp_timer_get_time();
+  const size_t num_frames = len / ((format.bits > 16 ? 4 : 2) * format.channels);
+
+  LockGuard lock(this->lock_);
+  const bool restarted = now - this->last_playback_us_ > PLAYBACK_GAP_US;
+  if (restarted) {
+    this->generation_++;
+  }
+  this->last_playback_us_ = now;
+  if (format.rate != this->resampler_rate_) {
+    this->resampler_rate_ = format.rate;
+    this->resampler_valid_ = format.rate == AEC_SAMPLE_RATE ||
+                             this->resampler_.configure(format.rate, AEC_SAMPLE_RATE, 1, ResampleQuality::LOW,
+                                                        REF_BLOCK_FRAMES);
+    if (!this->resampler_valid_) {
+      esph_log_w(TAG, "No echo reference for playback at %d Hz", format.rate);
+    }
+    this->mono_.resize(REF_BLOCK_FRAMES);
+    this->resampled_.resize(this->resampler_.max_out_frames(REF_BLOCK_FRAMES));
+  } else if (restarted) {
+    this->resampler_.reset();
+  }
+  if (!this->resampler_valid_) {
+    return;
+  }
+
+  for (size_t done = 0; done < num_frames;) {
+    const size_t block = std::min(num_frames - done, REF_BLOCK_FRAMES);
+    for (size_t frame = 0; frame < block; frame++) {
+      int32_t sum = 0;
+      for (int ch = 0; ch < format.channels; ch++) {
+        const size_t idx = (done + frame) * format.channels + ch;
+        sum += format.bits > 16 ? ((const int32_t *) data)[idx] >> 16 : ((const int16_t *) data)[idx];
+      }
+      this->mono_[frame] = (int16_t) (sum / format.channels);
+    }
+    done += block;
+
+    const int16_t *out = this->mono_.data();
+    size_t out_frames = block;
+    if (format.rate != AEC_SAMPLE_RATE) {
+      out_frames = this->resampler_.process(this->mono_.data(), block, this->resampled_.data());
+      out = this->resampled_.data();
+    }
+    for (size_t i = 0; i < out_frames; i++) {
+      this->buffer_[this->written_ % REF_BUFFER_FRAMES] = out[i];
+      this->written_++;
+    }
+  }
+  // the block is played after the frames already queued in the driver
+  this->play_anchor_index_ = this->written_;
+  this->play_anchor_us_ = now + (int64_t) queued_frames * 1000000 / format.rate;
+}
+
+void EchoReference::on_capture(size_t frames) {
+  const int64_t now = esp_timer_get_time();
+  LockGuard lock(this->lock_);
+  this->captured_ += frames;
+  this->capture_anchor_us_ = now;
+}
+
+void EchoReference::reset_capture() {
+  LockGuard lock(this->lock_);
+  this->captured_ = 0;
+  this->capture_anchor_us_ = 0;
+}
+
+bool EchoReference::is_playing() const {
+  const int64_t last = this->last_playback_us_;
+  return last != 0 && esp_timer_get_time() - last < PLAYBACK_GAP_US;
+}
+
+bool EchoReference::get_capture_offset(int64_t &offset) {
+  LockGuard lock(this->lock_);
+  if (this->capture_anchor_us_ == 0 || this->play_anchor_us_ == 0) {
+    return false;
+  }
+  const int64_t played =
+      this->play_anchor_index_ + (this->capture_anchor_us_ - this->play_anchor_us_) * AEC_SAMPLE_RATE / 1000000;
+  offset = played - this->captured_;
+  return true;
+}
+
+void EchoReference::read(int16_t *dst, int64_t first, size_t num) {
+  LockGuard lock(this->lock_);
+  const int64_t oldest = std::max<int64_t>(0, this->written_ - (int64_t) REF_BUFFER_FRAMES);
+  for (size_t i = 0; i < num; i++) {
+    const int64_t idx = first + i;
+    dst[i] = idx >= oldest && idx < this->written_ ? this->buffer_[idx % REF_BUFFER_FRAMES] : 0;
+  }
+}
+
+ADFAEC::ADFAEC() {
+  this->element_tag_ = "aec";
+  // esp-sr needs a large stack, keep it in internal RAM
+  this->task_stack_ = 8 * 1024;
+  this->task_prio_ = 8;
+  this->task_core_ = 1;
+  this->stack_in_ext_ = false;
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFAEC::dump_config() {
+  esph_log_config(TAG, "AEC:");
+  esph_log_config(TAG, "  mode: %d, filter length: %d", this->mode_, this->filter_length_);
+  esph_log_config(TAG, "  mic channel: %u", this->mic_channel_);
+  esph_log_config(TAG, "  task: core %d, priority %d, stack %d", this->task_core_, this->task_prio_,
+                  this->task_stack_);
+}
+
+void ADFAEC::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFAEC::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->active_ = in_format.rate == AEC_SAMPLE_RATE;
+  if (!this->active_) {
+    esph_log_w(TAG, "AEC requires %u Hz, got %d Hz, passing through", AEC_SAMPLE_RATE, in_format.rate);
+    return true;
+  }
+  if (this->aec_handle_ == nullptr) {
+    this->aec_handle_ = aec_create(AEC_SAMPLE_RATE, this->filter_length_, 1, this->mode_);
+    if (this->aec_handle_ == nullptr) {
+      esph_log_e(TAG, "Couldn't create AEC instance");
+      return false;
+    }
+    this->chunk_size_ = aec_get_chunksize(this->aec_handle_);
+    this->mic_chunk_.assign(this->chunk_size_, 0);
+    this->ref_chunk_.assign(this->chunk_size_, 0);
+    this->out_chunk_.assign(this->chunk_size_, 0);
+    this->mic_history_.assign(EST_WINDOW, 0);
+    this->est_ref_.assign(EST_WINDOW + EST_MAX_LAG - EST_MIN_LAG, 0);
+  }
+  this->chunk_pos_ = 0;
+  std::fill(this->out_chunk_.begin(), this->out_chunk_.end(), 0);
+  return true;
+}
+
+esp_err_t ADFAEC::open_() {
+  this->capture_index_ = 0;
+  this->chunk_pos_ = 0;
+  this->offset_valid_ = false;
+  this->history_len_ = 0;
+  this->chunks_since_estimate_ = 0;
+  this->aec_cycles_ = 0;
+  this->aec_chunks_ = 0;
+  this->estimate_cycles_ = 0;
+  return ESP_OK;
+}
+
+esp_err_t ADFAEC::close_() {
+  if (this->aec_chunks_ > 0) {
+    esph_log_d(TAG, "Cancelled %llu chunks, %u cycles per chunk, %u cycles for delay estimation, delay: %d frames",
+               this->aec_chunks_, (uint32_t) (this->aec_cycles_ / this->aec_chunks_), this->estimate_cycles_,
+               (int) this->delay_);
+  }
+  this->destroy_aec_();
+  return ESP_OK;
+}
+
+void ADFAEC::destroy_aec_() {
+  if (this->aec_handle_ != nullptr) {
+    aec_destroy(this->aec_handle_);
+    this->aec_handle_ = nullptr;
+  }
+}
+
+template<typename T> void ADFAEC::process_frames_(T *samples, size_t num_frames) {
+  const int channels = this->in_format_.channels;
+  const int mic_channel = std::min<int>(this->mic_channel_, channels - 1);
+  const int shift = sizeof(T) > 2 ? 16 : 0;
+  for (size_t frame = 0; frame < num_frames; frame++) {
+    T *samples_in_frame = samples + frame * channels;
+    this->mic_chunk_[this->chunk_pos_] = (int16_t) (samples_in_frame[mic_channel] >> shift);
+    const T out = (T) this->out_chunk_[this->chunk_pos_] << shift;
+    for (int ch = 0; ch < channels; ch++) {
+      samples_in_frame[ch] = out;
+    }
+    if (++this->chunk_pos_ == this->chunk_size_) {
+      this->process_chunk_();
+      this->chunk_pos_ = 0;
+    }
+  }
+}
+
+void ADFAEC::process_chunk_() {
+  const int64_t first = this->capture_index_;
+  this->capture_index_ += this->chunk_size_;
+
+  // keep the most recent capture frames for the delay estimation
+  const size_t keep = EST_WINDOW - this->chunk_size_;
+  std::memmove(this->mic_history_.data(), this->mic_history_.data() + this->chunk_size_, keep * sizeof(int16_t));
+  std::memcpy(this->mic_history_.data() + keep, this->mic_chunk_.data(), this->chunk_size_ * sizeof(int16_t));
+  this->history_len_ = std::min(EST_WINDOW, this->history_len_ + this->chunk_size_);
+
+  if (!this->reference_.is_playing()) {
+    this->offset_valid_ = false;
+    std::memcpy(this->out_chunk_.data(), this->mic_chunk_.data(), this->chunk_size_ * sizeof(int16_t));
+    return;
+  }
+  const uint32_t generation = this->reference_.get_generation();
+  if (!this->offset_valid_ || generation != this->locked_generation_) {
+    // realign once per playback session, the time stamps are too jittery to follow them per chunk
+    this->offset_valid_ = this->reference_.get_capture_offset(this->offset_);
+    this->locked_generation_ = generation;
+    if (!this->offset_valid_) {
+      std::memcpy(this->out_chunk_.data(), this->mic_chunk_.data(), this->chunk_size_ * sizeof(int16_t));
+      return;
+    }
+    esph_log_d(TAG, "Aligned to playback, offset: %lld frames", (long long) this->offset_);
+  }
+
+  this->reference_.read(this->ref_chunk_.data(), first + this->offset_ - this->delay_, this->chunk_size_);
+  const uint32_t start = esp_cpu_get_ccount();
+  aec_process(this->aec_handle_, this->mic_chunk_.data(), this->ref_chunk_.data(), this->out_chunk_.data());
+  this->aec_cycles_ += esp_cpu_get_ccount() - start;
+  this->aec_chunks_++;
+
+  if (++this->chunks_since_estimate_ >= EST_INTERVAL_CHUNKS && this->history_len_ == EST_WINDOW) {
+    this->chunks_since_estimate_ = 0;
+    this->estimate_delay_();
+  }
+}
+
+void ADFAEC::estimate_delay_() {
+  const uint32_t start = esp_cpu_get_ccount();
+  // est_ref_[i] holds the reference for mic_history_[i] at the largest lag
+  const int64_t history_start = this->capture_index_ - EST_WINDOW;
+  this->reference_.read(this->est_ref_.data(), history_start + this->offset_ - EST_MAX_LAG, this->est_ref_.size());
+
+  int64_t level = 0;
+  for (size_t i = EST_MAX_LAG; i < EST_MAX_LAG + EST_WINDOW; i++) {
+    level += std::abs(this->est_ref_[i]);
+  }
+  if (level < (int64_t) (EST_MIN_LEVEL * EST_WINDOW)) {
+    return;
+  }
+
+  int64_t best = 0;
+  int64_t sum = 0;
+  int32_t best_lag = 0;
+  for (int32_t lag = EST_MIN_LAG; lag < EST_MAX_LAG; lag++) {
+    const int16_t *ref = this->est_ref_.data() + (EST_MAX_LAG - lag);
+    int64_t corr = 0;
+    for (size_t i = 0; i < EST_WINDOW; i++) {
+      corr += (int32_t) this->mic_history_[i] * ref[i];
+    }
+    corr = corr < 0 ? -corr : corr;
+    sum += corr;
+    if (corr > best) {
+      best = corr;
+      best_lag = lag;
+    }
+  }
+  this->estimate_cycles_ = esp_cpu_get_ccount() - start;
+
+  const int64_t mean = sum / (EST_MAX_LAG - EST_MIN_LAG);
+  if (best < EST_MIN_CONFIDENCE * mean) {
+    return;
+  }
+  // only follow a new delay after it has been confirmed by a second estimation
+  if (best_lag == this->delay_candidate_ && best_lag != this->delay_) {
+    esph_log_d(TAG, "Echo path delay: %d frames", best_lag);
+    this->delay_ = best_lag;
+  }
+  this->delay_candidate_ = best_lag;
+}
+
+int ADFAEC::process_pcm_(uint8_t *data, int len) {
+  if (!this->active_ || this->aec_handle_ == nullptr) {
+    return len;
+  }
+  if (this->in_format_.bits == 16) {
+    this->process_frames_<int16_t>((int16_t *) data, len / (sizeof(int16_t) * this->in_format_.channels));
+  } else {
+    this->process_frames_<int32_t>((int32_t *) data, len / (sizeof(int32_t) * this->in_format_.channels));
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+#include "adf_audio_process.h"
+
+#include <esp_aec.h>
+
+namespace esphome {
+namespace esp_adf {
+
+// the esp-sr echo canceller works on 16 kHz, 16 bit mono
+static const uint32_t AEC_SAMPLE_RATE = 16000;
+
+/*
+Reference signal shared between a playback sink, a capture source and the echo canceller.
+The sink passes every block it hands over to the driver, the samples are mixed down to mono,
+converted to 16 kHz by a polyphase resampler and buffered. The source reports the number of captured frames. Both sides are time stamped,
+which gives the coarse position of the reference relative to the capture stream. Sinks and sources
+call in from their own tasks.
+*/
+class EchoReference {
+ public:
+  EchoReference();
+
+  // queued_frames: frames buffered by the driver in front of the just written block
+  void on_playback(const uint8_t *data, size_t len, const pcm_format &format, uint32_t queued_frames);
+  void on_capture(size_t frames);
+  void reset_capture();
+
+  bool is_playing() const;
+  // incremented each time playback starts after a pause
+  uint32_t get_generation() const { return this->generation_; }
+
+  // reference index played while capture frame 0 was recorded, false if unknown
+  bool get_capture_offset(int64_t &offset);
+  // copies reference samples [first, first + num), zeros where no reference is available
+  void read(int16_t *dst, int64_t first, size_t num);
+
+ protected:
+  Mutex lock_;
+  std::vector<int16_t> buffer_;
+  int64_t written_{0};
+  // playback rate to 16 kHz, the low quality tier is good enough for a reference
+  PolyphaseResampler resampler_;
+  int resampler_rate_{0};
+  bool resampler_valid_{false};
+  std::vector<int16_t> mono_;
+  std::vector<int16_t> resampled_;
+  std::atomic<uint32_t> generation_{0};
+  std::atomic<int64_t> last_playback_us_{0};
+
+  // reference index played at play_anchor_us_
+  int64_t play_anchor_index_{0};
+  int64_t play_anchor_us_{0};
+  // capture frame recorded at capture_anchor_us_
+  int64_t captured_{0};
+  int64_t capture_anchor_us_{0};
+};
+
+/*
+Acoustic echo canceller based on the esp-sr AEC.
+Removes the signal played by the linked playback sink from the capture stream. The coarse alignment
+is taken from the time stamps of the EchoReference, the remaining echo path delay is estimated
+sample-accurately by cross-correlating the capture with the reference while audio is playing.
+Processes one channel of 16 kHz streams, the result is written to all channels.
+The output is delayed by one AEC chunk.
+*/
+class ADFAEC : public ADFPCMProcessElement, public Component {
+ public:
+  ADFAEC();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "AEC"; }
+
+  EchoReference *get_echo_reference() { return &this->reference_; }
+
+  void set_mode(aec_mode_t mode) { this->mode_ = mode; }
+  void set_filter_length(int filter_length) { this->filter_length_ = filter_length; }
+  void set_mic_channel(uint8_t mic_channel) { this->mic_channel_ = mic_channel; }
+
+  // estimated echo path delay in frames
+  int32_t get_delay() const { return this->delay_; }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  esp_err_t open_() override;
+  esp_err_t close_() override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  template<typename T> void process_frames_(T *samples, size_t num_frames);
+  void process_chunk_();
+  void estimate_delay_();
+  void destroy_aec_();
+
+  EchoReference reference_;
+  aec_mode_t mode_{AEC_MODE_SR_LOW_COST};
+  int filter_length_{4};
+  uint8_t mic_channel_{0};
+  pcm_format format_{16000, 16, 2};
+  std::atomic<int32_t> delay_{0};
+
+  // only accessed from the element's task
+  aec_handle_t *aec_handle_{nullptr};
+  bool active_{false};
+  size_t chunk_size_{0};
+  size_t chunk_pos_{0};
+  std::vector<int16_t> mic_chunk_;
+  std::vector<int16_t> ref_chunk_;
+  std::vector<int16_t> out_chunk_;
+
+  // capture index of mic_chunk_[0]
+  int64_t capture_index_{0};
+  int64_t offset_{0};
+  bool offset_valid_{false};
+  uint32_t locked_generation_{0};
+
+  // delay estimation
+  std::vector<int16_t> mic_history_;
+  std::vector<int16_t> est_ref_;
+  size_t history_len_{0};
+  uint32_t chunks_since_estimate_{0};
+  int32_t delay_candidate_{INT32_MIN};
+
+  uint64_t aec_cycles_{0};
+  uint64_t aec_chunks_{0};
+  uint32_t estimate_cycles_{0};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
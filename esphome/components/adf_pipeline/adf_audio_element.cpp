@@ -3,6 +3,16 @@
 namespace esphome {
 namespace esp_adf {
 
+float volume_to_db(float volume) {
+  if (volume >= 1.f) {
+    return 0.f;
+  }
+  if (volume <= 0.f) {
+    return -VOLUME_RANGE_DB;
+  }
+  return (volume - 1.f) * VOLUME_RANGE_DB;
+}
+
 std::string ADFPipelineElement::get_adf_element_tag(int element_indx) {
   if (element_indx >= 0 && element_indx < this->sdk_element_tags_.size()) {
     return this->sdk_element_tags_[element_indx];
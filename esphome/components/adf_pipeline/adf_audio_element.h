@@ -5,6 +5,7 @@
 
 #include <audio_element.h>
 #include <audio_pipeline.h>
+#include <cmath>
 #include <vector>
 
 namespace esphome {
@@ -16,6 +17,15 @@ typedef struct {
   int channels;
 } pcm_format;
 
+// properties of a pcm_format, combined to a bit mask
+enum PCMFormatProperty : uint8_t { PCM_RATE = 1 << 0, PCM_BITS = 1 << 1, PCM_CHANNELS = 1 << 2 };
+
+
+// volume requests cover this range, linear in dB, with 0 dB at full volume
+static const float VOLUME_RANGE_DB = 48.f;
+
+// maps a volume in [0, 1] to an attenuation in dB (<= 0), a volume of 0 is meant to be muted
+float volume_to_db(float volume);
 
 enum class PipelineElementState : uint8_t { UNINITIALIZED = 0, INITIALIZED, PREPARE, PREPARING, WAIT_FOR_PREPARATION_DONE, READY };
 
@@ -37,7 +47,10 @@ class AudioPipelineSettingsRequest {
   int final_sampling_rate{-1};
   int final_bit_depth{-1};
   int final_number_of_channels{-1};
+  // set by sinks which apply target_volume and mute in hardware, software gain stages stay at unity then
   float final_volume{-1.};
+  // ReplayGain 2.0 track gain in dB (to -18 LUFS) announced by a source with the stream format, NAN if unknown
+  float track_gain_db{NAN};
 
   bool failed{false};
   int error_code{0};
@@ -70,6 +83,16 @@ class ADFPipelineElement {
   void set_pipeline(ADFPipeline *pipeline) { pipeline_ = pipeline; }
   virtual bool is_ready() {return true;}
   virtual bool requires_destruction_on_stop(){ return false; }
+  // set while the element restarts its ADF elements, their state changes don't affect the pipeline then
+  virtual bool is_restarting() const { return false; }
+  // PCMFormatProperty mask of the properties the element converts into the final format requested by the sink
+  virtual uint8_t converts_format() const { return 0; }
+
+  // called in stream order once a settings request has passed all elements, next is the following element.
+  // returns true if the request changed the element's format and it tells next where its new format starts
+  virtual bool on_settings_request_done(ADFPipelineElement *next, bool upstream_switches) { return false; }
+  // called from the previous element's task, its output in the new format starts at this input position
+  virtual void on_upstream_format_switch(uint32_t input_pos) {}
 
  protected:
   friend class ADFPipeline;
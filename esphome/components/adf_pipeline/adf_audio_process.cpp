@@ -4,6 +4,10 @@
 #ifdef USE_ESP_IDF
 #include "adf_pipeline.h"
 
+#include <algorithm>
+#include <cstring>
+#include <esp_cpu.h>
+#include <esp_timer.h>
 #include <filter_resample.h>
 
 namespace esphome {
@@ -11,44 +15,273 @@ namespace esp_adf {
 
 static const char *const TAG = "esp_audio_processors";
 
-typedef struct rsp_filter {
-    resample_info_t *resample_info;
-    unsigned char *out_buf;
-    unsigned char *in_buf;
-    void *rsp_hd;
-    int in_offset;
-    int8_t flag;  //the flag must be 0 or 1. 1 means the parameter in `resample_info_t` changed. 0 means the parameter in `resample_info_t` is original.
-} rsp_filter_t;
-
-
-bool ADFResampler::init_adf_elements_(){
-    rsp_filter_cfg_t rsp_cfg = {
-      .src_rate = this->src_rate_,
-      .src_ch = this->src_num_channels_,
-      .dest_rate = this->dst_rate_,
-      .dest_bits = 16,
-      .dest_ch = this->dst_num_channels_,
-      .src_bits = 16,
-      .mode = RESAMPLE_DECODE_MODE,
-      .max_indata_bytes = RSP_FILTER_BUFFER_BYTE,
-      .out_len_bytes = RSP_FILTER_BUFFER_BYTE,
-      .type = ESP_RESAMPLE_TYPE_AUTO,
-      .complexity = 2,
-      .down_ch_idx = 0,
-      .prefer_flag = ESP_RSP_PREFER_TYPE_SPEED,
-      .out_rb_size = RSP_FILTER_RINGBUFFER_SIZE,
-      .task_stack = RSP_FILTER_TASK_STACK,
-      .task_core = RSP_FILTER_TASK_CORE,
-      .task_prio = RSP_FILTER_TASK_PRIO,
-      .stack_in_ext = true,
-  };
-  this->sdk_resampler_= rsp_filter_init(&rsp_cfg);
-  sdk_audio_elements_.push_back(this->sdk_resampler_);
-  sdk_element_tags_.push_back("resampler");
+bool ADFPCMProcessElement::init_adf_elements_() {
+  if (this->sdk_audio_elements_.size() > 0)
+    return true;
+
+  audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+  cfg.open = ADFPCMProcessElement::adf_open_;
+  cfg.close = ADFPCMProcessElement::adf_close_;
+  cfg.process = ADFPCMProcessElement::adf_process_;
+  cfg.buffer_len = this->buffer_len_;
+  cfg.out_rb_size = this->out_rb_size_;
+  cfg.task_stack = this->task_stack_;
+  cfg.task_prio = this->task_prio_;
+  cfg.task_core = this->task_core_;
+  cfg.stack_in_ext = this->stack_in_ext_;
+  cfg.tag = this->element_tag_.c_str();
+
+  this->adf_element_ = audio_element_init(&cfg);
+  if (this->adf_element_ == nullptr) {
+    esph_log_e(TAG, "Couldn't create [%s] element.", this->element_tag_.c_str());
+    return false;
+  }
+  audio_element_setdata(this->adf_element_, this);
+
+  this->sdk_audio_elements_.push_back(this->adf_element_);
+  this->sdk_element_tags_.push_back(this->element_tag_);
   return true;
 }
 
+void ADFPCMProcessElement::clear_adf_elements_() {
+  this->adf_element_ = nullptr;
+  this->sdk_audio_elements_.clear();
+  this->sdk_element_tags_.clear();
+}
+
+void ADFPCMProcessElement::request_format_(const pcm_format &in_format, const pcm_format &out_format) {
+  LockGuard lock(this->format_lock_);
+  this->pending_in_format_ = in_format;
+  this->pending_out_format_ = out_format;
+  if (this->pipeline_ != nullptr && this->pipeline_->is_requesting_settings()) {
+    // the switch point is set once the request has passed all elements, see on_settings_request_done
+    this->switch_known_ = false;
+    this->switch_requested_ = true;
+  } else {
+    this->switch_at_ = this->queued_input_end_();
+    this->switch_known_ = true;
+  }
+  this->format_pending_ = true;
+  if (this->adf_element_ != nullptr) {
+    audio_element_set_music_info(this->adf_element_, out_format.rate, out_format.channels, out_format.bits);
+  }
+}
+
+uint32_t ADFPCMProcessElement::queued_input_end_() const {
+  uint32_t pos = this->in_pos_;
+  if (this->adf_element_ != nullptr) {
+    ringbuf_handle_t rb = audio_element_get_input_ringbuf(this->adf_element_);
+    if (rb != nullptr) {
+      pos += rb_bytes_filled(rb);
+    }
+  }
+  // the new format starts at a frame boundary of the old one
+  const uint32_t frame_size = this->bytes_per_frame_(this->in_format_);
+  return pos + (frame_size - pos % frame_size) % frame_size;
+}
+
+bool ADFPCMProcessElement::on_settings_request_done(ADFPipelineElement *next, bool upstream_switches) {
+  LockGuard lock(this->format_lock_);
+  if (!this->switch_requested_) {
+    return false;
+  }
+  this->switch_requested_ = false;
+  if (!upstream_switches) {
+    this->switch_at_ = this->queued_input_end_();
+    this->switch_known_ = true;
+  }
+  // otherwise the previous element tells where its output in the new format starts
+  this->next_ = next;
+  return true;
+}
+
+void ADFPCMProcessElement::on_upstream_format_switch(uint32_t input_pos) {
+  LockGuard lock(this->format_lock_);
+  if (this->format_pending_ && !this->switch_known_) {
+    this->switch_at_ = input_pos;
+    this->switch_known_ = true;
+  }
+}
+
+bool ADFPCMProcessElement::switch_reached_() const {
+  return this->switch_known_ && (int32_t) (this->in_pos_ - this->switch_at_) >= 0;
+}
+
+bool ADFPCMProcessElement::apply_pending_format_(bool reopen) {
+  if (!this->format_pending_) {
+    return true;
+  }
+  if (!reopen && (!this->switch_reached_() || !this->format_switch_ready_())) {
+    return true;
+  }
+  if (!this->format_lock_.try_lock()) {
+    return true;
+  }
+  this->in_format_ = this->pending_in_format_;
+  this->out_format_ = this->pending_out_format_;
+  this->format_pending_ = false;
+  this->switch_known_ = true;
+  ADFPipelineElement *next = this->next_;
+  this->next_ = nullptr;
+  this->format_lock_.unlock();
+
+  // a partial frame of the old format is meaningless with the new one
+  this->carry_len_ = 0;
+
+  const int64_t start = esp_timer_get_time();
+  bool ret = this->on_format_change_(this->in_format_, this->out_format_);
+  this->last_reconfiguration_us_ = (uint32_t) (esp_timer_get_time() - start);
+  esph_log_d(TAG, "[%s] reconfigured in %u us: %d Hz, %d bits, %d ch -> %d Hz, %d bits, %d ch",
+             this->element_tag_.c_str(), this->last_reconfiguration_us_, this->in_format_.rate,
+             this->in_format_.bits, this->in_format_.channels, this->out_format_.rate, this->out_format_.bits,
+             this->out_format_.channels);
+  if (next != nullptr && !reopen) {
+    // everything written so far is in the old format
+    next->on_upstream_format_switch(this->out_pos_);
+  }
+  return ret;
+}
+
+int ADFPCMProcessElement::read_input_(char *buffer, int max_len) {
+  if (this->format_pending_ && this->switch_known_) {
+    const int32_t until_switch = (int32_t) (this->switch_at_ - this->in_pos_);
+    max_len = std::min(max_len, std::max<int32_t>(until_switch, 0));
+    if (max_len == 0) {
+      // waiting for format_switch_ready_, 0 would be taken as the end of the stream
+      return AEL_IO_TIMEOUT;
+    }
+  }
+  const int read = audio_element_input(this->adf_element_, buffer, max_len);
+  if (read > 0) {
+    this->in_pos_ += read;
+  }
+  return read;
+}
+
+int ADFPCMProcessElement::write_output_(const char *buffer, int len) {
+  const int written = audio_element_output(this->adf_element_, (char *) buffer, len);
+  if (written > 0) {
+    this->out_pos_ += written;
+  }
+  return written;
+}
+
+int ADFPCMProcessElement::read_frames_(char *buffer, int max_len, int &read) {
+  const int frame_size = this->bytes_per_frame_(this->in_format_);
+  if (this->carry_len_ > 0) {
+    std::memcpy(buffer, this->carry_, this->carry_len_);
+  }
+  read = this->read_input_(buffer + this->carry_len_, max_len - this->carry_len_);
+  if (read <= 0) {
+    return 0;
+  }
+  const int available = read + this->carry_len_;
+  const int aligned = available - (available % frame_size);
+  this->carry_len_ = available - aligned;
+  if (this->carry_len_ > 0) {
+    std::memcpy(this->carry_, buffer + aligned, this->carry_len_);
+  }
+  return aligned;
+}
+
+int ADFPCMProcessElement::process_(char *buffer, int len) {
+  const int frame_size = this->bytes_per_frame_(this->in_format_);
+  const int out_frame_size = this->bytes_per_frame_(this->out_format_);
+  const int max_in = out_frame_size > frame_size ? std::max(frame_size, len / out_frame_size * frame_size) : len;
+  int read = 0;
+  const int aligned = this->read_frames_(buffer, max_in, read);
+  if (aligned == 0) {
+    return read;
+  }
+
+  const uint32_t start = esp_cpu_get_ccount();
+  const int out_len = this->process_pcm_((uint8_t *) buffer, aligned);
+  this->process_cycles_ += esp_cpu_get_ccount() - start;
+  this->processed_frames_ += aligned / frame_size;
+  if (out_len <= 0) {
+    return read;
+  }
+  return this->write_output_(buffer, out_len);
+}
+
+esp_err_t ADFPCMProcessElement::adf_open_(audio_element_handle_t self) {
+  ADFPCMProcessElement *this_ = (ADFPCMProcessElement *) audio_element_getdata(self);
+  this_->carry_len_ = 0;
+  this_->in_pos_ = 0;
+  this_->out_pos_ = 0;
+  this_->process_cycles_ = 0;
+  this_->processed_frames_ = 0;
+  if (!this_->apply_pending_format_(true)) {
+    return ESP_FAIL;
+  }
+  return this_->open_();
+}
+
+esp_err_t ADFPCMProcessElement::adf_close_(audio_element_handle_t self) {
+  ADFPCMProcessElement *this_ = (ADFPCMProcessElement *) audio_element_getdata(self);
+  esp_err_t ret = this_->close_();
+  if (this_->processed_frames_ > 0) {
+    esph_log_v(TAG, "[%s] processed %llu frames, %u cycles per frame", this_->element_tag_.c_str(),
+               this_->processed_frames_, this_->get_cycles_per_frame());
+  }
+  // make sure the current format is applied again when reopened
+  LockGuard lock(this_->format_lock_);
+  if (!this_->format_pending_) {
+    this_->pending_in_format_ = this_->in_format_;
+    this_->pending_out_format_ = this_->out_format_;
+    this_->format_pending_ = true;
+  }
+  return ret;
+}
+
+audio_element_err_t ADFPCMProcessElement::adf_process_(audio_element_handle_t self, char *buffer, int len) {
+  ADFPCMProcessElement *this_ = (ADFPCMProcessElement *) audio_element_getdata(self);
+  if (!this_->apply_pending_format_(false)) {
+    return AEL_PROCESS_FAIL;
+  }
+  return (audio_element_err_t) this_->process_(buffer, len);
+}
+
+
+static const char *quality_to_string(ResampleQuality quality) {
+  switch (quality) {
+    case ResampleQuality::LOW:
+      return "low";
+    case ResampleQuality::MEDIUM:
+      return "medium";
+    case ResampleQuality::HIGH:
+      return "high";
+    case ResampleQuality::ADF:
+    default:
+      return "adf";
+  }
+}
+
+ADFResampler::ADFResampler() {
+  this->element_tag_ = "resampler";
+  this->buffer_len_ = RSP_FILTER_BUFFER_BYTE;
+  this->out_rb_size_ = RSP_FILTER_RINGBUFFER_SIZE;
+  this->task_stack_ = RSP_FILTER_TASK_STACK;
+  this->task_prio_ = RSP_FILTER_TASK_PRIO;
+  this->task_core_ = RSP_FILTER_TASK_CORE;
+  this->in_format_ = {this->src_rate_, 16, this->src_num_channels_};
+  this->out_format_ = {this->dst_rate_, 16, this->dst_num_channels_};
+}
+
+void ADFResampler::dump_config() {
+  esph_log_config(TAG, "Resampler:");
+  esph_log_config(TAG, "  quality: %s", quality_to_string(this->quality_));
+}
+
 void ADFResampler::on_settings_request(AudioPipelineSettingsRequest &request){
+  // both resampling paths work on 16 bit samples, wider streams need a bit depth converter in front
+  const int bits = this->pipeline_->get_format_at(this, request, this->in_format_).bits;
+  if (bits != 16) {
+    esph_log_e(TAG, "Unsupported bit depth: %d bits, only 16 bit streams can be resampled", bits);
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
   bool settings_changed = false;
   if( request.sampling_rate > -1 ){
     if( request.sampling_rate != this->src_rate_ )
@@ -76,23 +309,153 @@ void ADFResampler::on_settings_request(AudioPipelineSettingsRequest &request){
       settings_changed = true;
     }
   }
-  esph_log_d(TAG, "New settings: SRC: rate: %d, ch: %d DST: rate: %d, ch: %d ", this->src_rate_,this->src_num_channels_, this->dst_rate_, this->dst_num_channels_);
 
-  if( this->sdk_resampler_ && settings_changed)
-  {
-    if( audio_element_get_state(this->sdk_resampler_) == AEL_STATE_RUNNING)
-    {
-      audio_element_stop(this->sdk_resampler_);
-      audio_element_wait_for_stop(this->sdk_resampler_);
-    }
-    esph_log_d(TAG, "New settings: SRC: rate: %d, ch: %d DST: rate: %d, ch: %d ", this->src_rate_, this->src_num_channels_, this->dst_rate_, this->dst_num_channels_);
-    rsp_filter_t *filter = (rsp_filter_t *)audio_element_getdata(this->sdk_resampler_);
-    resample_info_t &resample_info = *(filter->resample_info);
-    resample_info.src_rate = this->src_rate_;
-    resample_info.dest_rate = this->dst_rate_;
-    resample_info.src_ch = this->src_num_channels_;
-    resample_info.dest_ch = this->dst_num_channels_;
+  if (settings_changed) {
+    esph_log_d(TAG, "New settings: SRC: rate: %d, ch: %d DST: rate: %d, ch: %d ", this->src_rate_,
+               this->src_num_channels_, this->dst_rate_, this->dst_num_channels_);
+    this->request_format_({this->src_rate_, 16, this->src_num_channels_},
+                          {this->dst_rate_, 16, this->dst_num_channels_});
+  }
+}
+
+bool ADFResampler::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->destroy_resampler_();
+  this->remix_only_ = false;
+  this->polyphase_ = false;
+  // same selection as esp_resample: first channel when mixing down, duplicated when mixing up
+  this->channel_map_.configure(ChannelMixMode::LEFT, {}, in_format.channels, out_format.channels);
+  if (in_format.rate == out_format.rate) {
+    // otherwise nothing to do, pass through
+    this->remix_only_ = in_format.channels != out_format.channels;
+    return true;
+  }
+
+  const int channels = std::min(in_format.channels, out_format.channels);
+  const size_t max_in_frames = this->buffer_len_ / this->bytes_per_frame_(in_format);
+  if (this->polyphase_resampler_.configure(in_format.rate, out_format.rate, channels, this->quality_,
+                                           max_in_frames)) {
+    const size_t max_out_frames = this->polyphase_resampler_.max_out_frames(max_in_frames);
+    this->polyphase_out_.assign(max_out_frames * std::max(in_format.channels, out_format.channels), 0);
+    this->polyphase_ = true;
+    esph_log_d(TAG, "Polyphase resampler: %d phases of %d taps", this->polyphase_resampler_.get_phases(),
+               this->polyphase_resampler_.get_taps());
+    return true;
+  }
+  if (this->quality_ != ResampleQuality::ADF) {
+    esph_log_w(TAG, "Too many phases for %d Hz -> %d Hz, using esp_resample", in_format.rate, out_format.rate);
+  }
+
+  resample_info_t &info = this->rsp_info_;
+  info.src_rate = in_format.rate;
+  info.src_ch = in_format.channels;
+  info.src_bits = 16;
+  info.dest_rate = out_format.rate;
+  info.dest_ch = out_format.channels;
+  info.dest_bits = 16;
+  info.mode = RESAMPLE_DECODE_MODE;
+  info.max_indata_bytes = RSP_FILTER_BUFFER_BYTE;
+  info.out_len_bytes = RSP_FILTER_BUFFER_BYTE;
+  info.type = ESP_RESAMPLE_TYPE_AUTO;
+  info.complexity = 2;
+  info.down_ch_idx = 0;
+  info.prefer_flag = ESP_RSP_PREFER_TYPE_SPEED;
+
+  this->rsp_handle_ = esp_resample_create((void *) &info, &this->rsp_in_buf_, &this->rsp_out_buf_);
+  if (this->rsp_handle_ == nullptr) {
+    esph_log_e(TAG, "Couldn't create resampler for %d Hz, %d ch -> %d Hz, %d ch", in_format.rate,
+               in_format.channels, out_format.rate, out_format.channels);
+    return false;
+  }
+  return true;
+}
+
+void ADFResampler::destroy_resampler_() {
+  if (this->rsp_handle_ != nullptr) {
+    esp_resample_destroy(this->rsp_handle_);
+  }
+  this->rsp_handle_ = nullptr;
+  this->rsp_in_buf_ = nullptr;
+  this->rsp_out_buf_ = nullptr;
+  this->rsp_in_offset_ = 0;
+}
+
+esp_err_t ADFResampler::close_() {
+  this->destroy_resampler_();
+  this->polyphase_resampler_.reset();
+  return ESP_OK;
+}
+
+int ADFResampler::process_pcm_(uint8_t *data, int len) {
+  if (!this->remix_only_) {
+    return len;
+  }
+  const size_t num_frames = len / this->bytes_per_frame_(this->in_format_);
+  this->channel_map_.apply<int16_t>((int16_t *) data, num_frames);
+  return num_frames * this->bytes_per_frame_(this->out_format_);
+}
+
+int ADFResampler::process_polyphase_(char *buffer, int len) {
+  int read = 0;
+  const int aligned = this->read_frames_(buffer, len, read);
+  if (aligned == 0) {
+    return read;
+  }
+  int16_t *in = (int16_t *) buffer;
+  const size_t in_frames = aligned / this->bytes_per_frame_(this->in_format_);
+
+  const uint32_t start = esp_cpu_get_ccount();
+  if (this->out_format_.channels < this->in_format_.channels) {
+    this->channel_map_.apply<int16_t>(in, in_frames);
+  }
+  const size_t out_frames = this->polyphase_resampler_.process(in, in_frames, this->polyphase_out_.data());
+  if (this->out_format_.channels > this->in_format_.channels) {
+    this->channel_map_.apply<int16_t>(this->polyphase_out_.data(), out_frames);
+  }
+  this->process_cycles_ += esp_cpu_get_ccount() - start;
+  this->processed_frames_ += in_frames;
+
+  if (out_frames == 0) {
+    return read;
+  }
+  return this->write_output_((char *) this->polyphase_out_.data(),
+                             out_frames * this->bytes_per_frame_(this->out_format_));
+}
+
+int ADFResampler::process_(char *buffer, int len) {
+  if (this->polyphase_) {
+    return this->process_polyphase_(buffer, len);
+  }
+  if (this->rsp_handle_ == nullptr) {
+    return ADFPCMProcessElement::process_(buffer, len);
+  }
+
+  const int max_in = this->rsp_info_.max_indata_bytes;
+  int read = this->read_input_((char *) this->rsp_in_buf_ + this->rsp_in_offset_, max_in - this->rsp_in_offset_);
+  if (read <= 0) {
+    return read;
+  }
+  this->rsp_in_offset_ += read;
+
+  int out_len = 0;
+  const uint32_t start = esp_cpu_get_ccount();
+  int consumed = esp_resample_run(this->rsp_handle_, (void *) &this->rsp_info_, this->rsp_in_buf_,
+                                  this->rsp_out_buf_, this->rsp_in_offset_, &out_len);
+  this->process_cycles_ += esp_cpu_get_ccount() - start;
+  if (consumed > 0) {
+    this->processed_frames_ += consumed / this->bytes_per_frame_(this->in_format_);
+  }
+  if (consumed < 0) {
+    esph_log_e(TAG, "Resampling failed: %d", consumed);
+    return AEL_PROCESS_FAIL;
+  }
+  this->rsp_in_offset_ -= consumed;
+  if (this->rsp_in_offset_ > 0) {
+    std::memmove(this->rsp_in_buf_, this->rsp_in_buf_ + consumed, this->rsp_in_offset_);
+  }
+  if (out_len <= 0) {
+    return read;
   }
+  return this->write_output_((char *) this->rsp_out_buf_, out_len);
 }
 
 }  // namespace esp_adf
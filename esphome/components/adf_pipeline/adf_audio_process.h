@@ -2,7 +2,17 @@
 
 #ifdef USE_ESP_IDF
 
+#include <atomic>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
 #include "adf_audio_element.h"
+#include "adf_channel_map.h"
+#include "adf_polyphase_resampler.h"
+
+#include <esp_resample.h>
 
 namespace esphome {
 namespace esp_adf {
@@ -12,21 +22,164 @@ class ADFPipelineProcessElement : public ADFPipelineElement {
   AudioPipelineElementType get_element_type() const { return AudioPipelineElementType::AUDIO_PIPELINE_PROCESS; }
 };
 
-class ADFResampler : public ADFPipelineProcessElement {
+/*
+Base class for processing elements implemented within this component.
+Creates a single ADF audio element whose callbacks are forwarded to the virtual methods below.
+
+Format changes are requested from the main loop via request_format_ and are applied by the
+element's task, so the element never needs to be stopped for reconfiguration. They take effect
+in-band: the input queued in the old format is processed with the old settings up to the frame
+where the new format starts. If the element in front of it is an ADFPCMProcessElement switching
+with the same request, that element announces the position, otherwise everything queued at the
+time of the request counts as old format.
+By default, data is processed in place in blocks of complete frames by process_pcm_.
+*/
+class ADFPCMProcessElement : public ADFPipelineProcessElement {
  public:
-  const std::string get_name() override { return "Resampler"; }
+  // last time spent in on_format_change_
+  uint32_t get_last_reconfiguration_us() const { return this->last_reconfiguration_us_; }
+  // average cpu cycles spent per frame since the element was opened
+  uint32_t get_cycles_per_frame() const {
+    return this->processed_frames_ > 0 ? (uint32_t) (this->process_cycles_ / this->processed_frames_) : 0;
+  }
+
+  // ADFPipelineElement implementations
+  bool on_settings_request_done(ADFPipelineElement *next, bool upstream_switches) override;
+  void on_upstream_format_switch(uint32_t input_pos) override;
+
+  // task settings of the ADF element, take effect when the pipeline is built
+  void set_task_core(int task_core) { this->task_core_ = task_core; }
+  void set_task_priority(int task_prio) { this->task_prio_ = task_prio; }
+  void set_task_stack_size(int task_stack) { this->task_stack_ = task_stack; }
 
  protected:
   bool init_adf_elements_() override;
-  //void clear_adf_elements_() override;
+  void clear_adf_elements_() override;
+
+  // called from the main loop, applied by the element's task where the new format starts in the input
+  void request_format_(const pcm_format &in_format, const pcm_format &out_format);
+  // checked by the element's task before a format change is applied at its switch point,
+  // e.g. to output buffered frames of the old format first
+  virtual bool format_switch_ready_() { return true; }
+
+  // called from the element's task, the formats are valid until the next call
+  virtual bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) { return true; }
+  virtual esp_err_t open_() { return ESP_OK; }
+  virtual esp_err_t close_() { return ESP_OK; }
+
+  // in place processing of complete frames, returns the number of valid bytes in data
+  // if the output frames are larger than the input frames, less is read so the converted block still fits
+  virtual int process_pcm_(uint8_t *data, int len) { return len; }
+
+  // override for out of place processing, default reads a block, calls process_pcm_ and writes it
+  virtual int process_(char *buffer, int len);
+
+  // reads up to max_len bytes and returns the length of the complete frames at the start of buffer,
+  // an incomplete frame is kept for the next call. read is set to the result of audio_element_input
+  int read_frames_(char *buffer, int max_len, int &read);
+  // reads up to max_len bytes of input, but never beyond the switch point of a pending format change
+  int read_input_(char *buffer, int max_len);
+  // writes to the output and keeps track of the output position for the next element's switch point
+  int write_output_(const char *buffer, int len);
+
+  // reopen applies a pending format regardless of its switch point, the stream starts over
+  bool apply_pending_format_(bool reopen);
+  bool switch_reached_() const;
+  // input position behind everything queued in the current format, called with format_lock_ held
+  uint32_t queued_input_end_() const;
+  int bytes_per_frame_(const pcm_format &format) const { return (format.bits > 16 ? 4 : 2) * format.channels; }
+
+  static esp_err_t adf_open_(audio_element_handle_t self);
+  static esp_err_t adf_close_(audio_element_handle_t self);
+  static audio_element_err_t adf_process_(audio_element_handle_t self, char *buffer, int len);
+
+  // ADF element configuration, to be set by the derived class before initialization
+  std::string element_tag_{"pcm_process"};
+  int buffer_len_{1024};
+  int out_rb_size_{8 * 1024};
+  int task_stack_{3 * 1024};
+  int task_prio_{5};
+  int task_core_{0};
+  bool stack_in_ext_{true};
+
+  // formats currently used by the element's task
+  pcm_format in_format_{16000, 16, 1};
+  pcm_format out_format_{16000, 16, 1};
+
+  Mutex format_lock_;
+  std::atomic<bool> format_pending_{false};
+  pcm_format pending_in_format_{16000, 16, 1};
+  pcm_format pending_out_format_{16000, 16, 1};
+  uint32_t last_reconfiguration_us_{0};
+
+  // input position where the pending format starts, unknown until the request has passed all elements
+  // or, if the previous element switches as well, until it has announced the position
+  std::atomic<bool> switch_known_{true};
+  std::atomic<uint32_t> switch_at_{0};
+  bool switch_requested_{false};
+  // element to tell the output position of the switch, set if it's part of the same request
+  ADFPipelineElement *next_{nullptr};
+
+  // bytes read from the input and written to the output since the element was opened, modulo 2^32
+  std::atomic<uint32_t> in_pos_{0};
+  uint32_t out_pos_{0};
+
+  // cpu cycles spent in process_pcm_ since the element was opened
+  uint64_t process_cycles_{0};
+  uint64_t processed_frames_{0};
+
+  // incomplete frame of the last block, a frame is at most 16 TDM slots of 32 bits
+  static constexpr int MAX_FRAME_BYTES = 16 * 4;
+  uint8_t carry_[MAX_FRAME_BYTES];
+  int carry_len_{0};
+
+  audio_element_handle_t adf_element_{};
+};
+
+class ADFResampler : public ADFPCMProcessElement, public Component {
+ public:
+  ADFResampler();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "Resampler"; }
+  uint8_t converts_format() const override { return PCM_RATE | PCM_CHANNELS; }
+
+  // takes effect with the next format change
+  void set_quality(ResampleQuality quality) { this->quality_ = quality; }
+
+ protected:
   void on_settings_request(AudioPipelineSettingsRequest &request) override;
 
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  esp_err_t close_() override;
+  int process_pcm_(uint8_t *data, int len) override;
+  int process_(char *buffer, int len) override;
+  int process_polyphase_(char *buffer, int len);
+
+  void destroy_resampler_();
+
   int src_rate_{16000};
   int dst_rate_{16000};
   int src_num_channels_{2};
   int dst_num_channels_{2};
+  ResampleQuality quality_{ResampleQuality::MEDIUM};
 
-  audio_element_handle_t sdk_resampler_;
+  // only accessed from the element's task
+  void *rsp_handle_{nullptr};
+  resample_info_t rsp_info_{};
+  unsigned char *rsp_in_buf_{nullptr};
+  unsigned char *rsp_out_buf_{nullptr};
+  int rsp_in_offset_{0};
+  // set if only the number of channels changes, esp_resample isn't needed for that
+  bool remix_only_{false};
+  ChannelMap channel_map_;
+  // the polyphase resampler runs on the smaller number of channels, the channels are mapped around it
+  bool polyphase_{false};
+  PolyphaseResampler polyphase_resampler_;
+  std::vector<int16_t> polyphase_out_;
 };
 
 }  // namespace esp_adf
@@ -47,20 +47,14 @@ int PCMSink::stream_read_bytes(char *buffer, int len) {
 }
 
 void PCMSink::on_settings_request(AudioPipelineSettingsRequest &request) {
- if (request.bit_depth > 0 && (uint8_t) request.bit_depth != this->bits_per_sample_ ){
-    if ( request.bit_depth == 16 || request.bit_depth == 24 || request.bit_depth == 32 )
-    {
-      esph_log_d(TAG, "Set bitdepth to %d", request.bit_depth );
-      this->bits_per_sample_ = request.bit_depth;
-    }
-    else {
-      request.failed = true;
-      request.failed_by = this;
-    }
+  if (request.bit_depth > 0 && request.bit_depth != 16 && request.bit_depth != 24 && request.bit_depth != 32) {
+    request.failed = true;
+    request.failed_by = this;
   }
 
   if (request.final_sampling_rate == -1) {
     request.final_sampling_rate = 16000;
+    // readers get 16 bit samples, wider streams are converted in the pipeline
     request.final_bit_depth = this->bits_per_sample_;
     request.final_number_of_channels = 1;
   }
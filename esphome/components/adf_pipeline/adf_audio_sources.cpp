@@ -47,10 +47,13 @@ void HTTPStreamReaderAndDecoder::clear_adf_elements_() {
   this->sdk_audio_elements_.clear();
   this->sdk_element_tags_.clear();
   this->element_state_ = PipelineElementState::UNINITIALIZED;
+  this->restarting_ = false;
 }
 
 void HTTPStreamReaderAndDecoder::reset_() {
   this->element_state_ = PipelineElementState::INITIALIZED;
+  // a restart is obsolete once the whole pipeline has been stopped
+  this->restarting_ = false;
 }
 
 void HTTPStreamReaderAndDecoder::set_stream_uri(const std::string& new_url) {
@@ -117,6 +120,32 @@ bool HTTPStreamReaderAndDecoder::set_ready_when_prepare_pipeline_stopped_(){
   return stopped;
 }
 
+void HTTPStreamReaderAndDecoder::restart_stream() {
+  // aborts the ring buffers, the element behind the decoder has to tolerate that, see ADFCrossfade
+  audio_element_stop(this->http_stream_reader_);
+  audio_element_stop(this->decoder_);
+  this->restarting_ = true;
+}
+
+bool HTTPStreamReaderAndDecoder::check_restarted() {
+  if (!this->restarting_) {
+    return true;
+  }
+  bool stopped = audio_element_wait_for_stop_ms(this->http_stream_reader_, 0) == ESP_OK;
+  stopped = stopped && audio_element_wait_for_stop_ms(this->decoder_, 0) == ESP_OK;
+  if (!stopped) {
+    return false;
+  }
+  audio_element_reset_state(this->http_stream_reader_);
+  audio_element_reset_state(this->decoder_);
+  audio_element_reset_input_ringbuf(this->decoder_);
+  audio_element_reset_output_ringbuf(this->decoder_);
+  audio_element_set_uri(this->http_stream_reader_, this->current_url_.c_str());
+  this->start_prepare_pipeline_();
+  this->restarting_ = false;
+  return true;
+}
+
 //wait for audio information in stream and send new audio settings to pipeline
 void HTTPStreamReaderAndDecoder::sdk_event_handler_(audio_event_iface_msg_t &msg) {
   audio_element_handle_t mp3_decoder = this->decoder_;
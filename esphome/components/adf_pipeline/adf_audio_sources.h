@@ -18,6 +18,12 @@ class HTTPStreamReaderAndDecoder : public ADFPipelineSourceElement {
   const std::string get_name() override { return "HTTPStreamReader"; }
   bool is_ready() override;
   void prepare_elements() override;
+  bool is_restarting() const override { return this->restarting_; }
+
+  // restarts reader and decoder with the current uri while the rest of the pipeline keeps running
+  void restart_stream();
+  // to be called from the main loop while restarting, returns true once the new stream has been started
+  bool check_restarted();
 
  protected:
   bool init_adf_elements_() override;
@@ -33,6 +39,7 @@ class HTTPStreamReaderAndDecoder : public ADFPipelineSourceElement {
 
   PipelineElementState element_state_{PipelineElementState::UNINITIALIZED};
   std::string current_url_{"https://dl.espressif.com/dl/audio/ff-16b-2c-44100hz.mp3"};
+  bool restarting_{false};
   audio_element_handle_t http_stream_reader_{};
   audio_element_handle_t decoder_{};
 };
@@ -0,0 +1,217 @@
+#include "adf_beamformer.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_beamformer";
+
+static const float SPEED_OF_SOUND = 343.f;
+// delay line per microphone, power of two, limits the lag to HISTORY_LEN / 2 - 1 samples
+static const size_t HISTORY_LEN = 64;
+static const size_t HISTORY_MASK = HISTORY_LEN - 1;
+// frames per delay estimate, 32ms at 16 kHz
+static const size_t EST_WINDOW = 512;
+// minimum average energy of the pre-whitened reference microphone for an estimate
+static const int64_t EST_MIN_LEVEL = 64 * 64;
+// minimum normalized correlation at the peak
+static const float EST_MIN_COHERENCE = 0.3f;
+
+ADFBeamformer::ADFBeamformer() {
+  this->element_tag_ = "beamformer";
+  this->in_format_ = this->in_settings_;
+  this->out_format_ = this->out_settings_;
+}
+
+void ADFBeamformer::dump_config() {
+  esph_log_config(TAG, "Beamformer:");
+  if (this->mic_channels_.empty()) {
+    esph_log_config(TAG, "  mic channels: all");
+  } else {
+    for (uint8_t ch : this->mic_channels_) {
+      esph_log_config(TAG, "  mic channel: %u", ch);
+    }
+  }
+  esph_log_config(TAG, "  max mic distance: %.0f mm", this->max_mic_distance_m_ * 1000.f);
+}
+
+void ADFBeamformer::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format in_format = this->pipeline_->get_format_at(this, request, this->in_settings_);
+  if (in_format.bits != 16 && in_format.bits != 24 && in_format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  pcm_format out_format = in_format;
+  out_format.channels = request.final_number_of_channels > 0 ? request.final_number_of_channels : 1;
+  if (in_format.rate != this->in_settings_.rate || in_format.bits != this->in_settings_.bits ||
+      in_format.channels != this->in_settings_.channels || out_format.channels != this->out_settings_.channels) {
+    this->in_settings_ = in_format;
+    this->out_settings_ = out_format;
+    this->request_format_(in_format, out_format);
+  }
+}
+
+bool ADFBeamformer::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->num_mics_ = 0;
+  if (this->mic_channels_.empty()) {
+    for (int ch = 0; ch < in_format.channels && ch < MAX_MICS; ch++) {
+      this->mic_index_[this->num_mics_++] = ch;
+    }
+  } else {
+    for (uint8_t ch : this->mic_channels_) {
+      if (ch < in_format.channels && this->num_mics_ < MAX_MICS) {
+        this->mic_index_[this->num_mics_++] = ch;
+      }
+    }
+  }
+  if (this->num_mics_ == 0) {
+    esph_log_e(TAG, "None of the microphone channels is part of the %d channel stream", in_format.channels);
+    return false;
+  }
+
+  const int max_lag = (int) std::ceil(this->max_mic_distance_m_ / SPEED_OF_SOUND * in_format.rate);
+  this->max_lag_ = std::max(0, std::min(max_lag, (int) HISTORY_LEN / 2 - 1));
+  // start without steering, i.e. broadside
+  for (int m = 0; m < this->num_mics_; m++) {
+    this->delays_[m] = this->max_lag_;
+    this->est_prev_[m] = 0;
+  }
+  this->history_.assign(this->num_mics_ * HISTORY_LEN, 0);
+  this->history_pos_ = 0;
+  this->est_buffer_.assign(this->num_mics_ * EST_WINDOW, 0);
+  this->est_pos_ = 0;
+  this->candidate_valid_ = false;
+  esph_log_d(TAG, "%d mics, max lag %d samples", this->num_mics_, this->max_lag_);
+  return true;
+}
+
+template<typename T> void ADFBeamformer::process_frames_(T *samples, size_t num_frames) {
+  const int in_channels = this->in_format_.channels;
+  const int num_mics = this->num_mics_;
+  const int shift = sizeof(T) > 2 ? 16 : 0;
+  int32_t *history = this->history_.data();
+  int16_t *est = this->est_buffer_.data();
+
+  for (size_t frame = 0; frame < num_frames; frame++) {
+    const T *samples_in_frame = samples + frame * in_channels;
+    const size_t pos = this->history_pos_;
+    int64_t sum = 0;
+    for (int m = 0; m < num_mics; m++) {
+      const T x = samples_in_frame[this->mic_index_[m]];
+      int32_t *mic_history = history + m * HISTORY_LEN;
+      mic_history[pos] = x;
+      sum += mic_history[(pos - this->delays_[m]) & HISTORY_MASK];
+
+      // first difference as cheap pre-whitening, sharpens the correlation peak of speech
+      const int16_t x16 = (int16_t) (x >> shift);
+      const int32_t diff = (int32_t) x16 - this->est_prev_[m];
+      this->est_prev_[m] = x16;
+      est[m * EST_WINDOW + this->est_pos_] = (int16_t) clamp<int32_t>(diff, INT16_MIN, INT16_MAX);
+    }
+    // frames are read completely before the mono sample is written, which is never behind the read position
+    samples[frame] = (T) (sum / num_mics);
+    this->history_pos_ = (pos + 1) & HISTORY_MASK;
+    if (++this->est_pos_ == EST_WINDOW) {
+      this->estimate_delays_();
+      this->est_pos_ = 0;
+    }
+  }
+}
+
+void ADFBeamformer::estimate_delays_() {
+  if (this->num_mics_ < 2 || this->max_lag_ == 0) {
+    return;
+  }
+  const int16_t *ref = this->est_buffer_.data();
+  int64_t ref_energy = 0;
+  for (size_t n = 0; n < EST_WINDOW; n++) {
+    ref_energy += (int32_t) ref[n] * ref[n];
+  }
+  if (ref_energy < EST_MIN_LEVEL * (int64_t) EST_WINDOW) {
+    return;
+  }
+
+  const int max_lag = this->max_lag_;
+  int lags[MAX_MICS]{};
+  for (int m = 1; m < this->num_mics_; m++) {
+    const int16_t *mic = this->est_buffer_.data() + m * EST_WINDOW;
+    int64_t mic_energy = 0;
+    for (size_t n = 0; n < EST_WINDOW; n++) {
+      mic_energy += (int32_t) mic[n] * mic[n];
+    }
+    int64_t best = INT64_MIN;
+    int best_lag = 0;
+    for (int lag = -max_lag; lag <= max_lag; lag++) {
+      const size_t first = lag < 0 ? -lag : 0;
+      const size_t last = lag > 0 ? EST_WINDOW - lag : EST_WINDOW;
+      int64_t corr = 0;
+      for (size_t n = first; n < last; n++) {
+        corr += (int32_t) ref[n] * mic[n + lag];
+      }
+      if (corr > best) {
+        best = corr;
+        best_lag = lag;
+      }
+    }
+    // reject diffuse noise and reverberation tails
+    const float coherence = (float) best / std::sqrt((float) ref_energy * (float) mic_energy + 1.f);
+    if (best <= 0 || coherence < EST_MIN_COHERENCE) {
+      return;
+    }
+    lags[m] = best_lag;
+  }
+
+  // apply only if two consecutive estimates agree
+  bool agree = this->candidate_valid_;
+  for (int m = 1; m < this->num_mics_; m++) {
+    agree = agree && this->candidate_lags_[m] == lags[m];
+    this->candidate_lags_[m] = lags[m];
+  }
+  this->candidate_valid_ = true;
+  if (!agree) {
+    return;
+  }
+  bool changed = false;
+  for (int m = 1; m < this->num_mics_; m++) {
+    // mic m receives the source lags[m] samples after the first one, delay all to max_lag in total
+    const int delay = max_lag - lags[m];
+    changed = changed || delay != this->delays_[m];
+    this->delays_[m] = delay;
+  }
+  if (changed) {
+    esph_log_v(TAG, "Steering updated, lag of mic 2: %d samples", lags[1]);
+  }
+}
+
+int ADFBeamformer::process_pcm_(uint8_t *data, int len) {
+  const size_t num_frames = len / this->bytes_per_frame_(this->in_format_);
+  const int out_channels = this->out_format_.channels;
+  if (this->in_format_.bits == 16) {
+    int16_t *samples = (int16_t *) data;
+    this->process_frames_<int16_t>(samples, num_frames);
+    for (size_t frame = num_frames; frame-- > 0 && out_channels > 1;) {
+      const int16_t value = samples[frame];
+      std::fill_n(samples + frame * out_channels, out_channels, value);
+    }
+  } else {
+    int32_t *samples = (int32_t *) data;
+    this->process_frames_<int32_t>(samples, num_frames);
+    for (size_t frame = num_frames; frame-- > 0 && out_channels > 1;) {
+      const int32_t value = samples[frame];
+      std::fill_n(samples + frame * out_channels, out_channels, value);
+    }
+  }
+  return num_frames * this->bytes_per_frame_(this->out_format_);
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <vector>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+Delay-and-sum beamformer for microphone arrays, e.g. an ES7210 capturing four channels via TDM.
+The time differences of arrival between the first and the other microphones are estimated by
+cross-correlating the pre-whitened signals, the microphones are aligned with integer sample delays
+and averaged. The array steers itself towards the dominant source, no geometry is needed apart
+from the largest distance between two microphones.
+The enhanced signal is written to all output channels, the number of output channels follows the
+format requested by the sink (mono by default).
+*/
+class ADFBeamformer : public ADFPCMProcessElement, public Component {
+ public:
+  static const int MAX_MICS = 8;
+
+  ADFBeamformer();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "Beamformer"; }
+  uint8_t converts_format() const override { return PCM_CHANNELS; }
+
+  // input channels carrying microphones, all channels if empty
+  void set_mic_channels(const std::vector<uint8_t> &mic_channels) { this->mic_channels_ = mic_channels; }
+  void set_max_mic_distance(float distance_m) { this->max_mic_distance_m_ = distance_m; }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  template<typename T> void process_frames_(T *samples, size_t num_frames);
+  void estimate_delays_();
+
+  std::vector<uint8_t> mic_channels_;
+  float max_mic_distance_m_{0.1f};
+  pcm_format in_settings_{16000, 16, 4};
+  pcm_format out_settings_{16000, 16, 1};
+
+  // only accessed from the element's task
+  int num_mics_{0};
+  uint8_t mic_index_[MAX_MICS]{};
+  int max_lag_{0};
+  int delays_[MAX_MICS]{};
+  std::vector<int32_t> history_;
+  size_t history_pos_{0};
+
+  // delay estimation
+  std::vector<int16_t> est_buffer_;
+  size_t est_pos_{0};
+  int16_t est_prev_[MAX_MICS]{};
+  int candidate_lags_[MAX_MICS]{};
+  bool candidate_valid_{false};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
@@ -0,0 +1,110 @@
+#include "adf_bit_depth_converter.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_bit_depth";
+
+ADFBitDepthConverter::ADFBitDepthConverter() {
+  this->element_tag_ = "bit_depth";
+  this->in_format_ = this->in_settings_;
+  this->out_format_ = this->out_settings_;
+}
+
+void ADFBitDepthConverter::dump_config() {
+  esph_log_config(TAG, "Bit Depth Converter:");
+  if (this->bits_per_sample_ > 0) {
+    esph_log_config(TAG, "  bits per sample: %u", this->bits_per_sample_);
+  }
+  esph_log_config(TAG, "  gain log2: %u", this->gain_log2_);
+  if (this->high_pass_.get_dc_blocker()) {
+    esph_log_config(TAG, "  DC blocker: YES");
+  }
+  if (this->high_pass_.get_frequency() > 0.f) {
+    esph_log_config(TAG, "  high-pass: %.0f Hz", this->high_pass_.get_frequency());
+  }
+}
+
+void ADFBitDepthConverter::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format in_format = this->pipeline_->get_format_at(this, request, this->in_settings_);
+  pcm_format out_format = in_format;
+  if (request.final_bit_depth > 0) {
+    out_format.bits = request.final_bit_depth;
+  } else if (this->bits_per_sample_ > 0) {
+    out_format.bits = this->bits_per_sample_;
+  }
+  for (int bits : {in_format.bits, out_format.bits}) {
+    if (bits != 16 && bits != 24 && bits != 32) {
+      request.failed = true;
+      request.failed_by = this;
+      return;
+    }
+  }
+  if (in_format.rate != this->in_settings_.rate || in_format.bits != this->in_settings_.bits ||
+      in_format.channels != this->in_settings_.channels || out_format.bits != this->out_settings_.bits) {
+    this->in_settings_ = in_format;
+    this->out_settings_ = out_format;
+    this->request_format_(in_format, out_format);
+  }
+}
+
+bool ADFBitDepthConverter::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  if (this->high_pass_.is_enabled()) {
+    this->high_pass_.configure(in_format.rate, in_format.channels);
+  }
+  return true;
+}
+
+int ADFBitDepthConverter::process_filtered_(uint8_t *data, int len) {
+  const int channels = this->in_format_.channels;
+  if (this->in_format_.bits == 16) {
+    int16_t *samples = (int16_t *) data;
+    const size_t num_frames = len / (sizeof(int16_t) * channels);
+    this->high_pass_.process(samples, samples, num_frames);
+    if (this->out_format_.bits == 16) {
+      return len;
+    }
+    // growing in place has to run backwards, which the filter can't, so this takes a second pass
+    audio_s16_to_s32(samples, (int32_t *) data, num_frames * channels);
+    return num_frames * channels * sizeof(int32_t);
+  }
+  int32_t *samples = (int32_t *) data;
+  const size_t num_frames = len / (sizeof(int32_t) * channels);
+  if (this->out_format_.bits > 16) {
+    this->high_pass_.process(samples, samples, num_frames);
+    return len;
+  }
+  // single pass, every sample is read before its 16 bit result is stored
+  this->high_pass_.process(samples, (int16_t *) data, num_frames, this->gain_log2_);
+  return num_frames * channels * sizeof(int16_t);
+}
+
+int ADFBitDepthConverter::process_pcm_(uint8_t *data, int len) {
+  if (this->high_pass_.is_enabled()) {
+    return this->process_filtered_(data, len);
+  }
+  const bool in_wide = this->in_format_.bits > 16;
+  const bool out_wide = this->out_format_.bits > 16;
+  if (in_wide == out_wide) {
+    // 24 and 32 bit samples share the container
+    return len;
+  }
+  if (in_wide) {
+    const size_t num_samples = len / sizeof(int32_t);
+    audio_s32_to_s16((const int32_t *) data, (int16_t *) data, num_samples, 16 - this->gain_log2_);
+    return num_samples * sizeof(int16_t);
+  }
+  const size_t num_samples = len / sizeof(int16_t);
+  audio_s16_to_s32((const int16_t *) data, (int32_t *) data, num_samples);
+  return num_samples * sizeof(int32_t);
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+#include "adf_high_pass.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+Converts the bit depth of the stream to the one requested by the sink, 24 bit samples are expected
+in 32 bit containers. When reducing to 16 bits, the samples can be amplified by 2^gain_log2.
+Runs on the element's task and converts in place, so the consumer receives ready frames.
+A DC blocker and high-pass can be fused into the conversion, which saves a separate element.
+*/
+class ADFBitDepthConverter : public ADFPCMProcessElement, public Component {
+ public:
+  ADFBitDepthConverter();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "BitDepthConverter"; }
+  uint8_t converts_format() const override { return PCM_BITS; }
+
+  // output bit depth if the sink doesn't request one, 0 keeps the input bit depth
+  void set_bits_per_sample(uint8_t bits) { this->bits_per_sample_ = bits; }
+  void set_gain_log2(uint8_t gain_log2) { this->gain_log2_ = gain_log2; }
+  // frequency 0 disables the high-pass
+  void set_high_pass(bool dc_blocker, float frequency) {
+    this->high_pass_.set_dc_blocker(dc_blocker);
+    this->high_pass_.set_frequency(frequency);
+  }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+  int process_filtered_(uint8_t *data, int len);
+
+  uint8_t bits_per_sample_{16};
+  uint8_t gain_log2_{0};
+  pcm_format in_settings_{16000, 16, 1};
+  pcm_format out_settings_{16000, 16, 1};
+
+  // disabled unless configured, only accessed from the element's task after setup
+  HighPassFilter high_pass_;
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
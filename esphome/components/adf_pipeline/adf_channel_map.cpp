@@ -0,0 +1,102 @@
+#include "adf_channel_map.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace esp_adf {
+
+void ChannelMap::configure(ChannelMixMode mode, const std::vector<int8_t> &map, int in_channels, int out_channels) {
+  this->in_channels_ = std::max(1, std::min(in_channels, MAX_CHANNELS));
+  this->out_channels_ = std::max(1, std::min(out_channels, MAX_CHANNELS));
+  const int in_ch = this->in_channels_;
+  const int out_ch = this->out_channels_;
+  for (int ch = 0; ch < out_ch; ch++) {
+    int8_t src;
+    switch (mode) {
+      case ChannelMixMode::LEFT:
+        src = 0;
+        break;
+      case ChannelMixMode::RIGHT:
+        src = std::min(1, in_ch - 1);
+        break;
+      case ChannelMixMode::AVERAGE:
+        src = in_ch > 1 ? AVERAGE : 0;
+        break;
+      case ChannelMixMode::MAP:
+        src = map.empty() ? ch % in_ch : map[ch % map.size()];
+        if (src >= in_ch) {
+          src = SILENT;
+        }
+        break;
+      case ChannelMixMode::AUTO:
+      default:
+        if (in_ch == out_ch || out_ch > in_ch) {
+          // keep or duplicate
+          src = ch % in_ch;
+        } else if (out_ch == 1) {
+          src = AVERAGE;
+        } else {
+          src = ch;
+        }
+        break;
+    }
+    this->route_[ch] = src;
+  }
+}
+
+bool ChannelMap::is_identity() const {
+  if (this->in_channels_ != this->out_channels_) {
+    return false;
+  }
+  for (int ch = 0; ch < this->out_channels_; ch++) {
+    if (this->route_[ch] != ch) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<typename T> void ChannelMap::apply(T *data, size_t num_frames) const {
+  const int in_ch = this->in_channels_;
+  const int out_ch = this->out_channels_;
+  T frame[MAX_CHANNELS];
+  auto convert_frame = [&](size_t idx) {
+    std::memcpy(frame, data + idx * in_ch, in_ch * sizeof(T));
+    T *out = data + idx * out_ch;
+    for (int ch = 0; ch < out_ch; ch++) {
+      const int8_t src = this->route_[ch];
+      if (src >= 0) {
+        out[ch] = frame[src];
+      } else if (src == AVERAGE) {
+        int64_t sum = 0;
+        for (int i = 0; i < in_ch; i++) {
+          sum += frame[i];
+        }
+        out[ch] = (T) (sum / in_ch);
+      } else {
+        out[ch] = 0;
+      }
+    }
+  };
+  // when growing, go backwards so no input frame is overwritten before it was read
+  if (out_ch <= in_ch) {
+    for (size_t idx = 0; idx < num_frames; idx++) {
+      convert_frame(idx);
+    }
+  } else {
+    for (size_t idx = num_frames; idx > 0; idx--) {
+      convert_frame(idx - 1);
+    }
+  }
+}
+
+template void ChannelMap::apply<int16_t>(int16_t *data, size_t num_frames) const;
+template void ChannelMap::apply<int32_t>(int32_t *data, size_t num_frames) const;
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
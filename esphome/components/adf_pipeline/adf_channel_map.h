@@ -0,0 +1,42 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace esp_adf {
+
+enum class ChannelMixMode : uint8_t { AUTO = 0, LEFT, RIGHT, AVERAGE, MAP };
+
+/*
+Routing of input to output channels. Every output channel is either copied from an input channel,
+the average of all input channels or silent. Used by the channel mixer and by the resampler when
+only the number of channels changes.
+*/
+class ChannelMap {
+ public:
+  static constexpr int MAX_CHANNELS = 16;
+  static constexpr int8_t SILENT = -1;
+  static constexpr int8_t AVERAGE = -2;
+
+  // map is only used in MAP mode, output channel i is taken from input channel map[i % map.size()]
+  void configure(ChannelMixMode mode, const std::vector<int8_t> &map, int in_channels, int out_channels);
+  bool is_identity() const;
+  int get_in_channels() const { return this->in_channels_; }
+  int get_out_channels() const { return this->out_channels_; }
+
+  // converts num_frames in place, data needs to hold num_frames * max(in, out) channels
+  template<typename T> void apply(T *data, size_t num_frames) const;
+
+ protected:
+  int in_channels_{1};
+  int out_channels_{1};
+  int8_t route_[MAX_CHANNELS]{};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
@@ -0,0 +1,93 @@
+#include "adf_channel_mixer.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_channel_mixer";
+
+static const char *mode_to_string(ChannelMixMode mode) {
+  switch (mode) {
+    case ChannelMixMode::LEFT:
+      return "left";
+    case ChannelMixMode::RIGHT:
+      return "right";
+    case ChannelMixMode::AVERAGE:
+      return "average";
+    case ChannelMixMode::MAP:
+      return "map";
+    case ChannelMixMode::AUTO:
+    default:
+      return "auto";
+  }
+}
+
+ADFChannelMixer::ADFChannelMixer() {
+  this->element_tag_ = "ch_mixer";
+  this->in_format_ = this->in_settings_;
+  this->out_format_ = this->out_settings_;
+}
+
+void ADFChannelMixer::dump_config() {
+  esph_log_config(TAG, "Channel Mixer:");
+  esph_log_config(TAG, "  mode: %s", mode_to_string(this->mode_));
+  if (this->mode_ == ChannelMixMode::MAP) {
+    for (int ch = 0; ch < (int) this->map_.size(); ch++) {
+      esph_log_config(TAG, "  output %d: %d", ch, this->map_[ch]);
+    }
+  }
+}
+
+void ADFChannelMixer::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format in_format = this->pipeline_->get_format_at(this, request, this->in_settings_);
+  if (in_format.bits != 16 && in_format.bits != 24 && in_format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  pcm_format out_format = in_format;
+  if (request.final_number_of_channels > 0) {
+    out_format.channels = request.final_number_of_channels;
+  } else if (this->mode_ == ChannelMixMode::MAP && !this->map_.empty()) {
+    out_format.channels = this->map_.size();
+  } else if (this->mode_ != ChannelMixMode::AUTO) {
+    out_format.channels = 1;
+  }
+  if (in_format.channels > ChannelMap::MAX_CHANNELS || out_format.channels > ChannelMap::MAX_CHANNELS) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (in_format.rate != this->in_settings_.rate || in_format.bits != this->in_settings_.bits ||
+      in_format.channels != this->in_settings_.channels || out_format.channels != this->out_settings_.channels ||
+      out_format.rate != this->out_settings_.rate || out_format.bits != this->out_settings_.bits) {
+    this->in_settings_ = in_format;
+    this->out_settings_ = out_format;
+    this->request_format_(in_format, out_format);
+  }
+}
+
+bool ADFChannelMixer::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->channel_map_.configure(this->mode_, this->map_, in_format.channels, out_format.channels);
+  return true;
+}
+
+int ADFChannelMixer::process_pcm_(uint8_t *data, int len) {
+  if (this->channel_map_.is_identity()) {
+    return len;
+  }
+  const size_t num_frames = len / this->bytes_per_frame_(this->in_format_);
+  if (this->in_format_.bits == 16) {
+    this->channel_map_.apply<int16_t>((int16_t *) data, num_frames);
+  } else {
+    this->channel_map_.apply<int32_t>((int32_t *) data, num_frames);
+  }
+  return num_frames * this->bytes_per_frame_(this->out_format_);
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,50 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <vector>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+#include "adf_channel_map.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+Selects, mixes down or duplicates channels, much cheaper than running the resampler for that.
+The number of output channels follows the final format requested by the sink, the mode defines
+where the output channels are taken from.
+*/
+class ADFChannelMixer : public ADFPCMProcessElement, public Component {
+ public:
+  ADFChannelMixer();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "ChannelMixer"; }
+  uint8_t converts_format() const override { return PCM_CHANNELS; }
+
+  void set_mode(ChannelMixMode mode) { this->mode_ = mode; }
+  void set_map(const std::vector<int8_t> &map) { this->map_ = map; }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  ChannelMixMode mode_{ChannelMixMode::AUTO};
+  std::vector<int8_t> map_;
+  pcm_format in_settings_{16000, 16, 2};
+  pcm_format out_settings_{16000, 16, 1};
+
+  // only accessed from the element's task
+  ChannelMap channel_map_;
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
@@ -0,0 +1,157 @@
+#include "adf_compressor.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <cmath>
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_compressor";
+
+// frames sharing one level detection and gain calculation
+static const size_t COMP_BLOCK_FRAMES = 32;
+static const int COMP_GAIN_SHIFT = 24;
+static const float COMP_GAIN_UNITY = (float) (1 << COMP_GAIN_SHIFT);
+
+ADFCompressor::ADFCompressor() {
+  this->element_tag_ = "compressor";
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFCompressor::dump_config() {
+  esph_log_config(TAG, "Compressor:");
+  esph_log_config(TAG, "  threshold: %.1f dB", this->threshold_db_);
+  if (this->ratio_ > 0.f) {
+    esph_log_config(TAG, "  ratio: %.1f:1", this->ratio_);
+  } else {
+    esph_log_config(TAG, "  ratio: limiter");
+  }
+  esph_log_config(TAG, "  attack: %u ms, release: %u ms, look-ahead: %u ms", this->attack_ms_, this->release_ms_,
+                  this->lookahead_ms_);
+  esph_log_config(TAG, "  makeup gain: %.1f dB", this->makeup_gain_db_);
+  esph_log_config(TAG, "  bypass: %s", YESNO(this->bypass_));
+}
+
+void ADFCompressor::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFCompressor::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  const float block_time = (float) COMP_BLOCK_FRAMES / in_format.rate;
+  this->full_scale_ = in_format.bits == 16 ? 32768.f : 2147483648.f;
+  this->attack_coeff_ = this->attack_ms_ > 0 ? expf(-block_time * 1000.f / this->attack_ms_) : 0.f;
+  this->release_coeff_ = this->release_ms_ > 0 ? expf(-block_time * 1000.f / this->release_ms_) : 0.f;
+  this->makeup_gain_ = powf(10.f, this->makeup_gain_db_ / 20.f);
+  this->gain_ = this->makeup_gain_;
+  this->hold_blocks_ = 0;
+
+  // the look-ahead needs to cover at least one detection block
+  this->delay_frames_ = (size_t) this->lookahead_ms_ * in_format.rate / 1000;
+  if (this->delay_frames_ > 0 && this->delay_frames_ < COMP_BLOCK_FRAMES) {
+    this->delay_frames_ = COMP_BLOCK_FRAMES;
+  }
+  this->delay_line_.assign(this->delay_frames_ * in_format.channels, 0);
+  this->delay_pos_ = 0;
+  return true;
+}
+
+// static gain curve including makeup gain, linear peak in, linear gain out
+float ADFCompressor::target_gain_(float peak) const {
+  const float level = peak * this->makeup_gain_ / this->full_scale_;
+  if (level <= 0.f) {
+    return this->makeup_gain_;
+  }
+  const float over_db = 20.f * log10f(level) - this->threshold_db_;
+  if (over_db <= 0.f) {
+    return this->makeup_gain_;
+  }
+  const float reduction_db = this->ratio_ > 0.f ? over_db * (1.f - 1.f / this->ratio_) : over_db;
+  return this->makeup_gain_ * powf(10.f, -reduction_db / 20.f);
+}
+
+template<typename T> void ADFCompressor::process_block_(T *samples, size_t num_frames) {
+  const int channels = this->in_format_.channels;
+  // blocks needed until a detected peak has left the delay line
+  const uint32_t hold = (this->delay_frames_ + COMP_BLOCK_FRAMES - 1) / COMP_BLOCK_FRAMES + 1;
+  const bool limiter = this->ratio_ <= 0.f;
+
+  for (size_t start = 0; start < num_frames; start += COMP_BLOCK_FRAMES) {
+    const size_t frames = std::min(COMP_BLOCK_FRAMES, num_frames - start);
+    T *block = samples + start * channels;
+
+    int32_t peak = 0;
+    for (size_t i = 0; i < frames * channels; i++) {
+      const int32_t value = block[i];
+      peak = std::max(peak, value < 0 ? -(value + 1) : value);
+    }
+
+    const float target = this->target_gain_((float) peak);
+    const float previous = this->gain_;
+    if (target < this->gain_) {
+      this->gain_ = limiter ? target : target + (this->gain_ - target) * this->attack_coeff_;
+      this->hold_blocks_ = hold;
+    } else if (this->hold_blocks_ > 0) {
+      this->hold_blocks_--;
+    } else {
+      this->gain_ = target + (this->gain_ - target) * this->release_coeff_;
+    }
+
+    int32_t gain = (int32_t) (previous * COMP_GAIN_UNITY);
+    const int32_t step = ((int32_t) (this->gain_ * COMP_GAIN_UNITY) - gain) / (int32_t) frames;
+    for (size_t f = 0; f < frames; f++) {
+      gain += step;
+      for (int ch = 0; ch < channels; ch++) {
+        int32_t sample = block[f * channels + ch];
+        if (this->delay_frames_ > 0) {
+          int32_t &delayed = this->delay_line_[this->delay_pos_ * channels + ch];
+          std::swap(sample, delayed);
+        }
+        block[f * channels + ch] = audio_sat<T>(((int64_t) sample * gain) >> COMP_GAIN_SHIFT);
+      }
+      if (this->delay_frames_ > 0 && ++this->delay_pos_ == this->delay_frames_) {
+        this->delay_pos_ = 0;
+      }
+    }
+  }
+  this->gain_reduction_db_ = -20.f * log10f(this->gain_ / this->makeup_gain_);
+}
+
+int ADFCompressor::process_pcm_(uint8_t *data, int len) {
+  if (this->bypass_) {
+    this->was_bypassed_ = true;
+    return len;
+  }
+  if (this->was_bypassed_) {
+    // start over, the delay line contains stale data
+    std::fill(this->delay_line_.begin(), this->delay_line_.end(), 0);
+    this->gain_ = this->makeup_gain_;
+    this->hold_blocks_ = 0;
+    this->was_bypassed_ = false;
+  }
+  if (this->in_format_.bits == 16) {
+    this->process_block_<int16_t>((int16_t *) data, len / (sizeof(int16_t) * this->in_format_.channels));
+  } else {
+    this->process_block_<int32_t>((int32_t *) data, len / (sizeof(int32_t) * this->in_format_.channels));
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
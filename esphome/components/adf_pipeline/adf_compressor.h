@@ -0,0 +1,79 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+Feed-forward compressor and look-ahead peak limiter processing the stream in place.
+The level is detected block-wise (peak over a few frames, linked over all channels), the gain is only
+calculated once per block and interpolated linearly over the frames. Samples are delayed by the
+look-ahead time, so the gain has been reduced before a peak reaches the output.
+In bypass mode the block is passed on untouched.
+*/
+class ADFCompressor : public ADFPCMProcessElement, public Component {
+ public:
+  ADFCompressor();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "Compressor"; }
+
+  void set_threshold_db(float threshold_db) { this->threshold_db_ = threshold_db; }
+  // a ratio of 0 turns the compressor into a limiter
+  void set_ratio(float ratio) { this->ratio_ = ratio; }
+  void set_attack_time(uint32_t attack_ms) { this->attack_ms_ = attack_ms; }
+  void set_release_time(uint32_t release_ms) { this->release_ms_ = release_ms; }
+  void set_lookahead_time(uint32_t lookahead_ms) { this->lookahead_ms_ = lookahead_ms; }
+  void set_makeup_gain_db(float makeup_gain_db) { this->makeup_gain_db_ = makeup_gain_db; }
+  void set_bypass(bool bypass) { this->bypass_ = bypass; }
+  bool get_bypass() const { return this->bypass_; }
+
+  // gain reduction of the last processed block in dB (>= 0)
+  float get_gain_reduction_db() const { return this->gain_reduction_db_; }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  template<typename T> void process_block_(T *samples, size_t num_frames);
+  float target_gain_(float peak) const;
+
+  float threshold_db_{-12.f};
+  float ratio_{4.f};
+  uint32_t attack_ms_{5};
+  uint32_t release_ms_{100};
+  uint32_t lookahead_ms_{5};
+  float makeup_gain_db_{0.f};
+  std::atomic<bool> bypass_{false};
+  pcm_format format_{16000, 16, 2};
+
+  // only accessed from the element's task
+  float full_scale_{32768.f};
+  float attack_coeff_{0.f};
+  float release_coeff_{0.f};
+  float makeup_gain_{1.f};
+  float gain_{1.f};
+  uint32_t hold_blocks_{0};
+  std::atomic<float> gain_reduction_db_{0.f};
+  bool was_bypassed_{false};
+
+  std::vector<int32_t> delay_line_;
+  size_t delay_frames_{0};
+  size_t delay_pos_{0};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
@@ -0,0 +1,325 @@
+#include "adf_crossfade.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cmath>
+#include <esp_cpu.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_crossfade";
+
+// frames sharing one gain calculation, the gains are interpolated linearly in between
+static const size_t FADE_BLOCK_FRAMES = 32;
+static const int FADE_SHIFT = 15;
+static const int32_t FADE_UNITY = 1 << FADE_SHIFT;
+// fade in at start and fade out at stop, long enough to avoid clicks
+static const uint32_t EDGE_FADE_MS = 20;
+// how long the task waits for input if there is nothing else to do
+static const uint32_t CROSSFADE_INPUT_WAIT_MS = 20;
+
+// equal power fade in Q15 at pos of length frames, sin for the incoming stream, the outgoing one
+// uses the mirrored position
+static int32_t fade_gain(size_t pos, size_t length) {
+  if (pos >= length) {
+    return FADE_UNITY;
+  }
+  return (int32_t) (sinf((float) M_PI_2 * pos / length) * FADE_UNITY);
+}
+
+ADFCrossfade::ADFCrossfade() {
+  this->element_tag_ = "crossfade";
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFCrossfade::dump_config() {
+  esph_log_config(TAG, "Crossfade:");
+  esph_log_config(TAG, "  duration: %u ms", this->duration_ms_);
+}
+
+void ADFCrossfade::start_crossfade() {
+  this->requested_++;
+  this->request_ = CrossfadeRequest::CROSSFADE;
+}
+
+void ADFCrossfade::start_fade_out() {
+  this->faded_out_ = false;
+  this->request_ = CrossfadeRequest::FADE_OUT;
+}
+
+void ADFCrossfade::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFCrossfade::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  const size_t frame_size = this->bytes_per_frame_(in_format);
+  const size_t block_frames = this->buffer_len_ / frame_size;
+  const size_t fifo_frames = std::max<size_t>((size_t) this->duration_ms_ * in_format.rate / 1000, 2 * block_frames);
+  this->fifo_.assign(fifo_frames * frame_size, 0);
+  this->edge_frames_ = (size_t) EDGE_FADE_MS * in_format.rate / 1000;
+  // the fifo has been played out, see format_switch_ready_, the new format starts over
+  this->clear_fifo_();
+  return true;
+}
+
+esp_err_t ADFCrossfade::open_() {
+  this->clear_fifo_();
+  this->input_held_ = false;
+  this->input_done_ = false;
+  this->faded_out_ = false;
+  this->request_ = CrossfadeRequest::NONE;
+  this->released_ = this->requested_.load();
+  return ESP_OK;
+}
+
+void ADFCrossfade::clear_fifo_() {
+  this->head_ = 0;
+  this->fill_ = 0;
+  this->mode_ = CrossfadeMode::PASS;
+  this->tail_bytes_ = 0;
+  this->incoming_consumed_ = 0;
+  this->fade_out_pos_ = 0;
+  this->fade_out_frames_ = 0;
+  this->fade_in_pos_ = 0;
+  this->fade_in_frames_ = this->edge_frames_;
+}
+
+void ADFCrossfade::handle_request_(int frame_size) {
+  const CrossfadeRequest request = this->request_.exchange(CrossfadeRequest::NONE);
+  if (request == CrossfadeRequest::NONE) {
+    return;
+  }
+  if (this->mode_ == CrossfadeMode::CROSSFADE) {
+    // another track change during a crossfade, the rest of the previous tail is skipped
+    this->head_ = (this->head_ + this->tail_bytes_ + this->incoming_consumed_) % this->fifo_.size();
+    this->fill_ -= this->tail_bytes_ + this->incoming_consumed_;
+    this->tail_bytes_ = 0;
+    this->incoming_consumed_ = 0;
+  }
+
+  const size_t frames = this->fill_ / frame_size;
+  this->fade_out_pos_ = 0;
+  if (request == CrossfadeRequest::CROSSFADE) {
+    // a partial frame of the outgoing track would misalign the incoming one
+    this->fill_ = frames * frame_size;
+    this->tail_bytes_ = this->fill_;
+    this->fade_out_frames_ = frames;
+    this->fade_in_pos_ = 0;
+    this->fade_in_frames_ = std::max(frames, this->edge_frames_);
+    this->mode_ = frames > 0 ? CrossfadeMode::CROSSFADE : CrossfadeMode::PASS;
+  } else {
+    const size_t tail = std::min(frames, this->edge_frames_);
+    this->fill_ = tail * frame_size;
+    this->tail_bytes_ = this->fill_;
+    this->fade_out_frames_ = tail;
+    this->mode_ = CrossfadeMode::FADE_OUT;
+    if (tail == 0) {
+      this->head_ = 0;
+      this->faded_out_ = true;
+    }
+  }
+}
+
+int ADFCrossfade::fill_fifo_(int frame_size) {
+  if (this->input_held_) {
+    if (this->released_ != this->requested_) {
+      return 0;
+    }
+    this->input_held_ = false;
+  }
+  if (this->mode_ == CrossfadeMode::FADE_OUT || this->input_done_) {
+    return 0;
+  }
+
+  const size_t capacity = this->fifo_.size();
+  // only block if there is nothing to output, otherwise take what's available
+  bool wait = this->mode_ == CrossfadeMode::PASS && this->fill_ < (size_t) frame_size;
+  while (this->fill_ < capacity) {
+    const size_t pos = (this->head_ + this->fill_) % capacity;
+    const size_t span = std::min(capacity - this->fill_, capacity - pos);
+    audio_element_set_input_timeout(this->adf_element_, wait ? pdMS_TO_TICKS(CROSSFADE_INPUT_WAIT_MS) : 0);
+    const int read = this->read_input_((char *) this->fifo_.data() + pos, span);
+    wait = false;
+    if (read > 0) {
+      this->fill_ += read;
+      if ((size_t) read < span) {
+        break;
+      }
+      continue;
+    }
+    if (read == AEL_IO_TIMEOUT) {
+      break;
+    }
+    if (read == AEL_IO_ABORT && this->released_ != this->requested_) {
+      // the outgoing source has been stopped for a track change, its ring buffer gets reset
+      this->input_held_ = true;
+      break;
+    }
+    if (read == AEL_IO_OK || read == AEL_IO_DONE) {
+      this->input_done_ = true;
+      break;
+    }
+    return read;
+  }
+  return 0;
+}
+
+template<typename T> void ADFCrossfade::fade_in_place_(T *samples, size_t num_frames) {
+  const int channels = this->in_format_.channels;
+  for (size_t start = 0; start < num_frames && this->fade_in_pos_ < this->fade_in_frames_;
+       start += FADE_BLOCK_FRAMES) {
+    const size_t frames = std::min(FADE_BLOCK_FRAMES, num_frames - start);
+    T *block = samples + start * channels;
+    audio_mix_ramp(block, block, fade_gain(this->fade_in_pos_, this->fade_in_frames_),
+                   fade_gain(this->fade_in_pos_ + frames, this->fade_in_frames_), nullptr, 0, 0, frames, channels,
+                   FADE_SHIFT);
+    this->fade_in_pos_ += frames;
+  }
+}
+
+int ADFCrossfade::output_pass_(int frame_size, int len) {
+  const size_t capacity = this->fifo_.size();
+  size_t bytes = std::min(this->fill_ - this->fill_ % frame_size, (size_t) (len - len % frame_size));
+  // head_ and the capacity are frame aligned, so frames never wrap around
+  bytes = std::min(bytes, capacity - this->head_);
+  if (bytes == 0) {
+    return 0;
+  }
+
+  uint8_t *data = this->fifo_.data() + this->head_;
+  if (this->fade_in_pos_ < this->fade_in_frames_) {
+    const uint32_t start = esp_cpu_get_ccount();
+    if (this->in_format_.bits == 16) {
+      this->fade_in_place_<int16_t>((int16_t *) data, bytes / frame_size);
+    } else {
+      this->fade_in_place_<int32_t>((int32_t *) data, bytes / frame_size);
+    }
+    this->process_cycles_ += esp_cpu_get_ccount() - start;
+  }
+  this->processed_frames_ += bytes / frame_size;
+
+  const int written = this->write_output_((char *) data, bytes);
+  if (written > 0) {
+    this->head_ = (this->head_ + written) % capacity;
+    this->fill_ -= written;
+  }
+  return written;
+}
+
+int ADFCrossfade::output_fade_(char *buffer, int frame_size, int len) {
+  const size_t capacity = this->fifo_.size();
+  const int channels = this->in_format_.channels;
+  const size_t max_frames = len / frame_size;
+  size_t out_frames = 0;
+
+  const uint32_t start = esp_cpu_get_ccount();
+  while (out_frames < max_frames && this->tail_bytes_ > 0) {
+    size_t frames = std::min({FADE_BLOCK_FRAMES, max_frames - out_frames, this->tail_bytes_ / frame_size,
+                              (capacity - this->head_) / frame_size});
+    // the incoming track is mixed in as soon as it arrives, until then the tail fades out alone
+    const uint8_t *incoming = nullptr;
+    if (this->mode_ == CrossfadeMode::CROSSFADE) {
+      const size_t available = (this->fill_ - this->tail_bytes_ - this->incoming_consumed_) / frame_size;
+      if (available > 0) {
+        const size_t pos = (this->head_ + this->tail_bytes_ + this->incoming_consumed_) % capacity;
+        frames = std::min({frames, available, (capacity - pos) / frame_size});
+        incoming = this->fifo_.data() + pos;
+      }
+    }
+
+    const size_t out_pos = this->fade_out_frames_ - this->fade_out_pos_;
+    const int32_t out_from = fade_gain(out_pos, this->fade_out_frames_);
+    const int32_t out_to = fade_gain(out_pos - frames, this->fade_out_frames_);
+    int32_t in_from = 0;
+    int32_t in_to = 0;
+    if (incoming != nullptr) {
+      in_from = fade_gain(this->fade_in_pos_, this->fade_in_frames_);
+      in_to = fade_gain(this->fade_in_pos_ + frames, this->fade_in_frames_);
+    }
+    char *dst = buffer + out_frames * frame_size;
+    const uint8_t *tail = this->fifo_.data() + this->head_;
+    if (this->in_format_.bits == 16) {
+      audio_mix_ramp_s16((int16_t *) dst, (const int16_t *) tail, out_from, out_to, (const int16_t *) incoming,
+                         in_from, in_to, frames, channels, FADE_SHIFT);
+    } else {
+      audio_mix_ramp_s32((int32_t *) dst, (const int32_t *) tail, out_from, out_to, (const int32_t *) incoming,
+                         in_from, in_to, frames, channels, FADE_SHIFT);
+    }
+
+    const size_t bytes = frames * frame_size;
+    this->head_ = (this->head_ + bytes) % capacity;
+    this->fill_ -= bytes;
+    this->tail_bytes_ -= bytes;
+    this->fade_out_pos_ += frames;
+    if (incoming != nullptr) {
+      this->incoming_consumed_ += bytes;
+      this->fade_in_pos_ += frames;
+    }
+    out_frames += frames;
+  }
+  this->process_cycles_ += esp_cpu_get_ccount() - start;
+  this->processed_frames_ += out_frames;
+
+  if (this->tail_bytes_ == 0) {
+    if (this->mode_ == CrossfadeMode::CROSSFADE) {
+      // continue with the incoming track, its fade in is finished by output_pass_ if still running
+      this->head_ = (this->head_ + this->incoming_consumed_) % capacity;
+      this->fill_ -= this->incoming_consumed_;
+      this->incoming_consumed_ = 0;
+      this->mode_ = CrossfadeMode::PASS;
+    } else {
+      this->head_ = 0;
+      this->faded_out_ = true;
+    }
+  }
+  if (out_frames == 0) {
+    return 0;
+  }
+  return this->write_output_(buffer, out_frames * frame_size);
+}
+
+int ADFCrossfade::process_(char *buffer, int len) {
+  const int frame_size = this->bytes_per_frame_(this->in_format_);
+  this->handle_request_(frame_size);
+  const int ret = this->fill_fifo_(frame_size);
+  if (ret < 0) {
+    return ret;
+  }
+
+  const int written = this->mode_ == CrossfadeMode::PASS ? this->output_pass_(frame_size, len)
+                                                         : this->output_fade_(buffer, frame_size, len);
+  if (written != 0) {
+    return written;
+  }
+  if (this->mode_ == CrossfadeMode::PASS && this->input_done_ && this->fill_ < (size_t) frame_size) {
+    return AEL_IO_DONE;
+  }
+  if (this->input_held_ || this->mode_ == CrossfadeMode::FADE_OUT) {
+    // nothing to read or write until the main loop continues
+    vTaskDelay(pdMS_TO_TICKS(CROSSFADE_INPUT_WAIT_MS));
+  }
+  return AEL_IO_TIMEOUT;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
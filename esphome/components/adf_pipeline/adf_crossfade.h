@@ -0,0 +1,91 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+
+namespace esphome {
+namespace esp_adf {
+
+enum class CrossfadeRequest : uint8_t { NONE = 0, CROSSFADE, FADE_OUT };
+
+/*
+Crossfade for track changes and fades at start and stop, placed directly after the media player's
+decoder. The element reads ahead of the sink into a FIFO of up to duration, as far as the source
+delivers faster than real time. On a track change only the source is restarted, the buffered rest
+of the outgoing track becomes the tail, which is faded out while the incoming track is faded in
+and mixed onto it (equal power). While the incoming stream connects, the tail keeps feeding the
+sink, so the pipeline never stops. Tracks are only mixed if they share the format.
+*/
+class ADFCrossfade : public ADFPCMProcessElement, public Component {
+ public:
+  ADFCrossfade();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "Crossfade"; }
+
+  void set_duration(uint32_t duration_ms) { this->duration_ms_ = duration_ms; }
+
+  // called from the main loop before the source is restarted, the following input is the incoming track
+  void start_crossfade();
+  // called from the main loop once the source has been restarted and its ring buffers are reset
+  void release_input() { this->released_ = this->requested_.load(); }
+  // called from the main loop before the pipeline is stopped, is_faded_out() is set once done
+  void start_fade_out();
+  bool is_faded_out() const { return this->faded_out_; }
+
+ protected:
+  enum class CrossfadeMode : uint8_t { PASS = 0, CROSSFADE, FADE_OUT };
+
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  // the frames of the old format in the fifo are played out before the format changes
+  bool format_switch_ready_() override { return this->fill_ < (size_t) this->bytes_per_frame_(this->in_format_); }
+  esp_err_t open_() override;
+  int process_(char *buffer, int len) override;
+
+  void clear_fifo_();
+  void handle_request_(int frame_size);
+  int fill_fifo_(int frame_size);
+  int output_pass_(int frame_size, int len);
+  int output_fade_(char *buffer, int frame_size, int len);
+  template<typename T> void fade_in_place_(T *samples, size_t num_frames);
+
+  uint32_t duration_ms_{1000};
+  pcm_format format_{16000, 16, 2};
+
+  std::atomic<CrossfadeRequest> request_{CrossfadeRequest::NONE};
+  // the input is held after the outgoing source got aborted, until released_ catches up with requested_
+  std::atomic<uint32_t> requested_{0};
+  std::atomic<uint32_t> released_{0};
+  std::atomic<bool> faded_out_{false};
+
+  // only accessed from the element's task
+  std::vector<uint8_t> fifo_;
+  // byte offset of the oldest frame and number of valid bytes from there, may end with a partial frame
+  size_t head_{0};
+  size_t fill_{0};
+  CrossfadeMode mode_{CrossfadeMode::PASS};
+  // the tail of the outgoing track starts at head_, the consumed part of the incoming track follows it
+  size_t tail_bytes_{0};
+  size_t incoming_consumed_{0};
+  size_t fade_out_pos_{0};
+  size_t fade_out_frames_{0};
+  size_t fade_in_pos_{0};
+  size_t fade_in_frames_{0};
+  size_t edge_frames_{0};
+  bool input_held_{false};
+  bool input_done_{false};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
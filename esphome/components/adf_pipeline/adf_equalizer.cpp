@@ -0,0 +1,185 @@
+#include "adf_equalizer.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <cmath>
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_eq";
+
+// coefficients in Q27 cover +-16, enough for shelves and peaks up to +-15dB
+static const int EQ_COEF_SHIFT = 27;
+// 16-bit samples are shifted into Q30, leaving one bit headroom for boosts
+static const int EQ_SAMPLE_SHIFT_16 = 14;
+
+static const LogString *band_type_to_string(EqBandType type) {
+  switch (type) {
+    case EqBandType::PEAKING:
+      return LOG_STR("peaking");
+    case EqBandType::LOW_SHELF:
+      return LOG_STR("low_shelf");
+    case EqBandType::HIGH_SHELF:
+      return LOG_STR("high_shelf");
+    case EqBandType::LOW_PASS:
+      return LOG_STR("low_pass");
+    case EqBandType::HIGH_PASS:
+      return LOG_STR("high_pass");
+    default:
+      return LOG_STR("unknown");
+  }
+}
+
+// RBJ audio EQ cookbook, normalized by a0
+static std::array<int32_t, 5> calc_coefficients(const EqBand &band, int rate) {
+  const double w0 = 2. * M_PI * band.frequency / rate;
+  const double cos_w0 = cos(w0);
+  const double alpha = sin(w0) / (2. * band.q);
+  const double a = pow(10., band.gain_db / 40.);
+  const double sqrt_a_alpha = 2. * sqrt(a) * alpha;
+  double b0, b1, b2, a0, a1, a2;
+  switch (band.type) {
+    case EqBandType::LOW_SHELF:
+      b0 = a * ((a + 1) - (a - 1) * cos_w0 + sqrt_a_alpha);
+      b1 = 2 * a * ((a - 1) - (a + 1) * cos_w0);
+      b2 = a * ((a + 1) - (a - 1) * cos_w0 - sqrt_a_alpha);
+      a0 = (a + 1) + (a - 1) * cos_w0 + sqrt_a_alpha;
+      a1 = -2 * ((a - 1) + (a + 1) * cos_w0);
+      a2 = (a + 1) + (a - 1) * cos_w0 - sqrt_a_alpha;
+      break;
+    case EqBandType::HIGH_SHELF:
+      b0 = a * ((a + 1) + (a - 1) * cos_w0 + sqrt_a_alpha);
+      b1 = -2 * a * ((a - 1) + (a + 1) * cos_w0);
+      b2 = a * ((a + 1) + (a - 1) * cos_w0 - sqrt_a_alpha);
+      a0 = (a + 1) - (a - 1) * cos_w0 + sqrt_a_alpha;
+      a1 = 2 * ((a - 1) - (a + 1) * cos_w0);
+      a2 = (a + 1) - (a - 1) * cos_w0 - sqrt_a_alpha;
+      break;
+    case EqBandType::LOW_PASS:
+      b0 = (1 - cos_w0) / 2;
+      b1 = 1 - cos_w0;
+      b2 = (1 - cos_w0) / 2;
+      a0 = 1 + alpha;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha;
+      break;
+    case EqBandType::HIGH_PASS:
+      b0 = (1 + cos_w0) / 2;
+      b1 = -(1 + cos_w0);
+      b2 = (1 + cos_w0) / 2;
+      a0 = 1 + alpha;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha;
+      break;
+    case EqBandType::PEAKING:
+    default:
+      b0 = 1 + alpha * a;
+      b1 = -2 * cos_w0;
+      b2 = 1 - alpha * a;
+      a0 = 1 + alpha / a;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha / a;
+      break;
+  }
+  const double scale = (double) (1 << EQ_COEF_SHIFT) / a0;
+  return {(int32_t) lround(b0 * scale), (int32_t) lround(b1 * scale), (int32_t) lround(b2 * scale),
+          (int32_t) lround(a1 * scale), (int32_t) lround(a2 * scale)};
+}
+
+ADFEqualizer::ADFEqualizer() {
+  this->element_tag_ = "equalizer";
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFEqualizer::dump_config() {
+  esph_log_config(TAG, "Equalizer:");
+  for (auto &band : this->bands_) {
+    esph_log_config(TAG, "  %s: %.0f Hz, gain: %.1f dB, Q: %.2f", LOG_STR_ARG(band_type_to_string(band.type)),
+                    band.frequency, band.gain_db, band.q);
+  }
+}
+
+void ADFEqualizer::add_band(EqBandType type, float frequency, float gain_db, float q) {
+  this->bands_.push_back({type, frequency, gain_db, q});
+}
+
+void ADFEqualizer::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFEqualizer::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->coeffs_.clear();
+  for (auto &band : this->bands_) {
+    if (band.frequency >= in_format.rate / 2) {
+      esph_log_w(TAG, "Skipping %.0f Hz band, above Nyquist frequency at %d Hz.", band.frequency, in_format.rate);
+      continue;
+    }
+    const std::array<int32_t, 5> coeffs = calc_coefficients(band, in_format.rate);
+    this->coeffs_.insert(this->coeffs_.end(), coeffs.begin(), coeffs.end());
+  }
+  this->state_.assign(this->coeffs_.size() / 5 * in_format.channels * 4, 0);
+  if (in_format.bits == 16) {
+    this->work_.resize(this->buffer_len_ / sizeof(int16_t));
+  } else {
+    this->work_.clear();
+  }
+  return true;
+}
+
+int ADFEqualizer::process_pcm_(uint8_t *data, int len) {
+  if (this->coeffs_.empty()) {
+    return len;
+  }
+  const int channels = this->in_format_.channels;
+  int32_t *samples;
+  size_t num_samples;
+  if (this->in_format_.bits == 16) {
+    const int16_t *src = (const int16_t *) data;
+    num_samples = len / sizeof(int16_t);
+    samples = this->work_.data();
+    for (size_t i = 0; i < num_samples; i++) {
+      samples[i] = (int32_t) src[i] << EQ_SAMPLE_SHIFT_16;
+    }
+  } else {
+    num_samples = len / sizeof(int32_t);
+    samples = (int32_t *) data;
+    for (size_t i = 0; i < num_samples; i++) {
+      samples[i] >>= 1;
+    }
+  }
+
+  audio_biquad_cascade_s32(samples, num_samples / channels, channels, this->coeffs_.data(), this->state_.data(),
+                           this->coeffs_.size() / 5, EQ_COEF_SHIFT);
+
+  if (this->in_format_.bits == 16) {
+    int16_t *dst = (int16_t *) data;
+    for (size_t i = 0; i < num_samples; i++) {
+      dst[i] = audio_sat_s16(samples[i] >> EQ_SAMPLE_SHIFT_16);
+    }
+  } else {
+    for (size_t i = 0; i < num_samples; i++) {
+      samples[i] = audio_sat_s32((int64_t) samples[i] << 1);
+    }
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <array>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+
+namespace esphome {
+namespace esp_adf {
+
+enum class EqBandType : uint8_t { PEAKING = 0, LOW_SHELF, HIGH_SHELF, LOW_PASS, HIGH_PASS };
+
+struct EqBand {
+  EqBandType type;
+  float frequency;
+  float gain_db;
+  float q;
+};
+
+/*
+Parametric equalizer, a cascade of biquad filters processing the stream in place.
+Coefficients are calculated for the negotiated sampling rate when the format changes,
+filtering itself is done in fixed point (Q27 coefficients, Q30 samples, 64-bit accumulator) by
+audio_biquad_cascade_s32, with the channels as independent lanes.
+*/
+class ADFEqualizer : public ADFPCMProcessElement, public Component {
+ public:
+  ADFEqualizer();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "Equalizer"; }
+
+  void add_band(EqBandType type, float frequency, float gain_db, float q);
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  std::vector<EqBand> bands_;
+  pcm_format format_{16000, 16, 2};
+
+  // only accessed from the element's task
+  // per band: b0, b1, b2, a1, a2
+  std::vector<int32_t> coeffs_;
+  // per band and channel: x1, x2, y1, y2
+  std::vector<int32_t> state_;
+  std::vector<int32_t> work_;
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
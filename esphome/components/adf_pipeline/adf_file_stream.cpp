@@ -0,0 +1,578 @@
+#include "adf_file_stream.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cstring>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_file";
+
+static const int FILE_ELEMENT_BUFFER_SIZE = 1024;
+static const int FILE_RINGBUFFER_SIZE = 4 * 1024;
+static const int FILE_ELEMENT_TASK_STACK = 3 * 1024;
+static const int FILE_ELEMENT_TASK_PRIO = 5;
+static const int FILE_ELEMENT_TASK_CORE = 0;
+// below the audio elements, the blocks give the storage enough time to catch up
+static const int FILE_IO_TASK_STACK = 3 * 1024;
+static const int FILE_IO_TASK_PRIO = 4;
+static const int FILE_IO_TASK_CORE = 0;
+// waiting time for the next block when reading, before the element reports a timeout
+static const TickType_t FILE_READ_TICKS = 20 / portTICK_PERIOD_MS;
+
+static const size_t WAV_HEADER_SIZE = 44;
+static const uint16_t WAV_FORMAT_PCM = 1;
+static const uint16_t WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+
+static const char *file_format_to_string(FileFormat file_format) {
+  return file_format == FileFormat::WAV ? "wav" : "raw";
+}
+
+static void put_le16(uint8_t *dst, uint16_t value) {
+  dst[0] = value & 0xFF;
+  dst[1] = value >> 8;
+}
+
+static void put_le32(uint8_t *dst, uint32_t value) {
+  put_le16(dst, value & 0xFFFF);
+  put_le16(dst + 2, value >> 16);
+}
+
+static uint16_t get_le16(const uint8_t *src) { return src[0] | (src[1] << 8); }
+
+static uint32_t get_le32(const uint8_t *src) { return get_le16(src) | ((uint32_t) get_le16(src + 2) << 16); }
+
+// canonical header of a PCM WAV file, 24 bit samples are stored in their 32 bit containers
+static void make_wav_header(uint8_t *header, const pcm_format &format, uint32_t data_size) {
+  const uint16_t container_bits = format.bits > 16 ? 32 : 16;
+  const uint16_t block_align = container_bits / 8 * format.channels;
+  memcpy(header, "RIFF", 4);
+  put_le32(header + 4, WAV_HEADER_SIZE - 8 + data_size);
+  memcpy(header + 8, "WAVEfmt ", 8);
+  put_le32(header + 16, 16);
+  put_le16(header + 20, WAV_FORMAT_PCM);
+  put_le16(header + 22, format.channels);
+  put_le32(header + 24, format.rate);
+  put_le32(header + 28, format.rate * block_align);
+  put_le16(header + 32, block_align);
+  put_le16(header + 34, container_bits);
+  memcpy(header + 36, "data", 4);
+  put_le32(header + 40, data_size);
+}
+
+/*
+FileBlockQueue
+*/
+
+bool FileBlockQueue::start(FILE *file, bool writing, size_t block_size, size_t limit) {
+  if (this->filled_ == nullptr) {
+    // the end of the stream is signalled with an additional empty block
+    this->filled_ = xQueueCreate(3, sizeof(Block));
+    this->free_ = xQueueCreate(3, sizeof(Block));
+    this->done_ = xSemaphoreCreateBinary();
+  }
+  if (block_size != this->block_size_) {
+    this->free_buffers_();
+    ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+    for (auto &buffer : this->buffers_) {
+      buffer = allocator.allocate(block_size);
+      if (buffer == nullptr) {
+        esph_log_e(TAG, "Couldn't allocate %u bytes for the file buffers", (unsigned) block_size);
+        this->free_buffers_();
+        return false;
+      }
+    }
+    this->block_size_ = block_size;
+  }
+
+  xQueueReset(this->filled_);
+  xQueueReset(this->free_);
+  xSemaphoreTake(this->done_, 0);
+  for (auto *buffer : this->buffers_) {
+    Block block{buffer, 0};
+    xQueueSend(this->free_, &block, 0);
+  }
+  this->file_ = file;
+  this->writing_ = writing;
+  this->remaining_ = limit;
+  this->current_ = {nullptr, 0};
+  this->pos_ = 0;
+  this->dropped_bytes_ = 0;
+  this->io_errors_ = 0;
+
+  if (xTaskCreatePinnedToCore(FileBlockQueue::io_task_, "file_io", FILE_IO_TASK_STACK, this, FILE_IO_TASK_PRIO,
+                              nullptr, FILE_IO_TASK_CORE) != pdPASS) {
+    esph_log_e(TAG, "Couldn't create the file I/O task");
+    this->file_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void FileBlockQueue::stop() {
+  if (this->file_ == nullptr) {
+    return;
+  }
+  const Block end{nullptr, 0};
+  if (this->writing_) {
+    if (this->current_.data != nullptr && this->current_.len > 0) {
+      xQueueSend(this->filled_, &this->current_, portMAX_DELAY);
+    }
+    xQueueSend(this->filled_, &end, portMAX_DELAY);
+  } else {
+    xQueueSend(this->free_, &end, portMAX_DELAY);
+  }
+  xSemaphoreTake(this->done_, portMAX_DELAY);
+  this->current_ = {nullptr, 0};
+  this->file_ = nullptr;
+}
+
+void FileBlockQueue::free_buffers_() {
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  for (auto &buffer : this->buffers_) {
+    if (buffer != nullptr) {
+      allocator.deallocate(buffer, this->block_size_);
+      buffer = nullptr;
+    }
+  }
+  this->block_size_ = 0;
+}
+
+void FileBlockQueue::io_task_(void *params) {
+  FileBlockQueue *this_ = (FileBlockQueue *) params;
+  Block block;
+  if (this_->writing_) {
+    while (xQueueReceive(this_->filled_, &block, portMAX_DELAY) == pdTRUE && block.data != nullptr) {
+      if (fwrite(block.data, 1, block.len, this_->file_) != block.len) {
+        this_->io_errors_++;
+      }
+      block.len = 0;
+      xQueueSend(this_->free_, &block, portMAX_DELAY);
+    }
+  } else {
+    while (xQueueReceive(this_->free_, &block, portMAX_DELAY) == pdTRUE && block.data != nullptr) {
+      const size_t len = std::min(this_->block_size_, this_->remaining_);
+      block.len = len > 0 ? fread(block.data, 1, len, this_->file_) : 0;
+      if (block.len < len && ferror(this_->file_)) {
+        this_->io_errors_++;
+      }
+      this_->remaining_ -= block.len;
+      xQueueSend(this_->filled_, &block, portMAX_DELAY);
+      if (block.len == 0) {
+        break;  // end of file
+      }
+    }
+  }
+  xSemaphoreGive(this_->done_);
+  vTaskDelete(nullptr);
+}
+
+size_t FileBlockQueue::write(const uint8_t *data, size_t len) {
+  size_t accepted = 0;
+  while (accepted < len) {
+    if (this->current_.data == nullptr && xQueueReceive(this->free_, &this->current_, 0) != pdTRUE) {
+      // both blocks are still waiting for the storage
+      this->dropped_bytes_ += len - accepted;
+      break;
+    }
+    const size_t n = std::min(len - accepted, this->block_size_ - this->current_.len);
+    memcpy(this->current_.data + this->current_.len, data + accepted, n);
+    this->current_.len += n;
+    accepted += n;
+    if (this->current_.len == this->block_size_) {
+      xQueueSend(this->filled_, &this->current_, 0);
+      this->current_ = {nullptr, 0};
+    }
+  }
+  return accepted;
+}
+
+int FileBlockQueue::read(uint8_t *data, size_t len, TickType_t ticks) {
+  if (this->current_.data == nullptr) {
+    if (xQueueReceive(this->filled_, &this->current_, ticks) != pdTRUE) {
+      return -1;
+    }
+    this->pos_ = 0;
+  }
+  // the empty block at the end of the file is kept, every further read returns 0
+  const size_t n = std::min(len, this->current_.len - this->pos_);
+  memcpy(data, this->current_.data + this->pos_, n);
+  this->pos_ += n;
+  if (this->current_.len > 0 && this->pos_ == this->current_.len) {
+    this->current_.len = 0;
+    xQueueSend(this->free_, &this->current_, 0);
+    this->current_ = {nullptr, 0};
+  }
+  return n;
+}
+
+/*
+ADFFileSource
+*/
+
+void ADFFileSource::dump_config() {
+  esph_log_config(TAG, "File Source:");
+  esph_log_config(TAG, "  path: %s, format: %s", this->path_.c_str(), file_format_to_string(this->file_format_));
+  if (this->file_format_ == FileFormat::RAW) {
+    esph_log_config(TAG, "  rate: %d, bits: %d, ch: %d", this->raw_format_.rate, this->raw_format_.bits,
+                    this->raw_format_.channels);
+  }
+  esph_log_config(TAG, "  buffers: 2 x %u bytes", (unsigned) this->buffer_size_);
+}
+
+void ADFFileSource::play(const std::string &path) {
+  if (this->pipeline_ == nullptr) {
+    esph_log_e(TAG, "File source is not part of a pipeline.");
+    return;
+  }
+  if (!path.empty()) {
+    this->path_ = path;
+  }
+  if (this->pipeline_->getState() == PipelineState::RUNNING) {
+    esph_log_w(TAG, "Already playing, stop the pipeline first.");
+    return;
+  }
+  this->valid_settings_ = false;
+  this->pipeline_->start();
+}
+
+bool ADFFileSource::read_header_() {
+  this->data_offset_ = 0;
+  this->data_size_ = SIZE_MAX;
+  if (this->file_format_ == FileFormat::RAW) {
+    this->format_ = this->raw_format_;
+    this->file_sample_bytes_ = this->format_.bits > 16 ? 4 : 2;
+    return true;
+  }
+
+  FILE *file = fopen(this->path_.c_str(), "rb");
+  if (file == nullptr) {
+    esph_log_e(TAG, "Couldn't open %s", this->path_.c_str());
+    return false;
+  }
+  uint8_t chunk[24];
+  bool valid = fread(chunk, 1, 12, file) == 12 && memcmp(chunk, "RIFF", 4) == 0 && memcmp(chunk + 8, "WAVE", 4) == 0;
+  bool has_format = false;
+  while (valid && fread(chunk, 1, 8, file) == 8) {
+    const uint32_t chunk_size = get_le32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16) {
+      valid = fread(chunk, 1, 16, file) == 16 && fseek(file, chunk_size - 16 + (chunk_size & 1), SEEK_CUR) == 0;
+      const uint16_t tag = get_le16(chunk);
+      const int bits = get_le16(chunk + 14);
+      this->format_ = {(int) get_le32(chunk + 4), bits, get_le16(chunk + 2)};
+      this->file_sample_bytes_ = (bits + 7) / 8;
+      has_format = valid && (tag == WAV_FORMAT_PCM || tag == WAV_FORMAT_EXTENSIBLE);
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      this->data_offset_ = ftell(file);
+      this->data_size_ = chunk_size;
+      break;
+    } else {
+      // chunks are padded to an even size
+      valid = fseek(file, chunk_size + (chunk_size & 1), SEEK_CUR) == 0;
+    }
+  }
+  fclose(file);
+
+  if (!has_format || this->data_offset_ == 0) {
+    esph_log_e(TAG, "%s is not a PCM WAV file", this->path_.c_str());
+    return false;
+  }
+  if (this->format_.bits != 16 && this->format_.bits != 24 && this->format_.bits != 32) {
+    esph_log_e(TAG, "Unsupported bits per sample: %d", this->format_.bits);
+    return false;
+  }
+  esph_log_d(TAG, "%s: rate: %d, bits: %d, ch: %d, %u bytes", this->path_.c_str(), this->format_.rate,
+             this->format_.bits, this->format_.channels, (unsigned) this->data_size_);
+  return true;
+}
+
+bool ADFFileSource::is_ready() {
+  if (!this->valid_settings_) {
+    if (!this->read_header_()) {
+      return false;
+    }
+    AudioPipelineSettingsRequest request{this};
+    request.sampling_rate = this->format_.rate;
+    request.bit_depth = this->format_.bits;
+    request.number_of_channels = this->format_.channels;
+    this->valid_settings_ = this->pipeline_->request_settings(request);
+    if (this->adf_file_reader_ != nullptr) {
+      audio_element_set_music_info(this->adf_file_reader_, this->format_.rate, this->format_.channels,
+                                   this->format_.bits);
+    }
+  }
+  return this->valid_settings_;
+}
+
+bool ADFFileSource::init_adf_elements_() {
+  if (this->sdk_audio_elements_.size() > 0)
+    return true;
+
+  audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+  cfg.open = ADFFileSource::adf_open_;
+  cfg.close = ADFFileSource::adf_close_;
+  cfg.process = ADFFileSource::adf_process_;
+  cfg.buffer_len = FILE_ELEMENT_BUFFER_SIZE;
+  cfg.out_rb_size = FILE_RINGBUFFER_SIZE;
+  cfg.task_stack = FILE_ELEMENT_TASK_STACK;
+  cfg.task_prio = FILE_ELEMENT_TASK_PRIO;
+  cfg.task_core = FILE_ELEMENT_TASK_CORE;
+  cfg.tag = "file_reader";
+
+  this->adf_file_reader_ = audio_element_init(&cfg);
+  if (this->adf_file_reader_ == nullptr) {
+    esph_log_e(TAG, "Couldn't create file reader element.");
+    return false;
+  }
+  audio_element_setdata(this->adf_file_reader_, this);
+  audio_element_set_music_info(this->adf_file_reader_, this->format_.rate, this->format_.channels,
+                               this->format_.bits);
+
+  this->sdk_audio_elements_.push_back(this->adf_file_reader_);
+  this->sdk_element_tags_.push_back("file_reader");
+  return true;
+}
+
+void ADFFileSource::clear_adf_elements_() {
+  this->adf_file_reader_ = nullptr;
+  this->sdk_audio_elements_.clear();
+  this->sdk_element_tags_.clear();
+  this->valid_settings_ = false;
+}
+
+esp_err_t ADFFileSource::adf_open_(audio_element_handle_t self) {
+  ADFFileSource *this_ = (ADFFileSource *) audio_element_getdata(self);
+  this_->file_ = fopen(this_->path_.c_str(), "rb");
+  if (this_->file_ == nullptr || fseek(this_->file_, this_->data_offset_, SEEK_SET) != 0) {
+    esph_log_e(TAG, "Couldn't open %s", this_->path_.c_str());
+    return ESP_FAIL;
+  }
+  this_->underruns_ = 0;
+  if (!this_->blocks_.start(this_->file_, false, this_->buffer_size_, this_->data_size_)) {
+    fclose(this_->file_);
+    this_->file_ = nullptr;
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+esp_err_t ADFFileSource::adf_close_(audio_element_handle_t self) {
+  ADFFileSource *this_ = (ADFFileSource *) audio_element_getdata(self);
+  if (this_->file_ == nullptr) {
+    return ESP_OK;
+  }
+  this_->blocks_.stop();
+  fclose(this_->file_);
+  this_->file_ = nullptr;
+  if (this_->underruns_ > 0 || this_->blocks_.get_io_errors() > 0) {
+    esph_log_w(TAG, "Storage too slow %u times, read errors: %u", (unsigned) this_->underruns_,
+               (unsigned) this_->blocks_.get_io_errors());
+  }
+  return ESP_OK;
+}
+
+audio_element_err_t ADFFileSource::adf_process_(audio_element_handle_t self, char *buffer, int len) {
+  ADFFileSource *this_ = (ADFFileSource *) audio_element_getdata(self);
+  const bool packed_24 = this_->file_sample_bytes_ == 3;
+  // packed 24 bit samples are read into the end of the buffer and expanded towards its start
+  const int num_samples = packed_24 ? len / 4 : len;
+  const int want = packed_24 ? num_samples * 3 : len;
+  uint8_t *dst = (uint8_t *) buffer + (packed_24 ? len - want : 0);
+
+  int got = 0;
+  bool timeout = false;
+  while (got < want) {
+    const int n = this_->blocks_.read(dst + got, want - got, FILE_READ_TICKS);
+    if (n == 0) {
+      break;  // end of file
+    }
+    if (n < 0) {
+      if (got % this_->file_sample_bytes_ == 0) {
+        timeout = true;
+        break;
+      }
+      continue;  // complete the sample, it's split across two blocks
+    }
+    got += n;
+  }
+  if (got == 0) {
+    if (timeout) {
+      this_->underruns_++;
+      return AEL_IO_TIMEOUT;
+    }
+    return AEL_IO_DONE;
+  }
+
+  // a truncated sample at the end of the file is dropped
+  int out_len = got - got % this_->file_sample_bytes_;
+  if (packed_24) {
+    const int samples = got / 3;
+    int32_t *out = (int32_t *) buffer;
+    for (int i = 0; i < samples; i++) {
+      const uint8_t *s = dst + 3 * i;
+      out[i] = (int32_t) (((uint32_t) s[0] << 8) | ((uint32_t) s[1] << 16) | ((uint32_t) s[2] << 24));
+    }
+    out_len = samples * 4;
+  }
+  if (out_len == 0) {
+    return AEL_IO_DONE;
+  }
+  return (audio_element_err_t) audio_element_output(self, buffer, out_len);
+}
+
+/*
+ADFFileSink
+*/
+
+void ADFFileSink::dump_config() {
+  esph_log_config(TAG, "File Sink:");
+  esph_log_config(TAG, "  path: %s, format: %s", this->path_.c_str(), file_format_to_string(this->file_format_));
+  if (this->requested_format_.rate > 0 || this->requested_format_.bits > 0 || this->requested_format_.channels > 0) {
+    esph_log_config(TAG, "  requested rate: %d, bits: %d, ch: %d", this->requested_format_.rate,
+                    this->requested_format_.bits, this->requested_format_.channels);
+  }
+  esph_log_config(TAG, "  buffers: 2 x %u bytes", (unsigned) this->buffer_size_);
+}
+
+void ADFFileSink::record(const std::string &path) {
+  if (this->pipeline_ == nullptr) {
+    esph_log_e(TAG, "File sink is not part of a pipeline.");
+    return;
+  }
+  if (!path.empty()) {
+    this->path_ = path;
+  }
+  if (this->pipeline_->getState() == PipelineState::RUNNING) {
+    esph_log_w(TAG, "Already recording, stop the pipeline first.");
+    return;
+  }
+  this->pipeline_->start();
+}
+
+void ADFFileSink::stop() {
+  if (this->pipeline_ != nullptr) {
+    this->pipeline_->stop();
+  }
+}
+
+void ADFFileSink::on_settings_request(AudioPipelineSettingsRequest &request) {
+  if (request.final_sampling_rate == -1) {
+    pcm_format format = this->format_;
+    format.rate = request.sampling_rate > 0 ? request.sampling_rate : format.rate;
+    format.bits = request.bit_depth > 0 ? request.bit_depth : format.bits;
+    format.channels = request.number_of_channels > 0 ? request.number_of_channels : format.channels;
+    // a configured format has to be provided by the converters in the pipeline
+    format.rate = this->requested_format_.rate > 0 ? this->requested_format_.rate : format.rate;
+    format.bits = this->requested_format_.bits > 0 ? this->requested_format_.bits : format.bits;
+    format.channels = this->requested_format_.channels > 0 ? this->requested_format_.channels : format.channels;
+    request.final_sampling_rate = format.rate;
+    request.final_bit_depth = format.bits;
+    request.final_number_of_channels = format.channels;
+  }
+  if (request.final_bit_depth != 16 && request.final_bit_depth != 24 && request.final_bit_depth != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  this->format_ = {request.final_sampling_rate, request.final_bit_depth, request.final_number_of_channels};
+  esph_log_d(TAG, "Recording format: rate: %d, bits: %d, ch: %d", this->format_.rate, this->format_.bits,
+             this->format_.channels);
+}
+
+bool ADFFileSink::init_adf_elements_() {
+  if (this->sdk_audio_elements_.size() > 0)
+    return true;
+
+  audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+  cfg.open = ADFFileSink::adf_open_;
+  cfg.close = ADFFileSink::adf_close_;
+  cfg.process = ADFFileSink::adf_process_;
+  cfg.buffer_len = FILE_ELEMENT_BUFFER_SIZE;
+  cfg.out_rb_size = 0;
+  cfg.task_stack = FILE_ELEMENT_TASK_STACK;
+  cfg.task_prio = FILE_ELEMENT_TASK_PRIO;
+  cfg.task_core = FILE_ELEMENT_TASK_CORE;
+  cfg.tag = "file_writer";
+
+  this->adf_file_writer_ = audio_element_init(&cfg);
+  if (this->adf_file_writer_ == nullptr) {
+    esph_log_e(TAG, "Couldn't create file writer element.");
+    return false;
+  }
+  audio_element_setdata(this->adf_file_writer_, this);
+
+  this->sdk_audio_elements_.push_back(this->adf_file_writer_);
+  this->sdk_element_tags_.push_back("file_writer");
+  return true;
+}
+
+void ADFFileSink::clear_adf_elements_() {
+  this->adf_file_writer_ = nullptr;
+  this->sdk_audio_elements_.clear();
+  this->sdk_element_tags_.clear();
+}
+
+esp_err_t ADFFileSink::adf_open_(audio_element_handle_t self) {
+  ADFFileSink *this_ = (ADFFileSink *) audio_element_getdata(self);
+  this_->file_ = fopen(this_->path_.c_str(), "wb");
+  if (this_->file_ == nullptr) {
+    esph_log_e(TAG, "Couldn't create %s", this_->path_.c_str());
+    return ESP_FAIL;
+  }
+  if (this_->file_format_ == FileFormat::WAV) {
+    // the sizes are filled in when the recording stops
+    uint8_t header[WAV_HEADER_SIZE];
+    make_wav_header(header, this_->format_, 0);
+    fwrite(header, 1, sizeof(header), this_->file_);
+  }
+  this_->data_size_ = 0;
+  if (!this_->blocks_.start(this_->file_, true, this_->buffer_size_)) {
+    fclose(this_->file_);
+    this_->file_ = nullptr;
+    return ESP_FAIL;
+  }
+  esph_log_d(TAG, "Recording to %s", this_->path_.c_str());
+  return ESP_OK;
+}
+
+esp_err_t ADFFileSink::adf_close_(audio_element_handle_t self) {
+  ADFFileSink *this_ = (ADFFileSink *) audio_element_getdata(self);
+  if (this_->file_ == nullptr) {
+    return ESP_OK;
+  }
+  this_->blocks_.stop();
+  this_->dropped_bytes_ = this_->blocks_.get_dropped_bytes();
+  if (this_->file_format_ == FileFormat::WAV && fseek(this_->file_, 0, SEEK_SET) == 0) {
+    uint8_t header[WAV_HEADER_SIZE];
+    make_wav_header(header, this_->format_, this_->data_size_);
+    fwrite(header, 1, sizeof(header), this_->file_);
+  }
+  fclose(this_->file_);
+  this_->file_ = nullptr;
+  esph_log_d(TAG, "Recorded %u bytes to %s", (unsigned) this_->data_size_, this_->path_.c_str());
+  if (this_->dropped_bytes_ > 0 || this_->blocks_.get_io_errors() > 0) {
+    esph_log_w(TAG, "Storage too slow, dropped %u bytes, write errors: %u", (unsigned) this_->dropped_bytes_,
+               (unsigned) this_->blocks_.get_io_errors());
+  }
+  return ESP_OK;
+}
+
+audio_element_err_t ADFFileSink::adf_process_(audio_element_handle_t self, char *buffer, int len) {
+  ADFFileSink *this_ = (ADFFileSink *) audio_element_getdata(self);
+  const int read = audio_element_input(self, buffer, len);
+  if (read <= 0) {
+    return (audio_element_err_t) read;
+  }
+  this_->data_size_ += this_->blocks_.write((const uint8_t *) buffer, read);
+  return (audio_element_err_t) read;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,206 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+
+#include "adf_audio_sinks.h"
+#include "adf_audio_sources.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+namespace esphome {
+namespace esp_adf {
+
+enum class FileFormat : uint8_t { WAV = 0, RAW };
+
+/*
+Moves the file I/O of the file source and sink to a task of its own, so the latency of SD cards and
+flash file systems never reaches the element's task and the ring buffers of the pipeline.
+Two blocks are passed back and forth between the element's task and the I/O task: while one is
+written to or read from the file, the element fills or drains the other one. The element's side never
+waits when writing, data is dropped and counted if the storage can't keep up.
+*/
+class FileBlockQueue {
+ public:
+  // starts the I/O task on the opened file, reading stops after limit bytes
+  bool start(FILE *file, bool writing, size_t block_size, size_t limit = SIZE_MAX);
+  // flushes the block being filled when writing and waits for the I/O task to finish
+  void stop();
+
+  // element's side when writing, returns the number of accepted bytes
+  size_t write(const uint8_t *data, size_t len);
+  // element's side when reading, returns the number of copied bytes, 0 at the end of the file
+  // and -1 if the I/O task didn't provide a block within ticks
+  int read(uint8_t *data, size_t len, TickType_t ticks);
+
+  uint32_t get_dropped_bytes() const { return this->dropped_bytes_; }
+  uint32_t get_io_errors() const { return this->io_errors_; }
+
+ protected:
+  struct Block {
+    uint8_t *data;
+    size_t len;
+  };
+
+  static void io_task_(void *params);
+  void free_buffers_();
+
+  FILE *file_{nullptr};
+  bool writing_{false};
+  size_t block_size_{0};
+  size_t remaining_{0};
+  uint8_t *buffers_[2]{};
+
+  // blocks ready for the element (reading) or the file (writing), the other queue returns them
+  QueueHandle_t filled_{nullptr};
+  QueueHandle_t free_{nullptr};
+  SemaphoreHandle_t done_{nullptr};
+
+  // only accessed from the element's task
+  Block current_{nullptr, 0};
+  size_t pos_{0};
+
+  std::atomic<uint32_t> dropped_bytes_{0};
+  std::atomic<uint32_t> io_errors_{0};
+};
+
+/*
+Replays a WAV or raw PCM file into the pipeline, e.g. a capture for reproducing latency or quality
+regressions. The file is read on a separate task, see FileBlockQueue. 24 bit WAV files are expanded
+into 32 bit containers.
+*/
+class ADFFileSource : public ADFPipelineSourceElement, public Component {
+ public:
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  // ADFPipelineSourceElement implementations
+  const std::string get_name() override { return "FileSource"; }
+  bool is_ready() override;
+
+  void set_path(const std::string &path) { this->path_ = path; }
+  void set_file_format(FileFormat file_format) { this->file_format_ = file_format; }
+  // format of raw files, WAV files bring their own
+  void set_raw_format(int rate, int bits, int channels) { this->raw_format_ = {rate, bits, channels}; }
+  void set_buffer_size(size_t buffer_size) { this->buffer_size_ = buffer_size; }
+
+  // plays the given file, or the configured one if path is empty
+  void play(const std::string &path);
+
+ protected:
+  bool init_adf_elements_() override;
+  void clear_adf_elements_() override;
+  void reset_() override { this->valid_settings_ = false; }
+
+  static esp_err_t adf_open_(audio_element_handle_t self);
+  static esp_err_t adf_close_(audio_element_handle_t self);
+  static audio_element_err_t adf_process_(audio_element_handle_t self, char *buffer, int len);
+
+  bool read_header_();
+
+  std::string path_;
+  FileFormat file_format_{FileFormat::WAV};
+  pcm_format raw_format_{16000, 16, 1};
+  size_t buffer_size_{8 * 1024};
+  bool valid_settings_{false};
+
+  // format of the samples in the file and where they are
+  pcm_format format_{16000, 16, 1};
+  int file_sample_bytes_{2};
+  long data_offset_{0};
+  size_t data_size_{SIZE_MAX};
+
+  // only accessed from the element's task
+  FILE *file_{nullptr};
+  FileBlockQueue blocks_;
+  uint32_t underruns_{0};
+
+  audio_element_handle_t adf_file_reader_{};
+};
+
+/*
+Records what arrives at the end of the pipeline into a WAV or raw PCM file. The format is taken from
+the pipeline, unless it is configured, then it's requested from the pipeline's converters. The file is
+written on a separate task, see FileBlockQueue. The sizes in the WAV header are updated when the
+recording stops.
+*/
+class ADFFileSink : public ADFPipelineSinkElement, public Component {
+ public:
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  // ADFPipelineSinkElement implementations
+  const std::string get_name() override { return "FileSink"; }
+
+  void set_path(const std::string &path) { this->path_ = path; }
+  void set_file_format(FileFormat file_format) { this->file_format_ = file_format; }
+  // requested from the pipeline, 0 keeps what the pipeline provides
+  void set_sample_rate(int rate) { this->requested_format_.rate = rate; }
+  void set_bits_per_sample(int bits) { this->requested_format_.bits = bits; }
+  void set_channels(int channels) { this->requested_format_.channels = channels; }
+  void set_buffer_size(size_t buffer_size) { this->buffer_size_ = buffer_size; }
+
+  // records into the given file, or the configured one if path is empty
+  void record(const std::string &path);
+  void stop();
+
+  // bytes dropped because the storage couldn't keep up, during the last recording
+  uint32_t get_dropped_bytes() const { return this->dropped_bytes_; }
+
+ protected:
+  bool init_adf_elements_() override;
+  void clear_adf_elements_() override;
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+
+  static esp_err_t adf_open_(audio_element_handle_t self);
+  static esp_err_t adf_close_(audio_element_handle_t self);
+  static audio_element_err_t adf_process_(audio_element_handle_t self, char *buffer, int len);
+
+  std::string path_;
+  FileFormat file_format_{FileFormat::WAV};
+  pcm_format requested_format_{0, 0, 0};
+  pcm_format format_{16000, 16, 1};
+  size_t buffer_size_{8 * 1024};
+
+  // only accessed from the element's task
+  FILE *file_{nullptr};
+  FileBlockQueue blocks_;
+  uint32_t data_size_{0};
+  uint32_t dropped_bytes_{0};
+
+  audio_element_handle_t adf_file_writer_{};
+};
+
+template<typename... Ts> class PlayFileAction : public Action<Ts...>, public Parented<ADFFileSource> {
+ public:
+  TEMPLATABLE_VALUE(std::string, path)
+
+  void play(Ts... x) override { this->parent_->play(this->path_.value(x...)); }
+};
+
+template<typename... Ts> class RecordFileAction : public Action<Ts...>, public Parented<ADFFileSink> {
+ public:
+  TEMPLATABLE_VALUE(std::string, path)
+
+  void play(Ts... x) override { this->parent_->record(this->path_.value(x...)); }
+};
+
+template<typename... Ts> class StopRecordingAction : public Action<Ts...>, public Parented<ADFFileSink> {
+ public:
+  void play(Ts... x) override { this->parent_->stop(); }
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
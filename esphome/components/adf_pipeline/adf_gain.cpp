@@ -0,0 +1,208 @@
+#include "adf_gain.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <cmath>
+#include <cstring>
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_gain";
+
+static const int GAIN_SHIFT = 24;
+static const int32_t GAIN_UNITY = 1 << GAIN_SHIFT;
+// +18dB, keeps the gain well inside the Q24 range
+static const float MAX_GAIN_DB = 18.f;
+// ReplayGain 2.0 reference loudness
+static const float REPLAY_GAIN_REFERENCE_LUFS = -18.f;
+// quieter passages and silence don't pull the normalization gain up
+static const float NORMALIZATION_GATE_LUFS = -45.f;
+
+template<typename T> static inline T scale_sample(T sample, int32_t gain) {
+  return audio_sat<T>(((int64_t) sample * gain) >> GAIN_SHIFT);
+}
+
+ADFGain::ADFGain()
+    : target_gain_(GAIN_UNITY), current_gain_(GAIN_UNITY), ramp_target_(GAIN_UNITY), normalization_gain_(GAIN_UNITY) {
+  this->element_tag_ = "gain";
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFGain::dump_config() {
+  esph_log_config(TAG, "Gain:");
+  esph_log_config(TAG, "  static gain: %.1f dB", this->gain_db_);
+  esph_log_config(TAG, "  ramp time: %u ms", this->ramp_time_ms_);
+  if (this->normalize_) {
+    esph_log_config(TAG, "  normalization: %.1f LUFS, max %.1f dB, adjust time %u ms", this->target_lufs_,
+                    this->max_normalization_db_, this->adjust_time_ms_);
+  }
+}
+
+void ADFGain::set_gain_db(float gain_db) {
+  this->gain_db_ = gain_db;
+  this->update_target_gain_();
+}
+
+void ADFGain::update_target_gain_() {
+  float gain_db = this->gain_db_;
+  if (!this->hardware_volume_) {
+    if (this->muted_ || this->volume_ <= 0.f) {
+      this->target_gain_ = 0;
+      return;
+    }
+    gain_db += volume_to_db(this->volume_);
+  }
+  gain_db = std::min(gain_db, MAX_GAIN_DB);
+  this->target_gain_ = (int32_t) lroundf(powf(10.f, gain_db / 20.f) * GAIN_UNITY);
+}
+
+void ADFGain::on_settings_request(AudioPipelineSettingsRequest &request) {
+  if (request.target_volume > -1) {
+    this->volume_ = request.target_volume;
+  }
+  if (request.mute > -1) {
+    this->muted_ = request.mute == 1;
+  }
+  this->hardware_volume_ = request.final_volume > -1;
+  this->update_target_gain_();
+  if (request.requested_by != nullptr && request.requested_by->get_element_type() == AUDIO_PIPELINE_SOURCE &&
+      request.sampling_rate > 0) {
+    // a source announces a new stream, with its track gain if known
+    this->track_gain_db_ = request.track_gain_db;
+    this->new_stream_ = true;
+  }
+
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFGain::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  // a pending ramp continues with the new rate
+  if (this->normalize_) {
+    this->meter_.configure(in_format.rate, in_format.channels, in_format.bits);
+  }
+  return true;
+}
+
+void ADFGain::update_normalization_() {
+  float gain_db = this->normalization_db_;
+  const float track_gain_db = this->track_gain_db_;
+  if (!std::isnan(track_gain_db)) {
+    gain_db = track_gain_db + this->target_lufs_ - REPLAY_GAIN_REFERENCE_LUFS;
+  } else {
+    const float loudness = this->meter_.get_short_term_lufs();
+    if (loudness < NORMALIZATION_GATE_LUFS) {
+      return;
+    }
+    const float coeff = 1.f - expf(-this->meter_.get_block_time() * 1000.f / this->adjust_time_ms_);
+    gain_db += (this->target_lufs_ - loudness - gain_db) * coeff;
+  }
+  gain_db = clamp(gain_db, -this->max_normalization_db_, this->max_normalization_db_);
+  this->normalization_db_ = gain_db;
+  this->normalization_gain_ = (int32_t) lroundf(powf(10.f, gain_db / 20.f) * GAIN_UNITY);
+}
+
+// measures the loudness of the input and applies the gain in the same pass
+template<typename T> void ADFGain::process_normalized_(T *samples, size_t num_frames) {
+  const int channels = this->in_format_.channels;
+  for (size_t frame = 0; frame < num_frames; frame++) {
+    T *sample = samples + frame * channels;
+    this->meter_.add_frame(sample);
+    if (this->ramp_remaining_ > 0) {
+      this->current_gain_ = --this->ramp_remaining_ == 0 ? this->ramp_target_ : this->current_gain_ + this->ramp_step_;
+    }
+    if (this->current_gain_ != GAIN_UNITY) {
+      for (int ch = 0; ch < channels; ch++) {
+        sample[ch] = scale_sample<T>(sample[ch], this->current_gain_);
+      }
+    }
+  }
+}
+
+void ADFGain::start_ramp_(int32_t target) {
+  uint32_t frames = std::max<uint32_t>(1, this->ramp_time_ms_ * this->in_format_.rate / 1000);
+  this->ramp_target_ = target;
+  this->ramp_step_ = (int32_t) (((int64_t) target - this->current_gain_) / (int64_t) frames);
+  this->ramp_remaining_ = frames;
+}
+
+int ADFGain::process_pcm_(uint8_t *data, int len) {
+  if (this->normalize_ && this->new_stream_.exchange(false)) {
+    // the estimate starts over, the correction of the previous stream is kept until the first update
+    this->meter_.reset();
+    this->update_normalization_();
+  }
+  int32_t target = this->target_gain_;
+  if (this->normalize_) {
+    const int64_t max_gain = (int64_t) (powf(10.f, MAX_GAIN_DB / 20.f) * GAIN_UNITY);
+    target = (int32_t) std::min(((int64_t) target * this->normalization_gain_) >> GAIN_SHIFT, max_gain);
+  }
+  if (target != this->ramp_target_) {
+    this->start_ramp_(target);
+  }
+
+  const int channels = this->in_format_.channels;
+  const bool is_16bit = this->in_format_.bits == 16;
+  const size_t num_samples = len / (is_16bit ? sizeof(int16_t) : sizeof(int32_t));
+  size_t offset = 0;
+
+  if (this->normalize_) {
+    if (is_16bit) {
+      this->process_normalized_<int16_t>((int16_t *) data, num_samples / channels);
+    } else {
+      this->process_normalized_<int32_t>((int32_t *) data, num_samples / channels);
+    }
+    if (this->meter_.has_update()) {
+      this->update_normalization_();
+    }
+    return len;
+  }
+
+  if (this->ramp_remaining_ > 0) {
+    const size_t frames =
+        is_16bit ? audio_gain_ramp_s16((int16_t *) data, num_samples / channels, channels, &this->current_gain_,
+                                       this->ramp_step_, &this->ramp_remaining_, this->ramp_target_, GAIN_SHIFT)
+                 : audio_gain_ramp_s32((int32_t *) data, num_samples / channels, channels, &this->current_gain_,
+                                       this->ramp_step_, &this->ramp_remaining_, this->ramp_target_, GAIN_SHIFT);
+    offset = frames * channels;
+  }
+  if (offset == num_samples || this->current_gain_ == GAIN_UNITY) {
+    return len;
+  }
+
+  if (is_16bit) {
+    int16_t *samples = (int16_t *) data + offset;
+    if (this->current_gain_ == 0) {
+      std::memset(samples, 0, (num_samples - offset) * sizeof(int16_t));
+    } else {
+      audio_scale_s16(samples, num_samples - offset, this->current_gain_, GAIN_SHIFT);
+    }
+  } else {
+    int32_t *samples = (int32_t *) data + offset;
+    if (this->current_gain_ == 0) {
+      std::memset(samples, 0, (num_samples - offset) * sizeof(int32_t));
+    } else {
+      audio_scale_s32(samples, num_samples - offset, this->current_gain_, GAIN_SHIFT);
+    }
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+#include "adf_loudness.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+Software volume and gain stage processing the stream in place.
+Applies the volume and mute state requested via settings requests plus a static gain.
+Gain changes are ramped linearly per frame to avoid zipper noise, processing is skipped at unity gain.
+If the sink controls the volume in hardware (final_volume is set), only the static gain is applied.
+With loudness normalization, a correction towards the target loudness is added to the gain. It is taken
+from the track gain announced by the source if available (ReplayGain), otherwise it follows the
+short-term loudness measured in the same pass over the samples, slowly and only while the signal is
+above the gate.
+*/
+class ADFGain : public ADFPCMProcessElement, public Component {
+ public:
+  ADFGain();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "Gain"; }
+
+  void set_gain_db(float gain_db);
+  void set_ramp_time(uint32_t ramp_time_ms) { this->ramp_time_ms_ = ramp_time_ms; }
+  void set_normalization(float target_lufs, float max_gain_db, uint32_t adjust_time_ms) {
+    this->normalize_ = true;
+    this->target_lufs_ = target_lufs;
+    this->max_normalization_db_ = max_gain_db;
+    this->adjust_time_ms_ = adjust_time_ms;
+  }
+
+  // current loudness correction in dB, 0 without normalization
+  float get_normalization_db() const { return this->normalization_db_; }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  void update_target_gain_();
+  void start_ramp_(int32_t target);
+  void update_normalization_();
+  template<typename T> void process_normalized_(T *samples, size_t num_frames);
+
+  float gain_db_{0.f};
+  float volume_{1.f};
+  bool muted_{false};
+  bool hardware_volume_{false};
+  uint32_t ramp_time_ms_{25};
+  pcm_format format_{16000, 16, 2};
+
+  // Q24, written from the main loop, picked up by the element's task
+  std::atomic<int32_t> target_gain_;
+  // ReplayGain track gain of the current stream, NAN if the loudness is estimated
+  std::atomic<float> track_gain_db_{NAN};
+  std::atomic<bool> new_stream_{false};
+
+  bool normalize_{false};
+  float target_lufs_{-18.f};
+  float max_normalization_db_{12.f};
+  uint32_t adjust_time_ms_{5000};
+  std::atomic<float> normalization_db_{0.f};
+
+  // only accessed from the element's task
+  int32_t current_gain_;
+  int32_t ramp_target_;
+  int32_t ramp_step_{0};
+  uint32_t ramp_remaining_{0};
+  LoudnessMeter meter_;
+  // Q24
+  int32_t normalization_gain_;
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
@@ -0,0 +1,92 @@
+#include "adf_high_pass.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <cmath>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_high_pass";
+
+// corner frequency of the DC blocker, low enough to leave the audible range untouched
+static const float DC_BLOCKER_FREQUENCY = 10.f;
+
+void HighPassFilter::configure(int rate, int channels) {
+  this->channels_ = channels;
+  this->state_.assign(channels, {0, 0, 0, 0, 0, 0});
+  this->dc_pole_ = (int32_t) lround((1. - 2. * M_PI * DC_BLOCKER_FREQUENCY / rate) * (1 << 30));
+
+  this->high_pass_ = this->frequency_ > 0.f && this->frequency_ < rate / 2;
+  if (!this->high_pass_) {
+    return;
+  }
+  // RBJ audio EQ cookbook, Q = 1/sqrt(2)
+  const double w0 = 2. * M_PI * this->frequency_ / rate;
+  const double cos_w0 = cos(w0);
+  const double alpha = sin(w0) / M_SQRT2;
+  const double scale = (double) (1 << 27) / (1. + alpha);
+  this->b0_ = (int32_t) lround((1. + cos_w0) / 2. * scale);
+  this->b1_ = (int32_t) lround(-(1. + cos_w0) * scale);
+  this->b2_ = this->b0_;
+  this->a1_ = (int32_t) lround(-2. * cos_w0 * scale);
+  this->a2_ = (int32_t) lround((1. - alpha) * scale);
+}
+
+ADFHighPass::ADFHighPass() {
+  this->element_tag_ = "high_pass";
+  this->filter_.set_dc_blocker(true);
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFHighPass::dump_config() {
+  esph_log_config(TAG, "High-Pass:");
+  esph_log_config(TAG, "  DC blocker: %s", YESNO(this->filter_.get_dc_blocker()));
+  if (this->filter_.get_frequency() > 0.f) {
+    esph_log_config(TAG, "  frequency: %.0f Hz", this->filter_.get_frequency());
+  }
+}
+
+void ADFHighPass::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFHighPass::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  if (this->filter_.get_frequency() >= in_format.rate / 2) {
+    esph_log_w(TAG, "High-pass at %.0f Hz is above the Nyquist frequency at %d Hz, skipped",
+               this->filter_.get_frequency(), in_format.rate);
+  }
+  this->filter_.configure(in_format.rate, in_format.channels);
+  return true;
+}
+
+int ADFHighPass::process_pcm_(uint8_t *data, int len) {
+  if (!this->filter_.is_enabled()) {
+    return len;
+  }
+  if (this->in_format_.bits == 16) {
+    int16_t *samples = (int16_t *) data;
+    this->filter_.process(samples, samples, len / (sizeof(int16_t) * this->in_format_.channels));
+  } else {
+    int32_t *samples = (int32_t *) data;
+    this->filter_.process(samples, samples, len / (sizeof(int32_t) * this->in_format_.channels));
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,139 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+#include "adf_audio_process.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+One-pole DC blocker followed by an optional second order Butterworth high-pass, per channel.
+Samples are filtered with full scale at 2^30 and Q27 coefficients, which leaves one bit of headroom
+for the step response of the DC blocker. The conversion from and to the stream's sample type is part
+of the loop, so the filter can be fused into a bit depth conversion without a second pass over the block.
+*/
+class HighPassFilter {
+ public:
+  void set_dc_blocker(bool dc_blocker) { this->dc_blocker_ = dc_blocker; }
+  // 0 disables the high-pass
+  void set_frequency(float frequency) { this->frequency_ = frequency; }
+  bool get_dc_blocker() const { return this->dc_blocker_; }
+  float get_frequency() const { return this->frequency_; }
+  bool is_enabled() const { return this->dc_blocker_ || this->frequency_ > 0.f; }
+
+  // calculates the coefficients for the rate and clears the state
+  void configure(int rate, int channels);
+
+  // filters interleaved frames from src to dst, dst may alias src if Out isn't larger than In
+  // 16 bit output is amplified by 2^gain_log2 before saturation
+  template<typename In, typename Out>
+  void process(const In *src, Out *dst, size_t num_frames, int gain_log2 = 0) {
+    const int channels = this->channels_;
+    for (size_t frame = 0; frame < num_frames; frame++) {
+      for (int ch = 0; ch < channels; ch++) {
+        const size_t i = frame * channels + ch;
+        dst[i] = from_q30<Out>(this->filter_(to_q30(src[i]), this->state_[ch]), gain_log2);
+      }
+    }
+  }
+
+ protected:
+  struct State {
+    int32_t dc_x1;
+    int32_t dc_y1;
+    int32_t x1;
+    int32_t x2;
+    int32_t y1;
+    int32_t y2;
+  };
+
+  static inline int32_t to_q30(int16_t sample) { return (int32_t) sample << 15; }
+  static inline int32_t to_q30(int32_t sample) { return sample >> 1; }
+  template<typename T> static inline T from_q30(int32_t value, int gain_log2);
+
+  inline int32_t filter_(int32_t x, State &s) const {
+    if (this->dc_blocker_) {
+      const int32_t y = audio_sat_s32((int64_t) x - s.dc_x1 + (((int64_t) this->dc_pole_ * s.dc_y1) >> 30));
+      s.dc_x1 = x;
+      s.dc_y1 = y;
+      x = y;
+    }
+    if (this->high_pass_) {
+      const int64_t acc = (int64_t) this->b0_ * x + (int64_t) this->b1_ * s.x1 + (int64_t) this->b2_ * s.x2 -
+                          (int64_t) this->a1_ * s.y1 - (int64_t) this->a2_ * s.y2;
+      const int32_t y = audio_sat_s32(acc >> 27);
+      s.x2 = s.x1;
+      s.x1 = x;
+      s.y2 = s.y1;
+      s.y1 = y;
+      x = y;
+    }
+    return x;
+  }
+
+  bool dc_blocker_{false};
+  float frequency_{0.f};
+
+  int channels_{1};
+  // Q30
+  int32_t dc_pole_{0};
+  // set if the frequency is below the Nyquist frequency of the configured rate
+  bool high_pass_{false};
+  // Q27, normalized by a0
+  int32_t b0_{0};
+  int32_t b1_{0};
+  int32_t b2_{0};
+  int32_t a1_{0};
+  int32_t a2_{0};
+  std::vector<State> state_;
+};
+
+template<> inline int16_t HighPassFilter::from_q30<int16_t>(int32_t value, int gain_log2) {
+  return audio_sat_s16(value >> (15 - gain_log2));
+}
+
+template<> inline int32_t HighPassFilter::from_q30<int32_t>(int32_t value, int gain_log2) {
+  return audio_sat_s32((int64_t) value << 1);
+}
+
+/*
+DC offset removal and optional high-pass for microphones with offset or low-frequency rumble,
+placed directly after the I2S reader. Processes the stream in place. The same filter can be fused
+into the bit depth conversion of the microphone instead, see ADFBitDepthConverter::set_high_pass.
+*/
+class ADFHighPass : public ADFPCMProcessElement, public Component {
+ public:
+  ADFHighPass();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "HighPass"; }
+
+  void set_dc_blocker(bool dc_blocker) { this->filter_.set_dc_blocker(dc_blocker); }
+  void set_frequency(float frequency) { this->filter_.set_frequency(frequency); }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  pcm_format format_{16000, 16, 2};
+
+  // only accessed from the element's task after setup
+  HighPassFilter filter_;
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
@@ -0,0 +1,199 @@
+#include "adf_level_meter.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_level_meter";
+
+// reported for silence instead of -inf
+static const float METER_FLOOR_DB = -120.f;
+
+static float power_to_db(double power) {
+  return power > 0. ? std::max(METER_FLOOR_DB, (float) (10. * log10(power))) : METER_FLOOR_DB;
+}
+
+// in place radix-2 FFT, size has to be a power of two
+static void fft(std::complex<float> *data, int size) {
+  for (int i = 1, j = 0; i < size; i++) {
+    int bit = size >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(data[i], data[j]);
+    }
+  }
+  for (int len = 2; len <= size; len <<= 1) {
+    const float angle = -2.f * (float) M_PI / len;
+    const std::complex<float> step(cosf(angle), sinf(angle));
+    for (int start = 0; start < size; start += len) {
+      std::complex<float> w(1.f, 0.f);
+      for (int k = 0; k < len / 2; k++) {
+        const std::complex<float> odd = data[start + k + len / 2] * w;
+        data[start + k + len / 2] = data[start + k] - odd;
+        data[start + k] += odd;
+        w *= step;
+      }
+    }
+  }
+}
+
+ADFLevelMeter::ADFLevelMeter() {
+  this->element_tag_ = "level_meter";
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFLevelMeter::setup() {
+  if (!this->bands_.empty()) {
+    this->window_.resize(METER_FFT_SIZE);
+  }
+}
+
+void ADFLevelMeter::dump_config() {
+  esph_log_config(TAG, "Level Meter:");
+  esph_log_config(TAG, "  update interval: %u ms", this->get_update_interval());
+  for (const auto &band : this->bands_) {
+    esph_log_config(TAG, "  band: %.0f - %.0f Hz", band.from, band.to);
+  }
+}
+
+void ADFLevelMeter::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFLevelMeter::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  // levels of the previous format are dropped, a pending snapshot is taken from the new one
+  this->sum_squares_ = 0;
+  this->num_samples_ = 0;
+  this->peak_ = 0;
+  this->window_pos_ = 0;
+  return true;
+}
+
+void ADFLevelMeter::update() {
+  if (!this->snapshot_ready_) {
+    this->snapshot_requested_ = true;
+  }
+}
+
+void ADFLevelMeter::loop() {
+  if (!this->snapshot_ready_.load()) {
+    return;
+  }
+  if (this->snapshot_samples_ > 0) {
+    const double full_scale = 32768. * 32768.;
+    if (this->rms_sensor_ != nullptr) {
+      this->rms_sensor_->publish_state(
+          power_to_db((double) this->snapshot_sum_squares_ / this->snapshot_samples_ / full_scale));
+    }
+    if (this->peak_sensor_ != nullptr) {
+      const double peak = this->snapshot_peak_ / 2147483648.;
+      this->peak_sensor_->publish_state(power_to_db(peak * peak));
+    }
+    this->publish_bands_();
+  }
+  this->snapshot_ready_.store(false);
+}
+
+void ADFLevelMeter::publish_bands_() {
+  if (this->bands_.empty()) {
+    return;
+  }
+  std::vector<std::complex<float>> spectrum(METER_FFT_SIZE);
+  float window_power = 0.f;
+  for (int i = 0; i < METER_FFT_SIZE; i++) {
+    const float hann = 0.5f - 0.5f * cosf(2.f * (float) M_PI * i / METER_FFT_SIZE);
+    spectrum[i] = hann * this->window_[i] / 32768.f;
+    window_power += hann * hann;
+  }
+  fft(spectrum.data(), METER_FFT_SIZE);
+
+  // one sided power spectrum, scaled so the bands of the whole spectrum add up to the mean square
+  const float bin_width = (float) this->snapshot_rate_ / METER_FFT_SIZE;
+  for (const auto &band : this->bands_) {
+    const int first = std::max(1, (int) ceilf(band.from / bin_width));
+    const int last = std::min(METER_FFT_SIZE / 2, (int) floorf(band.to / bin_width));
+    double power = 0.;
+    for (int k = first; k <= last; k++) {
+      power += std::norm(spectrum[k]);
+    }
+    band.sensor->publish_state(power_to_db(2. * power / (METER_FFT_SIZE * window_power)));
+  }
+}
+
+template<typename T> void ADFLevelMeter::measure_(const T *samples, size_t num_frames) {
+  const int channels = this->in_format_.channels;
+  const size_t num_samples = num_frames * channels;
+  // squares of 16 bit samples, 32 bit samples are reduced to 16 bit precision for the RMS
+  const int shift = sizeof(T) > 2 ? 16 : 0;
+  if (sizeof(T) > 2) {
+    this->sum_squares_ += audio_level_s32((const int32_t *) samples, num_samples, &this->peak_);
+  } else {
+    this->sum_squares_ += audio_level_s16((const int16_t *) samples, num_samples, &this->peak_);
+  }
+  this->num_samples_ += num_samples;
+
+  if (!this->capturing_ || this->window_.empty()) {
+    return;
+  }
+  for (size_t frame = 0; frame < num_frames && this->window_pos_ < this->window_.size(); frame++) {
+    int32_t mono = 0;
+    for (int ch = 0; ch < channels; ch++) {
+      mono += samples[frame * channels + ch] >> shift;
+    }
+    this->window_[this->window_pos_++] = (int16_t) (mono / channels);
+  }
+}
+
+int ADFLevelMeter::process_pcm_(uint8_t *data, int len) {
+  if (this->snapshot_requested_.load() && !this->capturing_) {
+    this->snapshot_requested_.store(false);
+    this->capturing_ = true;
+    this->window_pos_ = 0;
+  }
+
+  if (this->in_format_.bits == 16) {
+    this->measure_<int16_t>((int16_t *) data, len / (sizeof(int16_t) * this->in_format_.channels));
+  } else {
+    this->measure_<int32_t>((int32_t *) data, len / (sizeof(int32_t) * this->in_format_.channels));
+  }
+
+  if (this->capturing_ && this->window_pos_ == this->window_.size()) {
+    this->snapshot_sum_squares_ = this->sum_squares_;
+    this->snapshot_samples_ = this->num_samples_;
+    this->snapshot_peak_ = this->peak_;
+    this->snapshot_rate_ = this->in_format_.rate;
+    this->sum_squares_ = 0;
+    this->num_samples_ = 0;
+    this->peak_ = 0;
+    this->capturing_ = false;
+    this->snapshot_ready_.store(true);
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+#include <vector>
+
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+
+#include "adf_audio_process.h"
+
+namespace esphome {
+namespace esp_adf {
+
+struct MeterBand {
+  float from;
+  float to;
+  sensor::Sensor *sensor;
+};
+
+/*
+Level meter, passes the stream through unchanged and publishes its RMS and peak level in dBFS
+(a full scale square wave is 0 dBFS) once per update interval, e.g. to monitor room noise or clipping.
+The element's task only accumulates the sum of squares and the peak, and captures a window of
+METER_FFT_SIZE mono frames after each update. The band energies are calculated from that window
+with an FFT on the main loop, so they are a snapshot rather than an average over the interval.
+*/
+class ADFLevelMeter : public ADFPCMProcessElement, public PollingComponent {
+ public:
+  static constexpr int METER_FFT_SIZE = 256;
+
+  ADFLevelMeter();
+
+  // ESPHome Component implementations
+  void setup() override;
+  void loop() override;
+  void update() override;
+  void dump_config() override;
+
+  const std::string get_name() override { return "LevelMeter"; }
+
+  void set_rms_sensor(sensor::Sensor *rms_sensor) { this->rms_sensor_ = rms_sensor; }
+  void set_peak_sensor(sensor::Sensor *peak_sensor) { this->peak_sensor_ = peak_sensor; }
+  void add_band(float from, float to, sensor::Sensor *band_sensor) {
+    this->bands_.push_back({from, to, band_sensor});
+  }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  template<typename T> void measure_(const T *samples, size_t num_frames);
+  void publish_bands_();
+
+  sensor::Sensor *rms_sensor_{nullptr};
+  sensor::Sensor *peak_sensor_{nullptr};
+  std::vector<MeterBand> bands_;
+  pcm_format format_{16000, 16, 2};
+
+  // set by update(), the element's task answers with a snapshot and sets snapshot_ready_
+  std::atomic<bool> snapshot_requested_{false};
+  std::atomic<bool> snapshot_ready_{false};
+  // written by the element's task while snapshot_ready_ is false, read by the main loop otherwise
+  uint64_t snapshot_sum_squares_{0};
+  uint32_t snapshot_samples_{0};
+  uint32_t snapshot_peak_{0};
+  int snapshot_rate_{0};
+  std::vector<int16_t> window_;
+
+  // only accessed from the element's task
+  uint64_t sum_squares_{0};
+  uint32_t num_samples_{0};
+  // absolute peak scaled to 32 bit full scale
+  uint32_t peak_{0};
+  bool capturing_{false};
+  size_t window_pos_{0};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
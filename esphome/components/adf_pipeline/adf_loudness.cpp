@@ -0,0 +1,70 @@
+#include "adf_loudness.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace esp_adf {
+
+// K-weighting filters of ITU-R BS.1770, recalculated for the sampling rate as done by libebur128
+static const double SHELF_FREQUENCY = 1681.974450955533;
+static const double SHELF_GAIN_DB = 3.999843853973347;
+static const double SHELF_Q = 0.7071752369554196;
+static const double HIGH_PASS_FREQUENCY = 38.13547087602444;
+static const double HIGH_PASS_Q = 0.5003270373238773;
+
+void LoudnessMeter::configure(int rate, int channels, int bits) {
+  this->channels_ = std::min(channels, MAX_CHANNELS);
+  this->scale_ = bits > 16 ? 1.f / 2147483648.f : 1.f / 32768.f;
+  this->block_frames_ = std::max(1, rate / 10);
+  this->block_time_ = (float) this->block_frames_ / rate;
+
+  double k = tan(M_PI * SHELF_FREQUENCY / rate);
+  const double vh = pow(10., SHELF_GAIN_DB / 20.);
+  const double vb = pow(vh, 0.4996667741545416);
+  double a0 = 1. + k / SHELF_Q + k * k;
+  this->shelf_[0] = (float) ((vh + vb * k / SHELF_Q + k * k) / a0);
+  this->shelf_[1] = (float) (2. * (k * k - vh) / a0);
+  this->shelf_[2] = (float) ((vh - vb * k / SHELF_Q + k * k) / a0);
+  this->shelf_[3] = (float) (2. * (k * k - 1.) / a0);
+  this->shelf_[4] = (float) ((1. - k / SHELF_Q + k * k) / a0);
+
+  k = tan(M_PI * HIGH_PASS_FREQUENCY / rate);
+  a0 = 1. + k / HIGH_PASS_Q + k * k;
+  this->high_pass_[0] = (float) (2. * (k * k - 1.) / a0);
+  this->high_pass_[1] = (float) ((1. - k / HIGH_PASS_Q + k * k) / a0);
+  this->reset();
+}
+
+void LoudnessMeter::reset() {
+  std::fill(std::begin(this->state_), std::end(this->state_), Stage{0.f, 0.f, 0.f, 0.f});
+  this->block_pos_ = 0;
+  this->block_sum_ = 0.f;
+  this->block_index_ = 0;
+  this->num_blocks_ = 0;
+  this->updated_ = false;
+  this->short_term_lufs_ = -100.f;
+}
+
+void LoudnessMeter::finish_block_() {
+  this->blocks_[this->block_index_] = this->block_sum_ / this->block_frames_;
+  this->block_index_ = (this->block_index_ + 1) % SHORT_TERM_BLOCKS;
+  this->num_blocks_ = std::min(this->num_blocks_ + 1, SHORT_TERM_BLOCKS);
+  this->block_sum_ = 0.f;
+  this->block_pos_ = 0;
+
+  float sum = 0.f;
+  for (int i = 0; i < this->num_blocks_; i++) {
+    sum += this->blocks_[i];
+  }
+  const float mean = sum / this->num_blocks_;
+  this->short_term_lufs_ = mean > 1e-10f ? -0.691f + 10.f * log10f(mean) : -100.f;
+  this->updated_ = true;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
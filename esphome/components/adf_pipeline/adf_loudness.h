@@ -0,0 +1,95 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+Incremental short-term loudness estimate following EBU R128 / ITU-R BS.1770: every channel is
+K-weighted (high shelf and high-pass), the power is summed over the channels and averaged over blocks
+of 100ms. The short-term loudness is the mean over the last 3s of blocks. Frames are fed one by one,
+so the meter can be run inside the loop of a gain stage without a separate pass.
+*/
+class LoudnessMeter {
+ public:
+  static constexpr int MAX_CHANNELS = 8;
+
+  void configure(int rate, int channels, int bits);
+  // clears the filter state and the block history
+  void reset();
+
+  template<typename T> inline void add_frame(const T *frame) {
+    float power = 0.f;
+    for (int ch = 0; ch < this->channels_; ch++) {
+      Stage &s = this->state_[ch];
+      const float x = frame[ch] * this->scale_;
+      // transposed direct form II, shelf followed by the high-pass
+      const float y1 = this->shelf_[0] * x + s.z1;
+      s.z1 = this->shelf_[1] * x - this->shelf_[3] * y1 + s.z2;
+      s.z2 = this->shelf_[2] * x - this->shelf_[4] * y1;
+      const float y2 = y1 + s.z3;
+      s.z3 = -2.f * y1 - this->high_pass_[0] * y2 + s.z4;
+      s.z4 = y1 - this->high_pass_[1] * y2;
+      power += y2 * y2;
+    }
+    this->block_sum_ += power;
+    if (++this->block_pos_ == this->block_frames_) {
+      this->finish_block_();
+    }
+  }
+  template<typename T> void add_frames(const T *samples, size_t num_frames) {
+    for (size_t f = 0; f < num_frames; f++) {
+      this->add_frame(samples + f * this->channels_);
+    }
+  }
+
+  // true once per completed block, cleared by the call
+  bool has_update() {
+    const bool update = this->updated_;
+    this->updated_ = false;
+    return update;
+  }
+  // short-term loudness in LUFS, very low until the first block has been completed
+  float get_short_term_lufs() const { return this->short_term_lufs_; }
+  // duration of one block in seconds
+  float get_block_time() const { return this->block_time_; }
+
+ protected:
+  static constexpr int SHORT_TERM_BLOCKS = 30;
+
+  struct Stage {
+    float z1;
+    float z2;
+    float z3;
+    float z4;
+  };
+
+  void finish_block_();
+
+  int channels_{1};
+  float scale_{1.f / 32768.f};
+  // b0, b1, b2, a1, a2 normalized by a0
+  float shelf_[5]{};
+  // a1, a2 of the high-pass, b is fixed to 1, -2, 1
+  float high_pass_[2]{};
+  Stage state_[MAX_CHANNELS]{};
+
+  uint32_t block_frames_{1600};
+  uint32_t block_pos_{0};
+  float block_time_{0.1f};
+  float block_sum_{0.f};
+  float blocks_[SHORT_TERM_BLOCKS]{};
+  int block_index_{0};
+  int num_blocks_{0};
+  bool updated_{false};
+  float short_term_lufs_{-100.f};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
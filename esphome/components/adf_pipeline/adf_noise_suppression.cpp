@@ -0,0 +1,147 @@
+#include "adf_noise_suppression.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cstring>
+#include <esp_agc.h>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_ns";
+
+static const int NS_SAMPLE_RATE = 16000;
+static const int NS_FRAME_MS = 10;
+static const size_t NS_FRAME_SAMPLES = NS_SAMPLE_RATE * NS_FRAME_MS / 1000;
+// fixed digital gain mode of the webrtc based AGC
+static const int AGC_MODE_FIXED_DIGITAL = 3;
+
+ADFNoiseSuppression::ADFNoiseSuppression() {
+  this->element_tag_ = "ns_agc";
+  this->task_stack_ = 6 * 1024;
+  this->stack_in_ext_ = false;
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFNoiseSuppression::dump_config() {
+  esph_log_config(TAG, "Noise Suppression:");
+  esph_log_config(TAG, "  noise suppression level: %u", this->ns_level_);
+  if (this->agc_target_dbfs_ > 0) {
+    esph_log_config(TAG, "  auto gain: -%u dBFS, max gain: %u dB", this->agc_target_dbfs_, this->agc_max_gain_db_);
+  } else {
+    esph_log_config(TAG, "  auto gain: off");
+  }
+  esph_log_config(TAG, "  mic channel: %u", this->mic_channel_);
+}
+
+void ADFNoiseSuppression::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFNoiseSuppression::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->active_ = in_format.rate == NS_SAMPLE_RATE && (this->ns_level_ > 0 || this->agc_target_dbfs_ > 0);
+  if (!this->active_) {
+    if (in_format.rate != NS_SAMPLE_RATE) {
+      esph_log_w(TAG, "Noise suppression requires %d Hz, got %d Hz, passing through", NS_SAMPLE_RATE,
+                 in_format.rate);
+    }
+    return true;
+  }
+  if (this->ns_level_ > 0 && this->ns_handle_ == nullptr) {
+    this->ns_handle_ = ns_pro_create(NS_FRAME_MS, this->ns_level_ - 1);
+    if (this->ns_handle_ == nullptr) {
+      esph_log_e(TAG, "Couldn't create noise suppression instance");
+      return false;
+    }
+  }
+  if (this->agc_target_dbfs_ > 0 && this->agc_handle_ == nullptr) {
+    this->agc_handle_ = esp_agc_open(AGC_MODE_FIXED_DIGITAL, NS_SAMPLE_RATE);
+    if (this->agc_handle_ == nullptr) {
+      esph_log_e(TAG, "Couldn't create AGC instance");
+      return false;
+    }
+    set_agc_config(this->agc_handle_, this->agc_max_gain_db_, 1, this->agc_target_dbfs_);
+  }
+  this->in_chunk_.assign(NS_FRAME_SAMPLES, 0);
+  this->ns_chunk_.assign(NS_FRAME_SAMPLES, 0);
+  this->out_chunk_.assign(NS_FRAME_SAMPLES, 0);
+  this->chunk_pos_ = 0;
+  return true;
+}
+
+esp_err_t ADFNoiseSuppression::close_() {
+  this->destroy_handles_();
+  return ESP_OK;
+}
+
+void ADFNoiseSuppression::destroy_handles_() {
+  if (this->ns_handle_ != nullptr) {
+    ns_destroy(this->ns_handle_);
+    this->ns_handle_ = nullptr;
+  }
+  if (this->agc_handle_ != nullptr) {
+    esp_agc_close(this->agc_handle_);
+    this->agc_handle_ = nullptr;
+  }
+}
+
+template<typename T> void ADFNoiseSuppression::process_frames_(T *samples, size_t num_frames) {
+  const int channels = this->in_format_.channels;
+  const int mic_channel = std::min<int>(this->mic_channel_, channels - 1);
+  const int shift = sizeof(T) > 2 ? 16 : 0;
+  for (size_t frame = 0; frame < num_frames; frame++) {
+    T *samples_in_frame = samples + frame * channels;
+    this->in_chunk_[this->chunk_pos_] = (int16_t) (samples_in_frame[mic_channel] >> shift);
+    const T out = (T) this->out_chunk_[this->chunk_pos_] << shift;
+    for (int ch = 0; ch < channels; ch++) {
+      samples_in_frame[ch] = out;
+    }
+    if (++this->chunk_pos_ == NS_FRAME_SAMPLES) {
+      this->process_chunk_();
+      this->chunk_pos_ = 0;
+    }
+  }
+}
+
+void ADFNoiseSuppression::process_chunk_() {
+  int16_t *agc_in = this->in_chunk_.data();
+  if (this->ns_handle_ != nullptr) {
+    ns_process(this->ns_handle_, this->in_chunk_.data(), this->ns_chunk_.data());
+    agc_in = this->ns_chunk_.data();
+  }
+  if (this->agc_handle_ != nullptr) {
+    esp_agc_process(this->agc_handle_, agc_in, this->out_chunk_.data(), NS_FRAME_SAMPLES, NS_SAMPLE_RATE);
+  } else {
+    std::memcpy(this->out_chunk_.data(), agc_in, NS_FRAME_SAMPLES * sizeof(int16_t));
+  }
+}
+
+int ADFNoiseSuppression::process_pcm_(uint8_t *data, int len) {
+  if (!this->active_) {
+    return len;
+  }
+  if (this->in_format_.bits == 16) {
+    this->process_frames_<int16_t>((int16_t *) data, len / (sizeof(int16_t) * this->in_format_.channels));
+  } else {
+    this->process_frames_<int32_t>((int32_t *) data, len / (sizeof(int32_t) * this->in_format_.channels));
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
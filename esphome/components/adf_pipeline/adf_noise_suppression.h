@@ -0,0 +1,67 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <vector>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+
+#include <esp_ns.h>
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+Noise suppression and automatic gain control based on esp-sr, meant to be placed in front of the
+voice assistant so the server gets cleaned-up audio.
+Processes one channel of 16 kHz streams in 10ms frames, the result is written to all channels.
+The output is delayed by one frame. Other rates are passed on untouched.
+*/
+class ADFNoiseSuppression : public ADFPCMProcessElement, public Component {
+ public:
+  ADFNoiseSuppression();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "NoiseSuppression"; }
+
+  // 0: off, 1: mild, 2: medium, 3: aggressive
+  void set_noise_suppression_level(uint8_t level) { this->ns_level_ = level; }
+  // target level in -dBFS, 0 turns the AGC off
+  void set_auto_gain(uint8_t target_dbfs) { this->agc_target_dbfs_ = target_dbfs; }
+  void set_max_gain(uint8_t max_gain_db) { this->agc_max_gain_db_ = max_gain_db; }
+  void set_mic_channel(uint8_t mic_channel) { this->mic_channel_ = mic_channel; }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  esp_err_t close_() override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  template<typename T> void process_frames_(T *samples, size_t num_frames);
+  void process_chunk_();
+  void destroy_handles_();
+
+  uint8_t ns_level_{2};
+  uint8_t agc_target_dbfs_{3};
+  uint8_t agc_max_gain_db_{15};
+  uint8_t mic_channel_{0};
+  pcm_format format_{16000, 16, 2};
+
+  // only accessed from the element's task
+  ns_handle_t ns_handle_{nullptr};
+  void *agc_handle_{nullptr};
+  bool active_{false};
+  size_t chunk_pos_{0};
+  std::vector<int16_t> in_chunk_;
+  std::vector<int16_t> ns_chunk_;
+  std::vector<int16_t> out_chunk_;
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
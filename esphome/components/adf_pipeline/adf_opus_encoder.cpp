@@ -0,0 +1,136 @@
+#include "adf_opus_encoder.h"
+
+#ifdef USE_ESP_IDF
+
+#ifdef USE_ADF_OPUS_ENCODER
+
+#include "adf_pipeline.h"
+
+#include <algorithm>
+#include <cstring>
+#include <esp_cpu.h>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_opus_encoder";
+
+static bool is_opus_rate(int rate) {
+  return rate == 8000 || rate == 12000 || rate == 16000 || rate == 24000 || rate == 48000;
+}
+
+ADFOpusEncoder::ADFOpusEncoder() {
+  this->element_tag_ = "opus_encoder";
+  // the encoder allocates its scratch memory on the stack
+  this->task_stack_ = 32 * 1024;
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFOpusEncoder::dump_config() {
+  esph_log_config(TAG, "Opus Encoder:");
+  esph_log_config(TAG, "  bitrate: %d bps", this->bitrate_);
+  esph_log_config(TAG, "  complexity: %d", this->complexity_);
+  esph_log_config(TAG, "  frame duration: %u ms", this->frame_duration_ms_);
+}
+
+void ADFOpusEncoder::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 || !is_opus_rate(format.rate) || format.channels < 1 || format.channels > 2) {
+    esph_log_e(TAG, "Unsupported format: %d Hz, %d bits, %d channels", format.rate, format.bits, format.channels);
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFOpusEncoder::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->destroy_encoder_();
+  int err = OPUS_OK;
+  this->encoder_ = opus_encoder_create(in_format.rate, in_format.channels, OPUS_APPLICATION_VOIP, &err);
+  if (err != OPUS_OK) {
+    esph_log_e(TAG, "Couldn't create encoder: %s", opus_strerror(err));
+    this->encoder_ = nullptr;
+    return false;
+  }
+  opus_encoder_ctl(this->encoder_, OPUS_SET_BITRATE(this->bitrate_));
+  opus_encoder_ctl(this->encoder_, OPUS_SET_COMPLEXITY(this->complexity_));
+  opus_encoder_ctl(this->encoder_, OPUS_SET_SIGNAL(OPUS_SIGNAL_VOICE));
+  this->frame_.assign(in_format.rate / 1000 * this->frame_duration_ms_ * in_format.channels, 0);
+  this->frame_fill_ = 0;
+  return true;
+}
+
+void ADFOpusEncoder::destroy_encoder_() {
+  if (this->encoder_ != nullptr) {
+    opus_encoder_destroy(this->encoder_);
+    this->encoder_ = nullptr;
+  }
+}
+
+esp_err_t ADFOpusEncoder::close_() {
+  this->destroy_encoder_();
+  return ESP_OK;
+}
+
+int ADFOpusEncoder::process_(char *buffer, int len) {
+  const bool enabled = this->enabled_;
+  if (enabled != this->encoding_) {
+    this->encoding_ = enabled;
+    this->frame_fill_ = 0;
+    if (enabled && this->encoder_ != nullptr) {
+      opus_encoder_ctl(this->encoder_, OPUS_RESET_STATE);
+    }
+  }
+  if (!enabled) {
+    return ADFPCMProcessElement::process_(buffer, len);
+  }
+
+  int read = 0;
+  const int aligned = this->read_frames_(buffer, len, read);
+  if (aligned == 0 || this->encoder_ == nullptr) {
+    return read;
+  }
+
+  const int16_t *samples = (const int16_t *) buffer;
+  size_t num_samples = aligned / sizeof(int16_t);
+  const int channels = this->in_format_.channels;
+  while (num_samples > 0) {
+    const size_t to_copy = std::min(num_samples, this->frame_.size() - this->frame_fill_);
+    std::memcpy(this->frame_.data() + this->frame_fill_, samples, to_copy * sizeof(int16_t));
+    this->frame_fill_ += to_copy;
+    samples += to_copy;
+    num_samples -= to_copy;
+    if (this->frame_fill_ < this->frame_.size()) {
+      break;
+    }
+    this->frame_fill_ = 0;
+
+    const uint32_t start = esp_cpu_get_ccount();
+    const int packet_len = opus_encode(this->encoder_, this->frame_.data(), this->frame_.size() / channels,
+                                       this->packet_ + OPUS_PACKET_HEADER_SIZE, OPUS_MAX_PACKET_SIZE);
+    this->process_cycles_ += esp_cpu_get_ccount() - start;
+    this->processed_frames_ += this->frame_.size() / channels;
+    if (packet_len < 0) {
+      esph_log_e(TAG, "Encoding failed: %s", opus_strerror(packet_len));
+      return AEL_PROCESS_FAIL;
+    }
+    this->packet_[0] = (uint8_t) (packet_len >> 8);
+    this->packet_[1] = (uint8_t) packet_len;
+    const int written = this->write_output_((char *) this->packet_, OPUS_PACKET_HEADER_SIZE + packet_len);
+    if (written <= 0) {
+      return written;
+    }
+  }
+  return read;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
+#endif
@@ -0,0 +1,76 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_ADF_OPUS_ENCODER
+
+#include <atomic>
+#include <vector>
+
+#include "esphome/core/component.h"
+
+#include "adf_audio_process.h"
+
+#include <opus.h>
+
+namespace esphome {
+namespace esp_adf {
+
+// upper bound of an encoded frame, fits into a single datagram of the voice assistant
+static const int OPUS_MAX_PACKET_SIZE = 1000;
+// every packet is preceded by its length as 16 bit big endian value
+static const int OPUS_PACKET_HEADER_SIZE = 2;
+
+/*
+Opus encoder for the microphone pipeline, e.g. to reduce the voice assistant's uplink from 256 kbps
+to the configured bitrate. Encodes 16 bit frames of frame_duration on the element's task and writes
+the packets prefixed with their length, so the reader can restore the packet boundaries from the
+byte stream. Has to be the last element before the microphone.
+If it is disabled, the PCM stream is passed on unchanged, e.g. as long as the voice assistant's
+server hasn't accepted Opus.
+*/
+class ADFOpusEncoder : public ADFPCMProcessElement, public Component {
+ public:
+  ADFOpusEncoder();
+
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  const std::string get_name() override { return "OpusEncoder"; }
+
+  void set_bitrate(int bitrate) { this->bitrate_ = bitrate; }
+  void set_complexity(int complexity) { this->complexity_ = complexity; }
+  void set_frame_duration(uint32_t frame_duration_ms) { this->frame_duration_ms_ = frame_duration_ms; }
+  // takes effect with the next block, the encoder starts a new packet stream when it's enabled again
+  void set_enabled(bool enabled) { this->enabled_ = enabled; }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  esp_err_t close_() override;
+  int process_(char *buffer, int len) override;
+
+  void destroy_encoder_();
+
+  int bitrate_{24000};
+  int complexity_{5};
+  uint32_t frame_duration_ms_{20};
+  pcm_format format_{16000, 16, 1};
+  std::atomic<bool> enabled_{true};
+
+  // only accessed from the element's task
+  OpusEncoder *encoder_{nullptr};
+  // samples of the frame being collected
+  std::vector<int16_t> frame_;
+  size_t frame_fill_{0};
+  bool encoding_{true};
+  uint8_t packet_[OPUS_PACKET_HEADER_SIZE + OPUS_MAX_PACKET_SIZE];
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
+#endif
@@ -212,6 +212,9 @@ void ADFPipeline::check_for_pipeline_events_(){
         std::memcpy(&status, &msg.data, sizeof(audio_element_status_t));
         audio_element_handle_t el = (audio_element_handle_t) msg.source;
         esph_log_i(TAG, "[ %s ] status: %d", audio_element_get_tag(el), status);
+        if (this->is_restarting_(el)) {
+          return;
+        }
         switch (status) {
           case AEL_STATUS_STATE_STOPPED:
           case AEL_STATUS_STATE_FINISHED:
@@ -262,6 +265,17 @@ void ADFPipeline::forward_event_to_pipeline_elements_(audio_event_iface_msg_t &m
   }
 }
 
+bool ADFPipeline::is_restarting_(audio_element_handle_t el) const {
+  for (auto *element : this->pipeline_elements_) {
+    for (auto sdk_el : element->get_adf_elements()) {
+      if (sdk_el == el) {
+        return element->is_restarting();
+      }
+    }
+  }
+  return false;
+}
+
 void ADFPipeline::append_element(ADFPipelineElement *element) {
   const bool isFirst = pipeline_elements_.size() == 0;
   if (isFirst) {
@@ -289,14 +303,48 @@ std::vector<std::string> ADFPipeline::get_element_names() {
 }
 
 bool ADFPipeline::request_settings(AudioPipelineSettingsRequest &request) {
+  this->requesting_settings_ = true;
   for (auto it = pipeline_elements_.rbegin(); it != pipeline_elements_.rend(); ++it) {
     if (*it != request.requested_by) {
       (*it)->on_settings_request(request);
     }
   }
+  this->requesting_settings_ = false;
+
+  // format changes take effect in stream order, an element switches where the element in front of it did
+  bool upstream_switches = false;
+  for (size_t i = 0; i < pipeline_elements_.size(); i++) {
+    ADFPipelineElement *next = i + 1 < pipeline_elements_.size() ? pipeline_elements_[i + 1] : nullptr;
+    upstream_switches = pipeline_elements_[i]->on_settings_request_done(next, upstream_switches);
+  }
   return !request.failed;
 }
 
+pcm_format ADFPipeline::get_format_at(const ADFPipelineElement *element, const AudioPipelineSettingsRequest &request,
+                                      const pcm_format &current) const {
+  uint8_t converted = 0;
+  for (auto *el : pipeline_elements_) {
+    if (el == element) {
+      break;
+    }
+    converted |= el->converts_format();
+  }
+  pcm_format format = current;
+  format.rate = request.sampling_rate > 0 ? request.sampling_rate : format.rate;
+  format.bits = request.bit_depth > 0 ? request.bit_depth : format.bits;
+  format.channels = request.number_of_channels > 0 ? request.number_of_channels : format.channels;
+  if ((converted & PCM_RATE) && request.final_sampling_rate > 0) {
+    format.rate = request.final_sampling_rate;
+  }
+  if ((converted & PCM_BITS) && request.final_bit_depth > 0) {
+    format.bits = request.final_bit_depth;
+  }
+  if ((converted & PCM_CHANNELS) && request.final_number_of_channels > 0) {
+    format.channels = request.final_number_of_channels;
+  }
+  return format;
+}
+
 void ADFPipeline::set_state_(PipelineState state) {
   esph_log_d(TAG, "State changed from %s to %s", LOG_STR_ARG(pipeline_state_to_string(this->state_)),
              LOG_STR_ARG(pipeline_state_to_string(state)));
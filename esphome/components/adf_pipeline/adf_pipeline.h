@@ -67,7 +67,12 @@ class ADFPipeline {
 
   // Send a settings request to all pipeline elements
   bool request_settings(AudioPipelineSettingsRequest &request);
+  // set while a settings request passes the elements
+  bool is_requesting_settings() const { return this->requesting_settings_; }
   void on_settings_request_failed(AudioPipelineSettingsRequest request) {}
+  // stream format seen by the element, based on a settings request and the elements in front of it
+  pcm_format get_format_at(const ADFPipelineElement *element, const AudioPipelineSettingsRequest &request,
+                           const pcm_format &current) const;
 
  protected:
   bool init_();
@@ -88,6 +93,7 @@ class ADFPipeline {
   void check_if_components_are_ready_();
   void check_for_pipeline_events_();
   void forward_event_to_pipeline_elements_(audio_event_iface_msg_t &msg);
+  bool is_restarting_(audio_element_handle_t el) const;
 
   bool build_adf_pipeline_();
   void deinit_all_();
@@ -100,6 +106,7 @@ class ADFPipeline {
 
   PipelineState state_{PipelineState::UNINITIALIZED};
   bool destroy_on_stop_{false};
+  bool requesting_settings_{false};
   uint32_t preparation_started_at_{0};
 };
 
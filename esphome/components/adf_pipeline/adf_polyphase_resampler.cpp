@@ -0,0 +1,211 @@
+#include "adf_polyphase_resampler.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+struct ResampleTier {
+  // taps per phase when not decimating, scaled with the decimation factor otherwise
+  int taps;
+  float stopband_db;
+  // Q15 coefficients limit the noise floor to about -80 dB if there are several phases,
+  // a second table with the residual extends them by FINE_BITS at twice the cost
+  bool fine;
+};
+
+// small enough that the dot product over the residuals can't overflow
+static const int FINE_BITS = 8;
+
+static const ResampleTier RESAMPLE_TIERS[] = {
+    {16, 50.f, false},  // LOW
+    {32, 70.f, false},  // MEDIUM
+    {64, 90.f, true},   // HIGH
+};
+
+static float bessel_i0(float x) {
+  float sum = 1.f;
+  float term = 1.f;
+  const float half_x = x / 2.f;
+  for (int k = 1; k < 50; k++) {
+    term *= half_x / k;
+    const float term_sq = term * term;
+    sum += term_sq;
+    if (term_sq < sum * 1e-8f) {
+      break;
+    }
+  }
+  return sum;
+}
+
+bool PolyphaseResampler::configure(int src_rate, int dst_rate, int channels, ResampleQuality quality,
+                                   size_t max_in_frames) {
+  if (quality == ResampleQuality::ADF || src_rate <= 0 || dst_rate <= 0) {
+    return false;
+  }
+  const int divisor = std::gcd(src_rate, dst_rate);
+  const int up = dst_rate / divisor;
+  const int down = src_rate / divisor;
+  if (up > MAX_PHASES) {
+    return false;
+  }
+  this->channels_ = std::max(1, std::min(channels, MAX_CHANNELS));
+
+  if (src_rate != this->src_rate_ || dst_rate != this->dst_rate_ || quality != this->quality_) {
+    this->src_rate_ = src_rate;
+    this->dst_rate_ = dst_rate;
+    this->quality_ = quality;
+    this->up_ = up;
+    this->down_ = down;
+    const ResampleTier &tier = RESAMPLE_TIERS[(int) quality - 1];
+    // the filter has to span the same time when decimating, so more taps are needed
+    this->taps_ = tier.taps * std::max(1, (down + up - 1) / up);
+    this->design_filter_(tier.stopband_db, tier.fine);
+  }
+
+  this->capacity_ = this->taps_ + max_in_frames;
+  this->history_.assign(this->channels_ * this->capacity_, 0);
+  this->reset();
+  return true;
+}
+
+void PolyphaseResampler::design_filter_(float stopband_db, bool fine) {
+  const int num_taps = this->taps_ * this->up_;
+  const int min_rate = std::min(this->src_rate_, this->dst_rate_);
+  const float pi = 3.14159265358979f;
+  const float beta = stopband_db > 50.f
+                         ? 0.1102f * (stopband_db - 8.7f)
+                         : 0.5842f * powf(stopband_db - 21.f, 0.4f) + 0.07886f * (stopband_db - 21.f);
+  // Kaiser's estimate of the transition width for this length, relative to the lower Nyquist frequency,
+  // the cutoff is put in its middle so the stopband starts at the Nyquist frequency
+  const float transition =
+      std::min(0.5f, (stopband_db - 8.f) * this->src_rate_ / (2.285f * pi * this->taps_ * min_rate));
+  // cutoff in cycles per sample at the up-sampled rate
+  const float cutoff = (1.f - transition / 2.f) * 0.5f * min_rate / ((float) this->up_ * this->src_rate_);
+
+  std::vector<float> prototype(num_taps);
+  const float center = (num_taps - 1) / 2.f;
+  const float i0_beta = bessel_i0(beta);
+  for (int n = 0; n < (num_taps + 1) / 2; n++) {
+    const float x = n - center;
+    const float sinc = x == 0.f ? 2.f * cutoff : sinf(2.f * pi * cutoff * x) / (pi * x);
+    const float r = 2.f * n / (num_taps - 1) - 1.f;
+    const float window = bessel_i0(beta * sqrtf(std::max(0.f, 1.f - r * r))) / i0_beta;
+    prototype[n] = prototype[num_taps - 1 - n] = sinc * window;
+  }
+
+  // every phase is normalized to unity gain, which keeps DC free of ripple between the phases
+  const int64_t unity = (int64_t) 1 << (fine ? 15 + FINE_BITS : 15);
+  std::vector<int64_t> quantized(this->taps_);
+  this->coefs_.assign(num_taps, 0);
+  this->coefs_fine_.assign(fine ? num_taps : 0, 0);
+  for (int phase = 0; phase < this->up_; phase++) {
+    float sum = 0.f;
+    for (int k = 0; k < this->taps_; k++) {
+      sum += prototype[phase + k * this->up_];
+    }
+    int64_t total = 0;
+    int peak = 0;
+    for (int k = 0; k < this->taps_; k++) {
+      const int idx = this->taps_ - 1 - k;
+      quantized[idx] = llroundf(prototype[phase + k * this->up_] / sum * (float) unity);
+      total += quantized[idx];
+      if (std::abs(quantized[idx]) > std::abs(quantized[peak])) {
+        peak = idx;
+      }
+    }
+    quantized[peak] += unity - total;
+
+    int16_t *coefs = &this->coefs_[phase * this->taps_];
+    for (int k = 0; k < this->taps_; k++) {
+      if (fine) {
+        const int64_t coarse = (quantized[k] + (1 << (FINE_BITS - 1))) >> FINE_BITS;
+        coefs[k] = (int16_t) coarse;
+        this->coefs_fine_[phase * this->taps_ + k] = (int16_t) (quantized[k] - coarse * (1 << FINE_BITS));
+      } else {
+        coefs[k] = (int16_t) quantized[k];
+      }
+    }
+  }
+}
+
+void PolyphaseResampler::reset() {
+  std::fill(this->history_.begin(), this->history_.end(), 0);
+  this->fill_ = this->taps_ - 1;
+  this->pos_ = this->taps_ - 1;
+  this->phase_ = 0;
+}
+
+static inline int32_t dot_s16(const int16_t *coefs, const int16_t *samples, int n) {
+  int32_t acc0 = 0;
+  int32_t acc1 = 0;
+  int32_t acc2 = 0;
+  int32_t acc3 = 0;
+  int k = 0;
+  for (; k + 4 <= n; k += 4) {
+    acc0 += (int32_t) coefs[k] * samples[k];
+    acc1 += (int32_t) coefs[k + 1] * samples[k + 1];
+    acc2 += (int32_t) coefs[k + 2] * samples[k + 2];
+    acc3 += (int32_t) coefs[k + 3] * samples[k + 3];
+  }
+  for (; k < n; k++) {
+    acc0 += (int32_t) coefs[k] * samples[k];
+  }
+  return acc0 + acc1 + acc2 + acc3;
+}
+
+size_t PolyphaseResampler::process(const int16_t *src, size_t num_frames, int16_t *dst) {
+  const int channels = this->channels_;
+  num_frames = std::min(num_frames, this->capacity_ - this->fill_);
+  int16_t *history[MAX_CHANNELS];
+  for (int ch = 0; ch < channels; ch++) {
+    history[ch] = &this->history_[ch * this->capacity_] + this->fill_;
+  }
+  audio_deinterleave_s16(history, src, num_frames, channels);
+  this->fill_ += num_frames;
+
+  size_t out_frames = 0;
+  while (this->pos_ < this->fill_) {
+    const int16_t *coefs = &this->coefs_[this->phase_ * this->taps_];
+    const size_t first = this->pos_ + 1 - this->taps_;
+    for (int ch = 0; ch < channels; ch++) {
+      const int16_t *samples = &this->history_[ch * this->capacity_ + first];
+      int32_t value;
+      if (this->coefs_fine_.empty()) {
+        value = (dot_s16(coefs, samples, this->taps_) + (1 << 14)) >> 15;
+      } else {
+        const int64_t acc = (int64_t) dot_s16(coefs, samples, this->taps_) * (1 << FINE_BITS) +
+                            dot_s16(&this->coefs_fine_[this->phase_ * this->taps_], samples, this->taps_);
+        value = (int32_t) ((acc + (1 << (14 + FINE_BITS))) >> (15 + FINE_BITS));
+      }
+      dst[out_frames * channels + ch] = (int16_t) std::max(-32768, std::min(32767, value));
+    }
+    out_frames++;
+    this->phase_ += this->down_;
+    this->pos_ += this->phase_ / this->up_;
+    this->phase_ %= this->up_;
+  }
+
+  // keep the history needed by the next output sample
+  const size_t consumed = std::min(this->pos_ + 1 - this->taps_, this->fill_);
+  const size_t remaining = this->fill_ - consumed;
+  for (int ch = 0; ch < channels; ch++) {
+    int16_t *history = &this->history_[ch * this->capacity_];
+    std::memmove(history, history + consumed, remaining * sizeof(int16_t));
+  }
+  this->fill_ = remaining;
+  this->pos_ -= consumed;
+  return out_frames;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace esp_adf {
+
+// ADF uses the esp_resample library, the others the polyphase resampler below
+enum class ResampleQuality : uint8_t { ADF = 0, LOW, MEDIUM, HIGH };
+
+/*
+Polyphase sample rate converter for interleaved 16 bit frames. The ratio is reduced to up/down and
+the Kaiser windowed sinc prototype is split into up phases, which are computed once per ratio and
+quality. Each output sample is a single dot product over the last taps input samples, the channels
+are kept in separate planar buffers so the dot product runs over contiguous memory.
+No dependencies on the SDK, so it can also be built and measured on a host.
+*/
+class PolyphaseResampler {
+ public:
+  static constexpr int MAX_PHASES = 320;
+  static constexpr int MAX_CHANNELS = 16;
+
+  // false if the quality is ADF or the reduced ratio needs more than MAX_PHASES phases
+  bool configure(int src_rate, int dst_rate, int channels, ResampleQuality quality, size_t max_in_frames);
+  // clears the history, the tables are kept
+  void reset();
+
+  // upper bound of the frames returned for num_in_frames input frames
+  size_t max_out_frames(size_t num_in_frames) const { return num_in_frames * this->up_ / this->down_ + 2; }
+  // converts up to max_in_frames frames, returns the number of frames written to dst
+  size_t process(const int16_t *src, size_t num_frames, int16_t *dst);
+
+  int get_taps() const { return this->taps_; }
+  int get_phases() const { return this->up_; }
+
+ protected:
+  void design_filter_(float stopband_db, bool fine);
+
+  int src_rate_{0};
+  int dst_rate_{0};
+  ResampleQuality quality_{ResampleQuality::ADF};
+  int up_{1};
+  int down_{1};
+  int taps_{0};
+  int channels_{1};
+
+  // up_ phases of taps_ coefficients in Q15, reversed for a forward dot product
+  std::vector<int16_t> coefs_;
+  // residual of the coefficients in 2^-(15 + FINE_BITS), empty if the tier uses Q15 only
+  std::vector<int16_t> coefs_fine_;
+  // channels_ planar buffers of capacity_ samples: taps_ - 1 samples of history followed by new input
+  std::vector<int16_t> history_;
+  size_t capacity_{0};
+  size_t fill_{0};
+  // newest input sample and phase of the next output sample
+  size_t pos_{0};
+  int phase_{0};
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
@@ -0,0 +1,268 @@
+#include "adf_tone_source.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <esp_cpu.h>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_tone";
+
+static const int TONE_BUFFER_SIZE = 512;
+static const int TONE_RINGBUFFER_SIZE = 2 * 1024;
+static const int TONE_TASK_STACK = 3 * 1024;
+static const int TONE_TASK_PRIO = 5;
+static const int TONE_TASK_CORE = 0;
+
+static inline uint32_t phase_increment(uint32_t freq, uint32_t rate) {
+  return (uint32_t) (((uint64_t) freq << 32) / rate);
+}
+
+void ADFToneSource::dump_config() {
+  esph_log_config(TAG, "Tone Generator:");
+  for (auto &tone : this->tones_) {
+    esph_log_config(TAG, "  %s: %d steps, attack: %dms, release: %dms", tone.name.c_str(), tone.steps.size(),
+                    tone.attack_ms, tone.release_ms);
+  }
+}
+
+void ADFToneSource::add_tone(const std::string &name, uint16_t attack_ms, uint16_t release_ms) {
+  this->tones_.push_back({name, attack_ms, release_ms, {}});
+}
+
+void ADFToneSource::add_tone_step(uint16_t freq_start, uint16_t freq_end, uint16_t duration_ms, uint16_t amplitude) {
+  if (this->tones_.empty()) {
+    esph_log_e(TAG, "Adding a step without a tone.");
+    return;
+  }
+  this->tones_.back().steps.push_back({freq_start, freq_end, duration_ms, amplitude});
+}
+
+void ADFToneSource::play(const std::string &name) {
+  int idx = 0;
+  for (auto &tone : this->tones_) {
+    if (tone.name == name) {
+      break;
+    }
+    idx++;
+  }
+  if (idx == (int) this->tones_.size()) {
+    esph_log_e(TAG, "Unknown tone: %s", name.c_str());
+    return;
+  }
+  if (this->pipeline_ == nullptr) {
+    esph_log_e(TAG, "Tone generator is not part of a pipeline.");
+    return;
+  }
+  if (this->pipeline_->getState() == PipelineState::RUNNING) {
+    // switch tones on the element's task at the next block
+    this->requested_tone_ = idx;
+    return;
+  }
+  this->selected_tone_ = idx;
+  this->pipeline_->start();
+}
+
+bool ADFToneSource::init_adf_elements_() {
+  if (this->sdk_audio_elements_.size() > 0)
+    return true;
+
+  audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+  cfg.open = ADFToneSource::adf_open_;
+  cfg.process = ADFToneSource::adf_process_;
+  cfg.buffer_len = TONE_BUFFER_SIZE;
+  cfg.out_rb_size = TONE_RINGBUFFER_SIZE;
+  cfg.task_stack = TONE_TASK_STACK;
+  cfg.task_prio = TONE_TASK_PRIO;
+  cfg.task_core = TONE_TASK_CORE;
+  cfg.tag = "tone";
+
+  this->adf_tone_generator_ = audio_element_init(&cfg);
+  if (this->adf_tone_generator_ == nullptr) {
+    esph_log_e(TAG, "Couldn't create tone generator element.");
+    return false;
+  }
+  audio_element_setdata(this->adf_tone_generator_, this);
+  audio_element_set_music_info(this->adf_tone_generator_, this->format_.rate, this->format_.channels,
+                               this->format_.bits);
+
+  this->sdk_audio_elements_.push_back(this->adf_tone_generator_);
+  this->sdk_element_tags_.push_back("tone");
+  return true;
+}
+
+void ADFToneSource::clear_adf_elements_() {
+  this->adf_tone_generator_ = nullptr;
+  this->sdk_audio_elements_.clear();
+  this->sdk_element_tags_.clear();
+  this->valid_settings_ = false;
+}
+
+void ADFToneSource::reset_() { this->valid_settings_ = false; }
+
+// the tone generator has no format on its own, it uses whatever the sink prefers
+bool ADFToneSource::is_ready() {
+  if (!this->valid_settings_) {
+    AudioPipelineSettingsRequest request{this};
+    this->valid_settings_ = this->pipeline_->request_settings(request);
+    if (this->valid_settings_) {
+      this->on_settings_request(request);
+    }
+  }
+  return this->valid_settings_;
+}
+
+void ADFToneSource::on_settings_request(AudioPipelineSettingsRequest &request) {
+  if (request.final_sampling_rate > 0) {
+    this->format_.rate = request.final_sampling_rate;
+  }
+  if (request.final_bit_depth > 0) {
+    this->format_.bits = request.final_bit_depth;
+  }
+  if (request.final_number_of_channels > 0) {
+    this->format_.channels = request.final_number_of_channels;
+  }
+  if (this->format_.bits != 16 && this->format_.bits != 24 && this->format_.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (this->adf_tone_generator_ != nullptr) {
+    audio_element_set_music_info(this->adf_tone_generator_, this->format_.rate, this->format_.channels,
+                                 this->format_.bits);
+  }
+  esph_log_d(TAG, "Output format: rate: %d, bits: %d, ch: %d", this->format_.rate, this->format_.bits,
+             this->format_.channels);
+}
+
+void ADFToneSource::start_sequence_() {
+  this->sequence_ = nullptr;
+  if (this->selected_tone_ < 0 || this->selected_tone_ >= (int) this->tones_.size()) {
+    return;
+  }
+  this->sequence_ = &this->tones_[this->selected_tone_];
+  this->step_idx_ = 0;
+  this->tone_.phase = 0;
+  this->cycles_ = 0;
+  this->frames_rendered_ = 0;
+  if (!this->start_step_()) {
+    this->sequence_ = nullptr;
+  }
+}
+
+bool ADFToneSource::start_step_() {
+  if (this->step_idx_ >= this->sequence_->steps.size()) {
+    return false;
+  }
+  const ToneStep &step = this->sequence_->steps[this->step_idx_];
+  const uint32_t rate = this->format_.rate;
+  const uint32_t length = std::max<uint32_t>(1, (uint32_t) step.duration_ms * rate / 1000);
+
+  audio_tone_t &tone = this->tone_;
+  const uint32_t inc_start = phase_increment(step.freq_start, rate);
+  const uint32_t inc_end = phase_increment(step.freq_end, rate);
+  tone.phase_inc = inc_start;
+  tone.phase_inc_delta = (int32_t) (((int64_t) inc_end - (int64_t) inc_start) / (int64_t) length);
+
+  tone.length = length;
+  tone.remaining = length;
+  const int32_t amplitude = (step.freq_start == 0 && step.freq_end == 0) ? 0 : step.amplitude;
+  tone.attack_samples = std::min<uint32_t>((uint32_t) this->sequence_->attack_ms * rate / 1000, length / 2);
+  tone.release_samples = std::min<uint32_t>((uint32_t) this->sequence_->release_ms * rate / 1000, length / 2);
+
+  // envelope is kept in Q30 (amplitude Q15 times ramp Q15)
+  tone.target = amplitude << 15;
+  tone.attack_delta = tone.attack_samples ? tone.target / (int32_t) tone.attack_samples : 0;
+  tone.release_delta = tone.release_samples ? tone.target / (int32_t) tone.release_samples : 0;
+  tone.envelope = tone.attack_samples ? 0 : tone.target;
+  return true;
+}
+
+// renders mono Q15 samples, returns the number of rendered frames
+size_t ADFToneSource::render_(int16_t *dst, size_t num_frames) {
+  size_t rendered = 0;
+  while (rendered < num_frames) {
+    if (this->tone_.remaining == 0) {
+      this->step_idx_++;
+      if (!this->start_step_()) {
+        this->sequence_ = nullptr;
+        break;
+      }
+    }
+    if (this->tone_.target == 0) {
+      // pause
+      const size_t n = std::min<size_t>(num_frames - rendered, this->tone_.remaining);
+      std::memset(dst + rendered, 0, n * sizeof(int16_t));
+      this->tone_.remaining -= n;
+      rendered += n;
+      continue;
+    }
+    rendered += audio_tone_render_s16(dst + rendered, num_frames - rendered, &this->tone_);
+  }
+  return rendered;
+}
+
+esp_err_t ADFToneSource::adf_open_(audio_element_handle_t self) {
+  ADFToneSource *this_ = (ADFToneSource *) audio_element_getdata(self);
+  this_->requested_tone_ = -1;
+  this_->start_sequence_();
+  return ESP_OK;
+}
+
+audio_element_err_t ADFToneSource::adf_process_(audio_element_handle_t self, char *buffer, int len) {
+  ADFToneSource *this_ = (ADFToneSource *) audio_element_getdata(self);
+  const int requested = this_->requested_tone_.exchange(-1);
+  if (requested >= 0) {
+    this_->selected_tone_ = requested;
+    this_->start_sequence_();
+  }
+  if (this_->sequence_ == nullptr) {
+    return AEL_IO_DONE;
+  }
+
+  const pcm_format &fmt = this_->format_;
+  const size_t bytes_per_sample = fmt.bits == 16 ? 2 : 4;
+  const size_t num_frames = len / (bytes_per_sample * fmt.channels);
+
+  const uint32_t start = esp_cpu_get_ccount();
+  int16_t *mono = (int16_t *) buffer;
+  const size_t frames = this_->render_(mono, num_frames);
+
+  // expand in place from the back, so no sample is overwritten before it has been read
+  if (bytes_per_sample == 2) {
+    for (size_t i = frames; i-- > 0;) {
+      const int16_t s = mono[i];
+      for (int ch = 0; ch < fmt.channels; ch++) {
+        mono[i * fmt.channels + ch] = s;
+      }
+    }
+  } else {
+    int32_t *out = (int32_t *) buffer;
+    for (size_t i = frames; i-- > 0;) {
+      const int32_t s = (int32_t) mono[i] << 16;
+      for (int ch = 0; ch < fmt.channels; ch++) {
+        out[i * fmt.channels + ch] = s;
+      }
+    }
+  }
+  this_->cycles_ += esp_cpu_get_ccount() - start;
+  this_->frames_rendered_ += frames;
+
+  if (this_->sequence_ == nullptr && this_->frames_rendered_ > 0) {
+    esph_log_v(TAG, "Rendered %llu frames, %u cycles per frame", this_->frames_rendered_,
+               (uint32_t) (this_->cycles_ / this_->frames_rendered_));
+  }
+
+  const int out_len = frames * bytes_per_sample * fmt.channels;
+  if (out_len == 0) {
+    return AEL_IO_DONE;
+  }
+  return (audio_element_err_t) audio_element_output(self, buffer, out_len);
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
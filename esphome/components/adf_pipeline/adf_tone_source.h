@@ -0,0 +1,96 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+
+#include "adf_audio_sources.h"
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+One step of a tone sequence. A sine sweep from freq_start to freq_end,
+a constant tone if both are equal and silence if both are zero.
+Amplitude is given in Q15.
+*/
+struct ToneStep {
+  uint16_t freq_start;
+  uint16_t freq_end;
+  uint16_t duration_ms;
+  uint16_t amplitude;
+};
+
+struct ToneSequence {
+  std::string name;
+  uint16_t attack_ms;
+  uint16_t release_ms;
+  std::vector<ToneStep> steps;
+};
+
+/*
+Synthesises short tones (earcons) directly in the pipeline format negotiated with the sink,
+e.g. for giving feedback on wake word detection or errors without decoding audio files.
+*/
+class ADFToneSource : public ADFPipelineSourceElement, public Component {
+ public:
+  // ESPHome Component implementations
+  void setup() override {}
+  void dump_config() override;
+
+  // ADFPipelineSourceElement implementations
+  const std::string get_name() override { return "ToneGenerator"; }
+  bool is_ready() override;
+
+  void add_tone(const std::string &name, uint16_t attack_ms, uint16_t release_ms);
+  void add_tone_step(uint16_t freq_start, uint16_t freq_end, uint16_t duration_ms, uint16_t amplitude);
+
+  // selects the tone and starts the pipeline the element belongs to
+  void play(const std::string &name);
+
+ protected:
+  bool init_adf_elements_() override;
+  void clear_adf_elements_() override;
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  void reset_() override;
+
+  static esp_err_t adf_open_(audio_element_handle_t self);
+  static audio_element_err_t adf_process_(audio_element_handle_t self, char *buffer, int len);
+
+  void start_sequence_();
+  bool start_step_();
+  size_t render_(int16_t *dst, size_t num_frames);
+
+  std::vector<ToneSequence> tones_;
+  int selected_tone_{-1};
+  std::atomic<int> requested_tone_{-1};
+  bool valid_settings_{false};
+  pcm_format format_{16000, 16, 1};
+
+  // synthesis state, only accessed from the element's task
+  const ToneSequence *sequence_{nullptr};
+  size_t step_idx_{0};
+  audio_tone_t tone_{};
+
+  uint64_t cycles_{0};
+  uint64_t frames_rendered_{0};
+
+  audio_element_handle_t adf_tone_generator_{};
+};
+
+template<typename... Ts> class PlayToneAction : public Action<Ts...>, public Parented<ADFToneSource> {
+ public:
+  TEMPLATABLE_VALUE(std::string, tone)
+
+  void play(Ts... x) override { this->parent_->play(this->tone_.value(x...)); }
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
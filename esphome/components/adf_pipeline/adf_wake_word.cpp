@@ -0,0 +1,141 @@
+#include "adf_wake_word.h"
+#include "adf_pipeline.h"
+
+#ifdef USE_ESP_IDF
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace esp_adf {
+
+static const char *const TAG = "esp_audio_wake_word";
+
+static const int WN_SAMPLE_RATE = 16000;
+
+ADFWakeWord::ADFWakeWord() {
+  this->element_tag_ = "wake_word";
+  this->task_stack_ = 8 * 1024;
+  this->stack_in_ext_ = false;
+  this->in_format_ = this->format_;
+  this->out_format_ = this->format_;
+}
+
+void ADFWakeWord::setup() {
+  this->models_ = esp_srmodel_init(this->model_partition_.c_str());
+  if (this->models_ == nullptr) {
+    esph_log_e(TAG, "No speech recognition models found in partition '%s'", this->model_partition_.c_str());
+    this->mark_failed();
+    return;
+  }
+  this->model_name_ = esp_srmodel_filter(this->models_, ESP_WN_PREFIX, this->model_.c_str());
+  if (this->model_name_ == nullptr) {
+    esph_log_e(TAG, "Wake word model '%s' not found", this->model_.c_str());
+    this->mark_failed();
+    return;
+  }
+  this->wakenet_ = (esp_wn_iface_t *) esp_wn_handle_from_name(this->model_name_);
+  if (this->wakenet_ == nullptr) {
+    esph_log_e(TAG, "Couldn't get WakeNet interface for '%s'", this->model_name_);
+    this->mark_failed();
+  }
+}
+
+void ADFWakeWord::loop() {
+  if (this->detected_.load()) {
+    const std::string wake_word(this->detected_word_);
+    this->detected_.store(false);
+    esph_log_d(TAG, "Wake word '%s' detected", wake_word.c_str());
+    this->detected_callback_.call(wake_word);
+  }
+}
+
+void ADFWakeWord::dump_config() {
+  esph_log_config(TAG, "Wake Word:");
+  esph_log_config(TAG, "  model: %s", this->model_name_ != nullptr ? this->model_name_ : this->model_.c_str());
+  esph_log_config(TAG, "  detection mode: %d", (int) this->detection_mode_);
+  esph_log_config(TAG, "  mic channel: %u", this->mic_channel_);
+}
+
+void ADFWakeWord::on_settings_request(AudioPipelineSettingsRequest &request) {
+  pcm_format format = this->pipeline_->get_format_at(this, request, this->format_);
+  if (format.bits != 16 && format.bits != 24 && format.bits != 32) {
+    request.failed = true;
+    request.failed_by = this;
+    return;
+  }
+  if (format.rate != this->format_.rate || format.bits != this->format_.bits ||
+      format.channels != this->format_.channels) {
+    this->format_ = format;
+    this->request_format_(format, format);
+  }
+}
+
+bool ADFWakeWord::on_format_change_(const pcm_format &in_format, const pcm_format &out_format) {
+  this->active_ = in_format.rate == WN_SAMPLE_RATE && this->wakenet_ != nullptr;
+  if (!this->active_) {
+    if (in_format.rate != WN_SAMPLE_RATE) {
+      esph_log_w(TAG, "Wake word detection requires %d Hz, got %d Hz, passing through", WN_SAMPLE_RATE,
+                 in_format.rate);
+    }
+    return true;
+  }
+  if (this->model_data_ == nullptr) {
+    this->model_data_ = this->wakenet_->create(this->model_name_, this->detection_mode_);
+    if (this->model_data_ == nullptr) {
+      esph_log_e(TAG, "Couldn't create WakeNet instance");
+      return false;
+    }
+  }
+  this->chunk_.assign(this->wakenet_->get_samp_chunksize(this->model_data_), 0);
+  this->chunk_pos_ = 0;
+  return true;
+}
+
+esp_err_t ADFWakeWord::close_() {
+  if (this->model_data_ != nullptr) {
+    this->wakenet_->destroy(this->model_data_);
+    this->model_data_ = nullptr;
+  }
+  return ESP_OK;
+}
+
+template<typename T> void ADFWakeWord::process_frames_(const T *samples, size_t num_frames) {
+  const int channels = this->in_format_.channels;
+  const int mic_channel = std::min<int>(this->mic_channel_, channels - 1);
+  const int shift = sizeof(T) > 2 ? 16 : 0;
+  for (size_t frame = 0; frame < num_frames; frame++) {
+    this->chunk_[this->chunk_pos_] = (int16_t) (samples[frame * channels + mic_channel] >> shift);
+    if (++this->chunk_pos_ == this->chunk_.size()) {
+      this->detect_chunk_();
+      this->chunk_pos_ = 0;
+    }
+  }
+}
+
+void ADFWakeWord::detect_chunk_() {
+  int word_index = this->wakenet_->detect(this->model_data_, this->chunk_.data());
+  if (word_index <= 0 || this->detected_.load()) {
+    return;
+  }
+  const char *word = this->wakenet_->get_word_name(this->model_data_, word_index);
+  std::strncpy(this->detected_word_, word != nullptr ? word : "", sizeof(this->detected_word_) - 1);
+  this->detected_.store(true);
+}
+
+int ADFWakeWord::process_pcm_(uint8_t *data, int len) {
+  if (!this->active_) {
+    return len;
+  }
+  if (this->in_format_.bits == 16) {
+    this->process_frames_<int16_t>((int16_t *) data, len / (sizeof(int16_t) * this->in_format_.channels));
+  } else {
+    this->process_frames_<int32_t>((int32_t *) data, len / (sizeof(int32_t) * this->in_format_.channels));
+  }
+  return len;
+}
+
+}  // namespace esp_adf
+}  // namespace esphome
+
+#endif
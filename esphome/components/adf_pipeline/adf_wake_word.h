@@ -0,0 +1,90 @@
+#pragma once
+
+#ifdef USE_ESP_IDF
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+#include "adf_audio_process.h"
+
+#include <esp_wn_iface.h>
+#include <esp_wn_models.h>
+#include <model_path.h>
+
+namespace esphome {
+namespace esp_adf {
+
+/*
+On-device wake word detection with the WakeNet models of esp-sr, placed in the microphone pipeline.
+Processes one channel of 16 kHz streams, the audio is passed on untouched. Other rates are passed on
+without detection. Detections are reported from the main loop, e.g. to let the voice assistant start
+streaming only after the wake word was spoken.
+*/
+class ADFWakeWord : public ADFPCMProcessElement, public Component {
+ public:
+  ADFWakeWord();
+
+  // ESPHome Component implementations
+  void setup() override;
+  void loop() override;
+  void dump_config() override;
+
+  const std::string get_name() override { return "WakeWord"; }
+
+  // model name as found in the model partition, e.g. "wn9_hiesp"
+  void set_model(const std::string &model) { this->model_ = model; }
+  void set_model_partition(const std::string &partition) { this->model_partition_ = partition; }
+  void set_detection_mode(det_mode_t detection_mode) { this->detection_mode_ = detection_mode; }
+  void set_mic_channel(uint8_t mic_channel) { this->mic_channel_ = mic_channel; }
+
+  void add_on_wake_word_detected_callback(std::function<void(const std::string &)> &&callback) {
+    this->detected_callback_.add(std::move(callback));
+  }
+
+ protected:
+  void on_settings_request(AudioPipelineSettingsRequest &request) override;
+  bool on_format_change_(const pcm_format &in_format, const pcm_format &out_format) override;
+  esp_err_t close_() override;
+  int process_pcm_(uint8_t *data, int len) override;
+
+  template<typename T> void process_frames_(const T *samples, size_t num_frames);
+  void detect_chunk_();
+
+  std::string model_{"wn9_hiesp"};
+  std::string model_partition_{"model"};
+  det_mode_t detection_mode_{DET_MODE_90};
+  uint8_t mic_channel_{0};
+  pcm_format format_{16000, 16, 1};
+
+  srmodel_list_t *models_{nullptr};
+  char *model_name_{nullptr};
+  esp_wn_iface_t *wakenet_{nullptr};
+
+  CallbackManager<void(const std::string &)> detected_callback_;
+
+  // set by the element's task, cleared by the main loop after the word was reported
+  std::atomic<bool> detected_{false};
+  char detected_word_[32]{};
+
+  // only accessed from the element's task
+  model_iface_data_t *model_data_{nullptr};
+  bool active_{false};
+  size_t chunk_pos_{0};
+  std::vector<int16_t> chunk_;
+};
+
+class WakeWordDetectedTrigger : public Trigger<std::string> {
+ public:
+  explicit WakeWordDetectedTrigger(ADFWakeWord *parent) {
+    parent->add_on_wake_word_detected_callback([this](const std::string &wake_word) { this->trigger(wake_word); });
+  }
+};
+
+}  // namespace esp_adf
+}  // namespace esphome
+#endif
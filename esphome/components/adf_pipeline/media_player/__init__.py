@@ -1,20 +1,32 @@
 """Media-Player platform implementation as ADF-Pipeline Element."""
 
+import logging
+
 import esphome.codegen as cg
 from esphome.components import media_player
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome.const import CONF_ID, CONF_PLATFORM, CONF_TYPE
+from esphome.core import CORE
 
 from .. import (
     esp_adf_ns,
+    ADFCrossfade,
     ADFPipelineController,
     ADF_PIPELINE_CONTROLLER_SCHEMA,
+    CONF_ADF_PIPELINE,
     setup_pipeline_controller,
 )
 
+_LOGGER = logging.getLogger(__name__)
+
 CODEOWNERS = ["@gnumpi"]
 DEPENDENCIES = ["adf_pipeline", "media_player"]
 
+CONF_CROSSFADE = "crossfade"
+# option of the adf_pipeline I2S output, false keeps a pipeline without software volume
+CONF_ADF_ALC = "adf_alc"
+VOLUME_ELEMENT = "volume"
+
 
 ADFMediaPlayer = esp_adf_ns.class_(
     "ADFMediaPlayer", ADFPipelineController, media_player.MediaPlayer, cg.Component
@@ -23,13 +35,47 @@ ADFMediaPlayer = esp_adf_ns.class_(
 CONFIG_SCHEMA = media_player.MEDIA_PLAYER_SCHEMA.extend(
     {
         cv.GenerateID(): cv.declare_id(ADFMediaPlayer),
+        cv.Optional(CONF_CROSSFADE): cv.use_id(ADFCrossfade),
     }
 ).extend(ADF_PIPELINE_CONTROLLER_SCHEMA)
 
 
+def add_volume_element(config):
+    """Add the volume element in front of the sink if the pipeline has no gain element.
+
+    The volume used to be applied by the ADF ALC of the I2S output, which was enabled by default.
+    """
+    pipeline = config.get(CONF_ADF_PIPELINE)
+    if not pipeline or VOLUME_ELEMENT in pipeline:
+        return config
+    elements = {
+        element[CONF_ID].id: element
+        for element in CORE.config.get("adf_pipeline", [])
+        if CONF_ID in element
+    }
+    configs = [elements.get(getattr(comp_id, "id", None), {}) for comp_id in pipeline]
+    if any(
+        element.get(CONF_PLATFORM) == "adf_elements" and element.get(CONF_TYPE) == "gain"
+        for element in configs
+    ):
+        return config
+    # the last element is the sink, unless the media player itself is
+    if not configs[-1] or not configs[-1].get(CONF_ADF_ALC, True):
+        return config
+    _LOGGER.info(
+        "Media player '%s' has no volume element, adding one in front of '%s'",
+        config[CONF_ID].id,
+        pipeline[-1],
+    )
+    return {**config, CONF_ADF_PIPELINE: pipeline[:-1] + [VOLUME_ELEMENT, pipeline[-1]]}
+
+
 # @coroutine_with_priority(100.0)
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
-    await setup_pipeline_controller(var, config)
+    if CONF_CROSSFADE in config:
+        crossfade = await cg.get_variable(config[CONF_CROSSFADE])
+        cg.add(var.set_crossfade(crossfade))
+    await setup_pipeline_controller(var, add_volume_element(config))
     await media_player.register_media_player(var, config)
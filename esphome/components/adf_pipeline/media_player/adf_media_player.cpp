@@ -1,31 +1,69 @@
 #include "adf_media_player.h"
 #include "esphome/core/log.h"
 
+#ifdef USE_ESP_IDF
+
 namespace esphome {
-namespace adf_media_player {
+namespace esp_adf {
 
-static const char *TAG = "adf_media_player";
+static const char *const TAG = "adf_media_player";
 
 void ADFMediaPlayer::setup() {
   esph_log_i(TAG, "Setting up ADF Media Player");
-  pipeline.setup();
+  this->state = media_player::MEDIA_PLAYER_STATE_IDLE;
 }
 
 void ADFMediaPlayer::loop() {
-  pipeline.loop();
+  ADFPipelineController::loop();
+  if (this->http_and_decoder_.is_restarting() && pipeline.getState() == PipelineState::RUNNING &&
+      this->http_and_decoder_.check_restarted()) {
+    this->crossfade_->release_input();
+  }
+  if (this->stop_after_fade_out_ && this->crossfade_->is_faded_out()) {
+    this->stop_after_fade_out_ = false;
+    pipeline.stop();
+  }
+}
+
+void ADFMediaPlayer::dump_config() {
+  esph_log_config(TAG, "ESP-ADF-MediaPlayer:");
+  esph_log_config(TAG, "  crossfade: %s", YESNO(this->crossfade_ != nullptr));
+  ADFPipelineController::dump_config();
+}
+
+media_player::MediaPlayerTraits ADFMediaPlayer::get_traits() {
+  auto traits = media_player::MediaPlayerTraits();
+  traits.set_supports_pause(true);
+  return traits;
+}
+
+void ADFMediaPlayer::set_stream_uri(const std::string &new_uri) {
+  this->current_uri_ = new_uri;
+  this->http_and_decoder_.set_stream_uri(new_uri);
 }
 
 void ADFMediaPlayer::control(const media_player::MediaPlayerCall &call) {
+  if (call.get_media_url().has_value()) {
+    this->set_stream_uri(call.get_media_url().value());
+    if (pipeline.getState() == PipelineState::STOPPED || pipeline.getState() == PipelineState::UNINITIALIZED) {
+      pipeline.start();
+    } else {
+      this->change_track_();
+    }
+  }
+
+  if (call.get_volume().has_value()) {
+    this->set_volume_(call.get_volume().value());
+    this->unmute_();
+  }
+
   if (call.get_command().has_value()) {
     switch (call.get_command().value()) {
       case media_player::MEDIA_PLAYER_COMMAND_PLAY:
         if (pipeline.getState() == PipelineState::STOPPED || pipeline.getState() == PipelineState::UNINITIALIZED) {
           pipeline.start();
         } else if (pipeline.getState() == PipelineState::PAUSED) {
-          pipeline.restart();
-        } else if (state == media_player::MEDIA_PLAYER_STATE_PLAYING || state == media_player::MEDIA_PLAYER_STATE_PAUSED) {
-          this->play_intent_ = true;
-          pipeline.stop();
+          pipeline.resume();
         }
         break;
       case media_player::MEDIA_PLAYER_COMMAND_PAUSE:
@@ -34,10 +72,8 @@ void ADFMediaPlayer::control(const media_player::MediaPlayerCall &call) {
         }
         break;
       case media_player::MEDIA_PLAYER_COMMAND_STOP:
-        this->current_track_.reset();
-        this->current_uri_.reset();
-        pipeline.stop();
-        this->http_and_decoder_.set_fixed_settings(false);
+        this->play_intent_ = false;
+        this->stop_();
         break;
       case media_player::MEDIA_PLAYER_COMMAND_MUTE:
         this->mute_();
@@ -46,10 +82,12 @@ void ADFMediaPlayer::control(const media_player::MediaPlayerCall &call) {
         this->unmute_();
         break;
       case media_player::MEDIA_PLAYER_COMMAND_TOGGLE:
-        if (pipeline.getState() == PipelineState::STOPPED || pipeline.getState() == PipelineState::PAUSED) {
-          state = media_player::MEDIA_PLAYER_STATE_PLAYING;
+        if (pipeline.getState() == PipelineState::RUNNING) {
+          pipeline.pause();
+        } else if (pipeline.getState() == PipelineState::PAUSED) {
+          pipeline.resume();
         } else {
-          state = media_player::MEDIA_PLAYER_STATE_PAUSED;
+          pipeline.start();
         }
         break;
       case media_player::MEDIA_PLAYER_COMMAND_VOLUME_UP: {
@@ -57,6 +95,7 @@ void ADFMediaPlayer::control(const media_player::MediaPlayerCall &call) {
         if (new_volume > 1.0f)
           new_volume = 1.0f;
         set_volume_(new_volume);
+        this->unmute_();
         break;
       }
       case media_player::MEDIA_PLAYER_COMMAND_VOLUME_DOWN: {
@@ -64,36 +103,109 @@ void ADFMediaPlayer::control(const media_player::MediaPlayerCall &call) {
         if (new_volume < 0.0f)
           new_volume = 0.0f;
         set_volume_(new_volume);
+        this->unmute_();
         break;
       }
-      case media_player::MEDIA_PLAYER_COMMAND_ENQUEUE:
-      case media_player::MEDIA_PLAYER_COMMAND_REPEAT_ONE:
-      case media_player::MEDIA_PLAYER_COMMAND_REPEAT_OFF:
-      case media_player::MEDIA_PLAYER_COMMAND_CLEAR_PLAYLIST:
-        esph_log_w(TAG, "Unhandled media player command: %d", call.get_command().value());
-        break;
       default:
-        esph_log_w(TAG, "Unknown media player command: %d", call.get_command().value());
+        esph_log_w(TAG, "Unhandled media player command: %d", call.get_command().value());
         break;
     }
   }
 }
 
+void ADFMediaPlayer::on_pipeline_state_change(PipelineState state) {
+  switch (state) {
+    case PipelineState::PREPARING:
+      // elements might have been recreated, send the current volume settings again
+      this->request_volume_settings_();
+      break;
+    case PipelineState::RUNNING:
+      this->state = media_player::MEDIA_PLAYER_STATE_PLAYING;
+      this->publish_state();
+      break;
+    case PipelineState::PAUSED:
+      this->state = media_player::MEDIA_PLAYER_STATE_PAUSED;
+      this->publish_state();
+      break;
+    case PipelineState::STOPPED:
+    case PipelineState::UNINITIALIZED:
+      this->stop_after_fade_out_ = false;
+      this->state = media_player::MEDIA_PLAYER_STATE_IDLE;
+      this->publish_state();
+      if (this->play_intent_) {
+        this->play_intent_ = false;
+        pipeline.start();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void ADFMediaPlayer::change_track_() {
+  if (this->crossfade_ != nullptr && pipeline.getState() == PipelineState::RUNNING) {
+    // the tail of the current track is mixed with the new one, the sink keeps running
+    this->stop_after_fade_out_ = false;
+    if (!this->http_and_decoder_.is_restarting()) {
+      this->crossfade_->start_crossfade();
+      this->http_and_decoder_.restart_stream();
+    }
+    return;
+  }
+  // restart with the new uri as soon as the pipeline has stopped
+  this->play_intent_ = true;
+  pipeline.stop();
+}
+
+void ADFMediaPlayer::stop_() {
+  if (this->crossfade_ != nullptr && pipeline.getState() == PipelineState::RUNNING &&
+      !this->http_and_decoder_.is_restarting()) {
+    // stopped by loop() once the crossfade has faded out
+    this->crossfade_->start_fade_out();
+    this->stop_after_fade_out_ = true;
+    return;
+  }
+  this->stop_after_fade_out_ = false;
+  pipeline.stop();
+}
+
 void ADFMediaPlayer::mute_() {
-  this->is_muted_ = true;
-  set_volume_(0.0f);
+  if (this->muted_) {
+    return;
+  }
+  this->muted_ = true;
+  this->request_volume_settings_();
+  this->publish_state();
 }
 
 void ADFMediaPlayer::unmute_() {
-  this->is_muted_ = false;
-  set_volume_(this->previous_volume_);
+  if (!this->muted_) {
+    return;
+  }
+  this->muted_ = false;
+  this->request_volume_settings_();
+  this->publish_state();
 }
 
-void ADFMediaPlayer::set_volume_(float volume) {
-  this->previous_volume_ = this->volume;
+void ADFMediaPlayer::set_volume_(float volume, bool publish) {
   this->volume = volume;
   esph_log_i(TAG, "Setting volume to %.2f", volume);
+  this->request_volume_settings_();
+  if (publish) {
+    this->publish_state();
+  }
 }
 
-}  // namespace adf_media_player
+void ADFMediaPlayer::request_volume_settings_() {
+  AudioPipelineSettingsRequest request;
+  request.target_volume = this->volume;
+  request.mute = this->muted_ ? 1 : 0;
+  if (!this->pipeline.request_settings(request)) {
+    esph_log_e(TAG, "Volume settings didn't get accepted");
+  }
+}
+
+}  // namespace esp_adf
 }  // namespace esphome
+
+#endif
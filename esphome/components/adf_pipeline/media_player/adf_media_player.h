@@ -6,6 +6,7 @@
 
 #include "../adf_pipeline_controller.h"
 #include "../adf_audio_sources.h"
+#include "../adf_crossfade.h"
 
 namespace esphome {
 namespace esp_adf {
@@ -18,6 +19,7 @@ class ADFMediaPlayer : public media_player::MediaPlayer, public ADFPipelineContr
   // ESPHome-Component implementations
   float get_setup_priority() const override { return esphome::setup_priority::LATE; }
   void setup() override;
+  void loop() override;
   void dump_config() override;
 
   // MediaPlayer implementations
@@ -28,21 +30,30 @@ class ADFMediaPlayer : public media_player::MediaPlayer, public ADFPipelineContr
   void set_stream_uri(const std::string& new_uri);
   void start() {pipeline.start();}
   void stop()  {pipeline.stop();}
+  // the crossfade element has to follow the decoder directly
+  void set_crossfade(ADFCrossfade *crossfade) { this->crossfade_ = crossfade; }
 
  protected:
   // MediaPlayer implementation
   void control(const media_player::MediaPlayerCall &call) override;
 
   // Pipeline implementations
-  void on_pipeline_state_change(PipelineState state);
+  void on_pipeline_state_change(PipelineState state) override;
 
   void mute_();
   void unmute_();
   void set_volume_(float volume, bool publish = true);
+  // volume is applied by a gain element in the pipeline or by the sink in hardware
+  void request_volume_settings_();
+  // with a crossfade, track changes only restart the source and stops are faded out
+  void change_track_();
+  void stop_();
 
   bool muted_{false};
   bool play_intent_{false};
   optional<std::string> current_uri_{};
+  ADFCrossfade *crossfade_{nullptr};
+  bool stop_after_fade_out_{false};
 
   HTTPStreamReaderAndDecoder http_and_decoder_;
 };
@@ -9,6 +9,8 @@ from .. import (
     esp_adf_ns,
     ADFPipelineController,
     ADF_PIPELINE_CONTROLLER_SCHEMA,
+    HIGH_PASS_SCHEMA,
+    high_pass_args,
     setup_pipeline_controller,
 )
 
@@ -16,6 +18,7 @@ CODEOWNERS = ["@gnumpi"]
 DEPENDENCIES = ["adf_pipeline", "microphone"]
 
 CONF_GAIN_LOG_2 = "gain_log2"
+CONF_HIGH_PASS = "high_pass"
 
 ADFMicrophone = esp_adf_ns.class_(
     "ADFMicrophone", ADFPipelineController, microphone.Microphone, cg.Component
@@ -25,6 +28,7 @@ CONFIG_SCHEMA = microphone.MICROPHONE_SCHEMA.extend(
     {
         cv.GenerateID(): cv.declare_id(ADFMicrophone),
         cv.Optional(CONF_GAIN_LOG_2, default=0): cv.int_range(0, 7),
+        cv.Optional(CONF_HIGH_PASS): HIGH_PASS_SCHEMA,
     }
 ).extend(ADF_PIPELINE_CONTROLLER_SCHEMA)
 
@@ -33,6 +37,8 @@ CONFIG_SCHEMA = microphone.MICROPHONE_SCHEMA.extend(
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     cg.add(var.set_gain_log2(config[CONF_GAIN_LOG_2]))
+    if CONF_HIGH_PASS in config:
+        cg.add(var.set_high_pass(*high_pass_args(config[CONF_HIGH_PASS])))
     await cg.register_component(var, config)
     await setup_pipeline_controller(var, config)
     await microphone.register_microphone(var, config)
@@ -36,29 +36,8 @@ void ADFMicrophone::stop() {
 
 // len and return size are both in bytes
 size_t ADFMicrophone::read(int16_t *buf, size_t len) {
-    len = (len << 1) >> 1;
-    if (this->pcm_stream_.get_bits_per_sample() == 32 || this->pcm_stream_.get_bits_per_sample() == 24)
-    {
-      len = ( len << 2 ) >> 2;
-      size_t bytes_read = this->pcm_stream_.stream_read_bytes((char *) buf, len << 1  );
-      size_t samples_read = bytes_read / sizeof(int32_t);
-      if( samples_read == 0 ){
-        return 0;
-      }
-
-      std::vector<int16_t> samples;
-      uint8_t shift = 16 - this->gain_log2_ ;
-      samples.resize(samples_read);
-      for (size_t i = 0; i < samples_read; i++) {
-        int32_t temp = ( reinterpret_cast<int32_t *>(buf)[i] ) >> shift;
-         samples[i] = (int16_t) clamp<int32_t>(temp, INT16_MIN, INT16_MAX );
-      }
-      memcpy(buf, samples.data(), samples_read * sizeof(int16_t));
-      return samples_read * sizeof(int16_t);
-    }
-    size_t bytes_read = 0;
-    bytes_read =  this->pcm_stream_.stream_read_bytes((char *) buf, len);
-    return bytes_read;
+  len -= len % sizeof(int16_t);
+  return this->pcm_stream_.stream_read_bytes((char *) buf, len);
 }
 
 void ADFMicrophone::on_pipeline_state_change(PipelineState state) {
@@ -6,6 +6,7 @@
 
 #include "../adf_pipeline_controller.h"
 #include "../adf_audio_sinks.h"
+#include "../adf_bit_depth_converter.h"
 
 namespace esphome {
 namespace esp_adf {
@@ -13,7 +14,10 @@ namespace esp_adf {
 class ADFMicrophone : public microphone::Microphone, public ADFPipelineController {
  public:
   // Pipeline implementations
-  void append_own_elements() { add_element_to_pipeline((ADFPipelineElement *) &(this->pcm_stream_)); }
+  void append_own_elements() {
+    add_element_to_pipeline((ADFPipelineElement *) &(this->bit_depth_converter_));
+    add_element_to_pipeline((ADFPipelineElement *) &(this->pcm_stream_));
+  }
 
   // ESPHome-Component implementations
   float get_setup_priority() const override { return esphome::setup_priority::LATE; }
@@ -26,11 +30,15 @@ class ADFMicrophone : public microphone::Microphone, public ADFPipelineControlle
   size_t read(int16_t *buf, size_t len) override;
 
   // additional setup
-  void set_gain_log2( uint8_t gain_log2){this->gain_log2_ = gain_log2;}
+  void set_gain_log2(uint8_t gain_log2) { this->bit_depth_converter_.set_gain_log2(gain_log2); }
+  void set_high_pass(bool dc_blocker, float frequency) {
+    this->bit_depth_converter_.set_high_pass(dc_blocker, frequency);
+  }
  protected:
   void on_pipeline_state_change(PipelineState state) override;
 
-  uint8_t gain_log2_{3};
+  // 24 and 32 bit streams are converted to 16 bit on the pipeline's task, optionally high-pass filtered
+  ADFBitDepthConverter bit_depth_converter_;
   PCMSink pcm_stream_;
 };
 
@@ -0,0 +1,3 @@
+"""Sample format kernels shared by the I2S drivers and the ADF-Pipeline elements."""
+
+CODEOWNERS = ["@gnumpi"]
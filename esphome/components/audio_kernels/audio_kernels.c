@@ -0,0 +1,415 @@
+#include "audio_kernels.h"
+
+#include <math.h>
+#include <string.h>
+
+// samples per iteration of the unrolled loops, lets the compiler keep a group in registers
+#define KERNEL_UNROLL 4
+
+static inline int16_t sat_s16_32(int32_t value) {
+  return (int16_t) (value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+}
+
+void audio_s32_to_s16(const int32_t *src, int16_t *dst, size_t num_samples, int shift) {
+  // a group is loaded completely before it is stored, which keeps in place conversion intact
+  // memcpy keeps the compiler from assuming that src and dst don't alias
+  size_t i = 0;
+  for (; i + KERNEL_UNROLL <= num_samples; i += KERNEL_UNROLL) {
+    int32_t in[KERNEL_UNROLL];
+    int16_t out[KERNEL_UNROLL];
+    memcpy(in, src + i, sizeof(in));
+    out[0] = sat_s16_32(in[0] >> shift);
+    out[1] = sat_s16_32(in[1] >> shift);
+    out[2] = sat_s16_32(in[2] >> shift);
+    out[3] = sat_s16_32(in[3] >> shift);
+    memcpy(dst + i, out, sizeof(out));
+  }
+  for (; i < num_samples; i++) {
+    int32_t in;
+    memcpy(&in, src + i, sizeof(in));
+    const int16_t out = sat_s16_32(in >> shift);
+    memcpy(dst + i, &out, sizeof(out));
+  }
+}
+
+void audio_s16_to_s32(const int16_t *src, int32_t *dst, size_t num_samples) {
+  // growing in place, so start at the end
+  size_t i = num_samples;
+  for (; i >= KERNEL_UNROLL; i -= KERNEL_UNROLL) {
+    int16_t in[KERNEL_UNROLL];
+    int32_t out[KERNEL_UNROLL];
+    memcpy(in, src + i - KERNEL_UNROLL, sizeof(in));
+    out[0] = (int32_t) in[0] << 16;
+    out[1] = (int32_t) in[1] << 16;
+    out[2] = (int32_t) in[2] << 16;
+    out[3] = (int32_t) in[3] << 16;
+    memcpy(dst + i - KERNEL_UNROLL, out, sizeof(out));
+  }
+  for (; i > 0; i--) {
+    int16_t in;
+    memcpy(&in, src + i - 1, sizeof(in));
+    const int32_t out = (int32_t) in << 16;
+    memcpy(dst + i - 1, &out, sizeof(out));
+  }
+}
+
+void audio_scale_s16(int16_t *samples, size_t num_samples, int32_t gain, int shift) {
+  size_t i = 0;
+  for (; i + KERNEL_UNROLL <= num_samples; i += KERNEL_UNROLL) {
+    samples[i] = audio_sat_s16(((int64_t) samples[i] * gain) >> shift);
+    samples[i + 1] = audio_sat_s16(((int64_t) samples[i + 1] * gain) >> shift);
+    samples[i + 2] = audio_sat_s16(((int64_t) samples[i + 2] * gain) >> shift);
+    samples[i + 3] = audio_sat_s16(((int64_t) samples[i + 3] * gain) >> shift);
+  }
+  for (; i < num_samples; i++) {
+    samples[i] = audio_sat_s16(((int64_t) samples[i] * gain) >> shift);
+  }
+}
+
+void audio_scale_s32(int32_t *samples, size_t num_samples, int32_t gain, int shift) {
+  size_t i = 0;
+  for (; i + KERNEL_UNROLL <= num_samples; i += KERNEL_UNROLL) {
+    samples[i] = audio_sat_s32(((int64_t) samples[i] * gain) >> shift);
+    samples[i + 1] = audio_sat_s32(((int64_t) samples[i + 1] * gain) >> shift);
+    samples[i + 2] = audio_sat_s32(((int64_t) samples[i + 2] * gain) >> shift);
+    samples[i + 3] = audio_sat_s32(((int64_t) samples[i + 3] * gain) >> shift);
+  }
+  for (; i < num_samples; i++) {
+    samples[i] = audio_sat_s32(((int64_t) samples[i] * gain) >> shift);
+  }
+}
+
+size_t audio_gain_ramp_s16(int16_t *samples, size_t num_frames, int channels, int32_t *gain, int32_t step,
+                           uint32_t *remaining, int32_t target, int shift) {
+  int32_t g = *gain;
+  uint32_t left = *remaining;
+  size_t f = 0;
+  for (; f < num_frames && left > 0; f++) {
+    g = --left == 0 ? target : g + step;
+    for (int ch = 0; ch < channels; ch++) {
+      samples[f * channels + ch] = audio_sat_s16(((int64_t) samples[f * channels + ch] * g) >> shift);
+    }
+  }
+  *gain = g;
+  *remaining = left;
+  return f;
+}
+
+size_t audio_gain_ramp_s32(int32_t *samples, size_t num_frames, int channels, int32_t *gain, int32_t step,
+                           uint32_t *remaining, int32_t target, int shift) {
+  int32_t g = *gain;
+  uint32_t left = *remaining;
+  size_t f = 0;
+  for (; f < num_frames && left > 0; f++) {
+    g = --left == 0 ? target : g + step;
+    for (int ch = 0; ch < channels; ch++) {
+      samples[f * channels + ch] = audio_sat_s32(((int64_t) samples[f * channels + ch] * g) >> shift);
+    }
+  }
+  *gain = g;
+  *remaining = left;
+  return f;
+}
+
+void audio_mix_ramp_s16(int16_t *dst, const int16_t *a, int32_t a_from, int32_t a_to, const int16_t *b,
+                        int32_t b_from, int32_t b_to, size_t num_frames, int channels, int shift) {
+  if (num_frames == 0) {
+    return;
+  }
+  const int32_t a_step = (a_to - a_from) / (int32_t) num_frames;
+  const int32_t b_step = (b_to - b_from) / (int32_t) num_frames;
+  int32_t a_gain = a_from;
+  int32_t b_gain = b_from;
+  for (size_t f = 0; f < num_frames; f++) {
+    for (int ch = 0; ch < channels; ch++) {
+      const size_t i = f * channels + ch;
+      int64_t value = (int64_t) a[i] * a_gain;
+      if (b != NULL) {
+        value += (int64_t) b[i] * b_gain;
+      }
+      dst[i] = audio_sat_s16(value >> shift);
+    }
+    a_gain += a_step;
+    b_gain += b_step;
+  }
+}
+
+void audio_mix_ramp_s32(int32_t *dst, const int32_t *a, int32_t a_from, int32_t a_to, const int32_t *b,
+                        int32_t b_from, int32_t b_to, size_t num_frames, int channels, int shift) {
+  if (num_frames == 0) {
+    return;
+  }
+  const int32_t a_step = (a_to - a_from) / (int32_t) num_frames;
+  const int32_t b_step = (b_to - b_from) / (int32_t) num_frames;
+  int32_t a_gain = a_from;
+  int32_t b_gain = b_from;
+  for (size_t f = 0; f < num_frames; f++) {
+    for (int ch = 0; ch < channels; ch++) {
+      const size_t i = f * channels + ch;
+      int64_t value = (int64_t) a[i] * a_gain;
+      if (b != NULL) {
+        value += (int64_t) b[i] * b_gain;
+      }
+      dst[i] = audio_sat_s32(value >> shift);
+    }
+    a_gain += a_step;
+    b_gain += b_step;
+  }
+}
+
+uint64_t audio_level_s16(const int16_t *samples, size_t num_samples, uint32_t *peak) {
+  // one multiply-accumulate and two compares per sample, which the compiler can vectorize
+  uint64_t sum_squares = 0;
+  int16_t max_value = 0;
+  int16_t min_value = 0;
+  for (size_t i = 0; i < num_samples; i++) {
+    const int32_t value = samples[i];
+    sum_squares += (uint32_t) (value * value);
+    max_value = value > max_value ? value : max_value;
+    min_value = value < min_value ? value : min_value;
+  }
+  const uint32_t block_peak = (uint32_t) (max_value > -min_value ? max_value : -min_value) << 16;
+  *peak = block_peak > *peak ? block_peak : *peak;
+  return sum_squares;
+}
+
+uint64_t audio_level_s32(const int32_t *samples, size_t num_samples, uint32_t *peak) {
+  uint64_t sum_squares = 0;
+  int32_t max_value = 0;
+  int32_t min_value = 0;
+  for (size_t i = 0; i < num_samples; i++) {
+    const int32_t value = samples[i] >> 16;
+    sum_squares += (uint32_t) (value * value);
+    max_value = samples[i] > max_value ? samples[i] : max_value;
+    min_value = samples[i] < min_value ? samples[i] : min_value;
+  }
+  const uint32_t max_mag = (uint32_t) max_value;
+  const uint32_t min_mag = (uint32_t) (-(int64_t) min_value);
+  const uint32_t block_peak = max_mag > min_mag ? max_mag : min_mag;
+  *peak = block_peak > *peak ? block_peak : *peak;
+  return sum_squares;
+}
+
+void audio_swap_pairs_s16(int16_t *samples, size_t num_samples) {
+  for (size_t i = 0; i + 1 < num_samples; i += 2) {
+    const int16_t first = samples[i];
+    samples[i] = samples[i + 1];
+    samples[i + 1] = first;
+  }
+}
+
+void audio_swap_pairs_s32(int32_t *samples, size_t num_samples) {
+  for (size_t i = 0; i + 1 < num_samples; i += 2) {
+    const int32_t first = samples[i];
+    samples[i] = samples[i + 1];
+    samples[i + 1] = first;
+  }
+}
+
+void audio_dac_scale_s16(int16_t *samples, size_t num_samples) {
+  // keep the upper byte and flip the sign bit, turns signed into unsigned
+  uint16_t *values = (uint16_t *) samples;
+  for (size_t i = 0; i < num_samples; i++) {
+    values[i] = (values[i] & 0xff00) ^ 0x8000;
+  }
+}
+
+void audio_dac_scale_s32(int32_t *samples, size_t num_samples) {
+  uint32_t *values = (uint32_t *) samples;
+  for (size_t i = 0; i < num_samples; i++) {
+    values[i] = (values[i] & 0xff000000) ^ 0x80000000;
+  }
+}
+
+// stereo gets its own loop, the generic one strides over a channel count only known at runtime
+void audio_deinterleave_s16(int16_t *const *dst, const int16_t *src, size_t num_frames, int channels) {
+  if (channels == 2) {
+    int16_t *left = dst[0];
+    int16_t *right = dst[1];
+    for (size_t f = 0; f < num_frames; f++) {
+      left[f] = src[2 * f];
+      right[f] = src[2 * f + 1];
+    }
+    return;
+  }
+  for (int ch = 0; ch < channels; ch++) {
+    int16_t *out = dst[ch];
+    for (size_t f = 0; f < num_frames; f++) {
+      out[f] = src[f * channels + ch];
+    }
+  }
+}
+
+void audio_deinterleave_s32(int32_t *const *dst, const int32_t *src, size_t num_frames, int channels) {
+  if (channels == 2) {
+    int32_t *left = dst[0];
+    int32_t *right = dst[1];
+    for (size_t f = 0; f < num_frames; f++) {
+      left[f] = src[2 * f];
+      right[f] = src[2 * f + 1];
+    }
+    return;
+  }
+  for (int ch = 0; ch < channels; ch++) {
+    int32_t *out = dst[ch];
+    for (size_t f = 0; f < num_frames; f++) {
+      out[f] = src[f * channels + ch];
+    }
+  }
+}
+
+void audio_interleave_s16(int16_t *dst, const int16_t *const *src, size_t num_frames, int channels) {
+  if (channels == 2) {
+    const int16_t *left = src[0];
+    const int16_t *right = src[1];
+    for (size_t f = 0; f < num_frames; f++) {
+      dst[2 * f] = left[f];
+      dst[2 * f + 1] = right[f];
+    }
+    return;
+  }
+  for (int ch = 0; ch < channels; ch++) {
+    const int16_t *in = src[ch];
+    for (size_t f = 0; f < num_frames; f++) {
+      dst[f * channels + ch] = in[f];
+    }
+  }
+}
+
+void audio_interleave_s32(int32_t *dst, const int32_t *const *src, size_t num_frames, int channels) {
+  if (channels == 2) {
+    const int32_t *left = src[0];
+    const int32_t *right = src[1];
+    for (size_t f = 0; f < num_frames; f++) {
+      dst[2 * f] = left[f];
+      dst[2 * f + 1] = right[f];
+    }
+    return;
+  }
+  for (int ch = 0; ch < channels; ch++) {
+    const int32_t *in = src[ch];
+    for (size_t f = 0; f < num_frames; f++) {
+      dst[f * channels + ch] = in[f];
+    }
+  }
+}
+
+static void biquad_stereo(int32_t *samples, size_t num_frames, const int32_t *c, int32_t *state, int shift) {
+  const int64_t b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+  int32_t lx1 = state[0], lx2 = state[1], ly1 = state[2], ly2 = state[3];
+  int32_t rx1 = state[4], rx2 = state[5], ry1 = state[6], ry2 = state[7];
+  for (size_t f = 0; f < num_frames; f++) {
+    const int32_t lx = samples[2 * f];
+    const int32_t rx = samples[2 * f + 1];
+    const int32_t ly = audio_sat_s32((b0 * lx + b1 * lx1 + b2 * lx2 - a1 * ly1 - a2 * ly2) >> shift);
+    const int32_t ry = audio_sat_s32((b0 * rx + b1 * rx1 + b2 * rx2 - a1 * ry1 - a2 * ry2) >> shift);
+    lx2 = lx1;
+    lx1 = lx;
+    ly2 = ly1;
+    ly1 = ly;
+    rx2 = rx1;
+    rx1 = rx;
+    ry2 = ry1;
+    ry1 = ry;
+    samples[2 * f] = ly;
+    samples[2 * f + 1] = ry;
+  }
+  state[0] = lx1;
+  state[1] = lx2;
+  state[2] = ly1;
+  state[3] = ly2;
+  state[4] = rx1;
+  state[5] = rx2;
+  state[6] = ry1;
+  state[7] = ry2;
+}
+
+static void biquad_strided(int32_t *samples, size_t num_frames, int stride, const int32_t *c, int32_t *state,
+                           int shift) {
+  const int64_t b0 = c[0], b1 = c[1], b2 = c[2], a1 = c[3], a2 = c[4];
+  int32_t x1 = state[0], x2 = state[1], y1 = state[2], y2 = state[3];
+  for (size_t f = 0; f < num_frames; f++) {
+    const int32_t x = samples[f * stride];
+    const int32_t y = audio_sat_s32((b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2) >> shift);
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    samples[f * stride] = y;
+  }
+  state[0] = x1;
+  state[1] = x2;
+  state[2] = y1;
+  state[3] = y2;
+}
+
+void audio_biquad_cascade_s32(int32_t *samples, size_t num_frames, int channels, const int32_t *coeffs,
+                              int32_t *state, size_t num_bands, int coef_shift) {
+  // band by band over the whole block keeps the coefficients and the lanes' state in registers
+  for (size_t band = 0; band < num_bands; band++) {
+    const int32_t *c = coeffs + band * 5;
+    int32_t *band_state = state + band * channels * 4;
+    if (channels == 2) {
+      biquad_stereo(samples, num_frames, c, band_state, coef_shift);
+      continue;
+    }
+    for (int ch = 0; ch < channels; ch++) {
+      biquad_strided(samples + ch, num_frames, channels, c, band_state + ch * 4, coef_shift);
+    }
+  }
+}
+
+// full period of a sine in Q15, one extra entry for interpolating the last segment
+#define SINE_TABLE_BITS 8
+#define SINE_TABLE_SIZE (1 << SINE_TABLE_BITS)
+static int16_t sine_table[SINE_TABLE_SIZE + 1];
+static bool sine_table_ready = false;
+
+static void init_sine_table(void) {
+  // concurrent first calls write the same values, so this needs no lock
+  for (int i = 0; i <= SINE_TABLE_SIZE; i++) {
+    sine_table[i] = (int16_t) lroundf(32767.f * sinf(6.2831853f * (float) i / (float) SINE_TABLE_SIZE));
+  }
+  sine_table_ready = true;
+}
+
+// linear interpolation between two table entries
+static inline int32_t sine_q15(uint32_t phase) {
+  const uint32_t idx = phase >> (32 - SINE_TABLE_BITS);
+  const int32_t frac = (phase >> (16 - SINE_TABLE_BITS)) & 0xFFFF;
+  const int32_t a = sine_table[idx];
+  const int32_t b = sine_table[idx + 1];
+  return a + (((b - a) * frac) >> 16);
+}
+
+size_t audio_tone_render_s16(int16_t *dst, size_t num_samples, audio_tone_t *tone) {
+  if (!sine_table_ready) {
+    init_sine_table();
+  }
+  const size_t n = num_samples < tone->remaining ? num_samples : tone->remaining;
+  uint32_t phase = tone->phase;
+  uint32_t phase_inc = tone->phase_inc;
+  int32_t envelope = tone->envelope;
+  uint32_t remaining = tone->remaining;
+  for (size_t i = 0; i < n; i++) {
+    const uint32_t elapsed = tone->length - remaining;
+    if (elapsed < tone->attack_samples) {
+      envelope += tone->attack_delta;
+      envelope = envelope < tone->target ? envelope : tone->target;
+    } else if (remaining <= tone->release_samples) {
+      envelope -= tone->release_delta;
+      envelope = envelope > 0 ? envelope : 0;
+    }
+    dst[i] = (int16_t) ((sine_q15(phase) * (envelope >> 15)) >> 15);
+    phase += phase_inc;
+    phase_inc += tone->phase_inc_delta;
+    remaining--;
+  }
+  tone->phase = phase;
+  tone->phase_inc = phase_inc;
+  tone->envelope = envelope;
+  tone->remaining = remaining;
+  return n;
+}
+
+void audio_silence(void *buffer, size_t len, bool builtin_dac) { memset(buffer, builtin_dac ? 0x80 : 0x00, len); }
@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+Per-sample loops on interleaved PCM, shared by the I2S drivers and the ADF-Pipeline elements.
+Plain C, so the ADF stream elements can use them as well. Samples are signed 16 bit or 32 bit,
+24 bit samples are left aligned in 32 bit containers. Unless noted otherwise, the kernels work
+in place and src and dst may be the same buffer.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline int16_t audio_sat_s16(int64_t value) {
+  return (int16_t) (value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+}
+
+static inline int32_t audio_sat_s32(int64_t value) {
+  return (int32_t) (value > INT32_MAX ? INT32_MAX : value < INT32_MIN ? INT32_MIN : value);
+}
+
+// dst = saturate(src >> shift), shift 16 keeps the upper half, smaller shifts apply a gain
+void audio_s32_to_s16(const int32_t *src, int16_t *dst, size_t num_samples, int shift);
+// dst = src << 16, also in place, where dst grows over src
+void audio_s16_to_s32(const int16_t *src, int32_t *dst, size_t num_samples);
+
+// samples = saturate(samples * gain >> shift)
+void audio_scale_s16(int16_t *samples, size_t num_samples, int32_t gain, int shift);
+void audio_scale_s32(int32_t *samples, size_t num_samples, int32_t gain, int shift);
+
+// samples = saturate(samples * gain >> shift) with the gain stepping by step per frame, for at most
+// *remaining frames, the last frame of the ramp gets target exactly, returns the processed frames
+size_t audio_gain_ramp_s16(int16_t *samples, size_t num_frames, int channels, int32_t *gain, int32_t step,
+                           uint32_t *remaining, int32_t target, int shift);
+size_t audio_gain_ramp_s32(int32_t *samples, size_t num_frames, int channels, int32_t *gain, int32_t step,
+                           uint32_t *remaining, int32_t target, int shift);
+
+// dst = saturate((a * gain_a + b * gain_b) >> shift), with the gains ramping linearly per frame
+// from *_from towards *_to, b is optional (NULL), dst may alias a
+void audio_mix_ramp_s16(int16_t *dst, const int16_t *a, int32_t a_from, int32_t a_to, const int16_t *b,
+                        int32_t b_from, int32_t b_to, size_t num_frames, int channels, int shift);
+void audio_mix_ramp_s32(int32_t *dst, const int32_t *a, int32_t a_from, int32_t a_to, const int32_t *b,
+                        int32_t b_from, int32_t b_to, size_t num_frames, int channels, int shift);
+
+// returns the sum of squares of the samples and raises *peak to their largest magnitude, scaled to
+// 32 bit full scale, 32 bit samples are reduced to 16 bit precision for the squares
+uint64_t audio_level_s16(const int16_t *samples, size_t num_samples, uint32_t *peak);
+uint64_t audio_level_s32(const int32_t *samples, size_t num_samples, uint32_t *peak);
+
+// swaps the samples of every pair, the order of the ESP32's I2S FIFO in mono mode
+void audio_swap_pairs_s16(int16_t *samples, size_t num_samples);
+void audio_swap_pairs_s32(int32_t *samples, size_t num_samples);
+
+// signed samples to the unsigned 8 bit value in the upper byte, as sent to the built-in DAC
+void audio_dac_scale_s16(int16_t *samples, size_t num_samples);
+void audio_dac_scale_s32(int32_t *samples, size_t num_samples);
+
+// interleaved frames to planar buffers and back, the planar side holds channels pointers to
+// num_frames samples each, the interleaved buffer must not overlap them
+void audio_deinterleave_s16(int16_t *const *dst, const int16_t *src, size_t num_frames, int channels);
+void audio_deinterleave_s32(int32_t *const *dst, const int32_t *src, size_t num_frames, int channels);
+void audio_interleave_s16(int16_t *dst, const int16_t *const *src, size_t num_frames, int channels);
+void audio_interleave_s32(int32_t *dst, const int32_t *const *src, size_t num_frames, int channels);
+
+// cascade of direct form I biquads on interleaved frames, in place
+// coeffs holds b0, b1, b2, a1, a2 per band with coef_shift fractional bits (a0 normalized to 1),
+// state holds x1, x2, y1, y2 per band and channel, band major: state[(band * channels + ch) * 4]
+// the channels are independent lanes, stereo is filtered with both lanes in registers
+void audio_biquad_cascade_s32(int32_t *samples, size_t num_frames, int channels, const int32_t *coeffs,
+                              int32_t *state, size_t num_bands, int coef_shift);
+
+// state of a sine sweep with a linear attack and release, the synthesis of the tone generator
+// phase covers one period with 32 bits and phase_inc changes by phase_inc_delta per sample,
+// the envelope is Q30 (amplitude Q15 times ramp Q15), it rises by attack_delta up to target during
+// the first attack_samples of the step's length and falls by release_delta in the last release_samples
+typedef struct {
+  uint32_t phase;
+  uint32_t phase_inc;
+  int32_t phase_inc_delta;
+  int32_t envelope;
+  int32_t target;
+  int32_t attack_delta;
+  int32_t release_delta;
+  uint32_t length;
+  uint32_t remaining;
+  uint32_t attack_samples;
+  uint32_t release_samples;
+} audio_tone_t;
+
+// renders up to num_samples mono Q15 samples, but not beyond the end of the step, returns their number
+size_t audio_tone_render_s16(int16_t *dst, size_t num_samples, audio_tone_t *tone);
+
+// fills len bytes with silence, the built-in DAC's silence is its mid level
+void audio_silence(void *buffer, size_t len, bool builtin_dac);
+
+#ifdef __cplusplus
+}
+
+// overloads for code templated on the sample type
+template<typename T> static inline T audio_sat(int64_t value);
+template<> inline int16_t audio_sat<int16_t>(int64_t value) { return audio_sat_s16(value); }
+template<> inline int32_t audio_sat<int32_t>(int64_t value) { return audio_sat_s32(value); }
+
+static inline void audio_scale(int16_t *samples, size_t num_samples, int32_t gain, int shift) {
+  audio_scale_s16(samples, num_samples, gain, shift);
+}
+static inline void audio_scale(int32_t *samples, size_t num_samples, int32_t gain, int shift) {
+  audio_scale_s32(samples, num_samples, gain, shift);
+}
+
+static inline void audio_mix_ramp(int16_t *dst, const int16_t *a, int32_t a_from, int32_t a_to, const int16_t *b,
+                                  int32_t b_from, int32_t b_to, size_t num_frames, int channels, int shift) {
+  audio_mix_ramp_s16(dst, a, a_from, a_to, b, b_from, b_to, num_frames, channels, shift);
+}
+static inline void audio_mix_ramp(int32_t *dst, const int32_t *a, int32_t a_from, int32_t a_to, const int32_t *b,
+                                  int32_t b_from, int32_t b_to, size_t num_frames, int channels, int shift) {
+  audio_mix_ramp_s32(dst, a, a_from, a_to, b, b_from, b_to, num_frames, channels, shift);
+}
+#endif
@@ -23,6 +23,7 @@ from esphome.components.esp32.const import (
 from . import i2s_settings as i2s
 
 CODEOWNERS = ["@jesserockz", "@gnumpi"]
+AUTO_LOAD = ["audio_kernels"]
 DEPENDENCIES = ["esp32"]
 MULTI_CONF = True
 
@@ -35,6 +36,7 @@ CONF_I2S_LRCLK_PIN = "i2s_lrclk_pin"
 CONF_I2S_AUDIO = "i2s_audio"
 CONF_I2S_AUDIO_ID = "i2s_audio_id"
 CONF_I2S_ACCESS_MODE = "access_mode"
+CONF_IDLE_TIMEOUT = "idle_timeout"
 
 CONF_SAMPLE_RATE = "sample_rate"
 CONF_BITS_PER_SAMPLE = "bits_per_sample"
@@ -66,12 +68,58 @@ CONFIG_SCHEMA = cv.Schema(
         cv.Optional(CONF_I2S_BCLK_PIN): pins.internal_gpio_output_pin_number,
         cv.Optional(CONF_I2S_MCLK_PIN): pins.internal_gpio_output_pin_number,
         cv.Optional(CONF_I2S_ACCESS_MODE, default="exclusive"): cv.enum(ACCESS_MODES),
+        cv.Optional(
+            CONF_IDLE_TIMEOUT, default="0s"
+        ): cv.positive_time_period_milliseconds,
     }
 )
 
 
+def _find_i2s_devices(config, port_id):
+    """Readers and writers attached to the port, wherever they are configured."""
+    if isinstance(config, list):
+        for item in config:
+            yield from _find_i2s_devices(item, port_id)
+    elif isinstance(config, dict):
+        device_id = config.get(CONF_I2S_AUDIO_ID)
+        if (
+            device_id is not None
+            and device_id.id == port_id.id
+            and (CONF_I2S_DIN_PIN in config or CONF_I2S_DOUT_PIN in config)
+        ):
+            yield config
+            return
+        for value in config.values():
+            yield from _find_i2s_devices(value, port_id)
+
+
+def _bus_format(config):
+    return {
+        i2s.CONF_SAMPLE_RATE: config.get(i2s.CONF_SAMPLE_RATE),
+        i2s.CONF_BITS_PER_SAMPLE: config.get(i2s.CONF_BITS_PER_SAMPLE),
+        i2s.CONF_CHANNEL: config.get(i2s.CONF_CHANNEL),
+        i2s.CONF_TDM_CHANNELS: config.get(i2s.CONF_TDM_CHANNELS),
+        i2s.CONF_TDM: config.get(i2s.CONF_TDM),
+    }
+
+
+def _validate_duplex_formats(full_config, port_config):
+    # both directions of a duplex port share the driver and with it the format on the bus
+    devices = list(_find_i2s_devices(full_config, port_config[CONF_ID]))
+    if len(devices) < 2:
+        return
+    first, second = _bus_format(devices[0]), _bus_format(devices[1])
+    for key, value in first.items():
+        if value != second[key]:
+            raise cv.Invalid(
+                f"The I2S reader and writer of the duplex port {port_config[CONF_ID]} "
+                f"must use the same {key}, use the exclusive access mode for different formats"
+            )
+
+
 def _final_validate(_):
-    i2s_audio_configs = fv.full_config.get()[CONF_I2S_AUDIO]
+    full_config = fv.full_config.get()
+    i2s_audio_configs = full_config[CONF_I2S_AUDIO]
     variant = get_esp32_variant()
     if variant not in I2S_PORTS:
         raise cv.Invalid(f"Unsupported variant {variant}")
@@ -79,6 +127,9 @@ def _final_validate(_):
         raise cv.Invalid(
             f"Only {I2S_PORTS[variant]} I2S audio ports are supported on {variant}"
         )
+    for port_config in i2s_audio_configs:
+        if port_config[CONF_I2S_ACCESS_MODE] == "duplex":
+            _validate_duplex_formats(full_config, port_config)
 
 
 FINAL_VALIDATE_SCHEMA = _final_validate
@@ -88,6 +139,7 @@ async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     cg.add(var.set_access_mode(config[CONF_I2S_ACCESS_MODE]))
+    cg.add(var.set_idle_timeout(config[CONF_IDLE_TIMEOUT].total_milliseconds))
     cg.add(var.set_lrclk_pin(config[CONF_I2S_LRCLK_PIN]))
     if CONF_I2S_BCLK_PIN in config:
         cg.add(var.set_bclk_pin(config[CONF_I2S_BCLK_PIN]))
@@ -135,13 +187,72 @@ CONFIG_SCHEMA_DAC = cv.typed_schema(
     default_type="generic",
 )
 
+
+def _validate_tdm_variant(value):
+    if get_esp32_variant() not in [VARIANT_ESP32S3, VARIANT_ESP32C3]:
+        raise cv.Invalid("TDM is only supported on ESP32-S3 and ESP32-C3")
+    return value
+
+
+def _validate_tdm_channels(value):
+    _validate_tdm_variant(value)
+    return cv.int_range(min=2, max=16)(value)
+
+
+def _validate_tdm_slots(config):
+    slots = config[i2s.CONF_SLOTS]
+    active = config.get(i2s.CONF_ACTIVE_SLOTS, list(range(slots)))
+    if len(set(active)) != len(active):
+        raise cv.Invalid("Active slots must be unique", path=[i2s.CONF_ACTIVE_SLOTS])
+    if max(active) >= slots:
+        raise cv.Invalid(
+            f"Slot {max(active)} is not on the bus with {slots} slots",
+            path=[i2s.CONF_ACTIVE_SLOTS],
+        )
+    return {**config, i2s.CONF_ACTIVE_SLOTS: active}
+
+
+CONFIG_SCHEMA_TDM = cv.All(
+    _validate_tdm_variant,
+    cv.Schema(
+        {
+            cv.Required(i2s.CONF_SLOTS): cv.int_range(min=2, max=16),
+            cv.Optional(i2s.CONF_ACTIVE_SLOTS): cv.All(
+                cv.ensure_list(cv.int_range(min=0, max=15)), cv.Length(min=1)
+            ),
+            cv.Optional(i2s.CONF_SLOT_BIT_WIDTH): cv.All(
+                cv.float_with_unit("bits", "bit"), cv.one_of(16, 24, 32)
+            ),
+        }
+    ),
+    _validate_tdm_slots,
+)
+
+CONFIG_SCHEMA_I2S_TDM = cv.Schema(
+    {
+        cv.Exclusive(i2s.CONF_TDM_CHANNELS, "tdm"): _validate_tdm_channels,
+        cv.Exclusive(i2s.CONF_TDM, "tdm"): CONFIG_SCHEMA_TDM,
+    }
+)
+
+
+def validate_tdm_slot_width(config):
+    slot_bits = config.get(i2s.CONF_TDM, {}).get(i2s.CONF_SLOT_BIT_WIDTH)
+    if slot_bits is not None and slot_bits < config[i2s.CONF_BITS_PER_SAMPLE]:
+        raise cv.Invalid(
+            f"Slots of {slot_bits} bits can't hold {config[i2s.CONF_BITS_PER_SAMPLE]} bit samples",
+            path=[i2s.CONF_TDM, i2s.CONF_SLOT_BIT_WIDTH],
+        )
+    return config
+
+
 CONFIG_SCHEMA_I2S_WRITER = i2s.CONFIG_SCHEMA_I2S_COMMON.extend(
     {
         cv.GenerateID(CONF_I2S_AUDIO_ID): cv.use_id(I2SAudioComponent),
         cv.Required(CONF_I2S_DOUT_PIN): pins.internal_gpio_output_pin_number,
         cv.Optional(CONF_I2S_DAC, default={CONF_MODEL: "generic"}): CONFIG_SCHEMA_DAC,
     }
-).extend(cv.COMPONENT_SCHEMA)
+).extend(CONFIG_SCHEMA_I2S_TDM).extend(cv.COMPONENT_SCHEMA)
 
 
 CONFIG_SCHEMA_ADC = cv.typed_schema(
@@ -165,7 +276,7 @@ CONFIG_SCHEMA_I2S_READER = i2s.CONFIG_SCHEMA_I2S_COMMON.extend(
         cv.Required(CONF_PDM): cv.boolean,
         cv.Optional(CONF_I2S_ADC, default={CONF_MODEL: "generic"}): CONFIG_SCHEMA_ADC,
     }
-)
+).extend(CONFIG_SCHEMA_I2S_TDM)
 
 
 def final_validate_device_schema(name: str) -> cv.Schema:
@@ -208,6 +319,21 @@ async def apply_i2s_settings(var, config) -> None:
     cg.add(var.set_bits_per_sample(config[i2s.CONF_BITS_PER_SAMPLE]))
     cg.add(var.set_use_apll(config[i2s.CONF_USE_APLL]))
     cg.add(var.set_fixed_settings(config[i2s.CONF_FIXED_SETTINGS]))
+    if i2s.CONF_DMA_BUF_COUNT in config:
+        cg.add(var.set_dma_buf_count(config[i2s.CONF_DMA_BUF_COUNT]))
+    if i2s.CONF_DMA_BUF_LEN in config:
+        cg.add(var.set_dma_buf_len(config[i2s.CONF_DMA_BUF_LEN]))
+    if i2s.CONF_LOW_LATENCY in config:
+        cg.add(var.set_low_latency(config[i2s.CONF_LOW_LATENCY].total_milliseconds))
+    if i2s.CONF_TDM_CHANNELS in config:
+        slots = config[i2s.CONF_TDM_CHANNELS]
+        cg.add(var.set_tdm((1 << slots) - 1, slots))
+    if i2s.CONF_TDM in config:
+        tdm = config[i2s.CONF_TDM]
+        slot_mask = sum(1 << slot for slot in tdm[i2s.CONF_ACTIVE_SLOTS])
+        cg.add(var.set_tdm(slot_mask, tdm[i2s.CONF_SLOTS]))
+        if i2s.CONF_SLOT_BIT_WIDTH in tdm:
+            cg.add(var.set_slot_bit_width(int(tdm[i2s.CONF_SLOT_BIT_WIDTH])))
 
 
 async def register_i2s_writer(writer, config: dict) -> None:
@@ -1,5 +1,7 @@
 """ADF-Pipeline platform implementation of I2S controller (TX and RX)."""
 
+import logging
+
 import esphome.codegen as cg
 import esphome.config_validation as cv
 
@@ -15,11 +17,14 @@ from .. import (
     I2S_AUDIO_OUT,
     CONFIG_SCHEMA_I2S_READER,
     CONFIG_SCHEMA_I2S_WRITER,
+    validate_tdm_slot_width,
     #    final_validate_device_schema,
     register_i2s_reader,
     register_i2s_writer,
 )
 
+_LOGGER = logging.getLogger(__name__)
+
 CODEOWNERS = ["@gnumpi"]
 AUTO_LOAD = ["adf_pipeline"]
 DEPENDENCIES = ["adf_pipeline", "i2s_audio"]
@@ -43,6 +48,28 @@ ADFElementI2SIn = i2s_audio_ns.class_(
 
 CONF_USE_ADF_ALC = "adf_alc"
 
+
+def deprecated_adf_alc(value):
+    """The ADF ALC was replaced by the volume element, kept so existing configs still validate.
+
+    Media player pipelines without a volume element get one in front of this sink, unless the
+    option is false, which used to disable the software volume.
+    """
+    value = cv.boolean(value)
+    if value:
+        _LOGGER.warning(
+            "'%s' is deprecated, the volume is applied by a 'volume' element. "
+            "Media player pipelines without one get it added in front of this output.",
+            CONF_USE_ADF_ALC,
+        )
+    else:
+        _LOGGER.warning(
+            "'%s' is deprecated and has no effect on the output, remove it.",
+            CONF_USE_ADF_ALC,
+        )
+    return value
+
+
 CONFIG_SCHEMA_IN = CONFIG_SCHEMA_I2S_READER.extend(
     {
         cv.GenerateID(): cv.declare_id(ADFElementI2SIn),
@@ -52,14 +79,14 @@ CONFIG_SCHEMA_IN = CONFIG_SCHEMA_I2S_READER.extend(
 CONFIG_SCHEMA_OUT = CONFIG_SCHEMA_I2S_WRITER.extend(
     {
         cv.GenerateID(): cv.declare_id(ADFElementI2SOut),
-        cv.Optional(CONF_USE_ADF_ALC, default=True): cv.boolean,
+        cv.Optional(CONF_USE_ADF_ALC): deprecated_adf_alc,
     }
 )
 
 CONFIG_SCHEMA = cv.typed_schema(
     {
-        I2S_AUDIO_IN: CONFIG_SCHEMA_IN,
-        I2S_AUDIO_OUT: CONFIG_SCHEMA_OUT,
+        I2S_AUDIO_IN: cv.All(CONFIG_SCHEMA_IN, validate_tdm_slot_width),
+        I2S_AUDIO_OUT: cv.All(CONFIG_SCHEMA_OUT, validate_tdm_slot_width),
     },
     lower=True,
     space="-",
@@ -77,4 +104,3 @@ async def to_code(config):
 
     elif config["type"] == I2S_AUDIO_OUT:
         await register_i2s_writer(var, config)
-        cg.add(var.set_use_adf_alc(config[CONF_USE_ADF_ALC]))
@@ -49,6 +49,12 @@ bool ADFElementI2SIn::init_adf_elements_() {
   this->adf_i2s_stream_reader_ = i2s_stream_init(&i2s_stream_cfg);
   this->adf_i2s_stream_reader_->buf_size = 2 * 256;
 
+  if (this->echo_reference_ != nullptr) {
+    this->bytes_per_frame_ = (this->bits_per_sample_ > 16 ? 4 : 2) * this->num_of_channels();
+    this->echo_reference_->reset_capture();
+    i2s_stream_set_tap(this->adf_i2s_stream_reader_, ADFElementI2SIn::capture_tap_, this);
+  }
+
   this->install_i2s_driver(i2s_config);
 
 #ifdef I2S_EXTERNAL_ADC
@@ -65,6 +71,11 @@ bool ADFElementI2SIn::init_adf_elements_() {
   return true;
 };
 
+void ADFElementI2SIn::capture_tap_(audio_element_handle_t self, const char *buffer, int len, void *ctx) {
+  ADFElementI2SIn *this_ = (ADFElementI2SIn *) ctx;
+  this_->echo_reference_->on_capture(len / this_->bytes_per_frame_);
+}
+
 bool ADFElementI2SIn::is_ready(){
   if( !this->claim_i2s_access() )
   {
@@ -74,7 +85,7 @@ bool ADFElementI2SIn::is_ready(){
     AudioPipelineSettingsRequest request{this};
     request.sampling_rate = this->sample_rate_;
     request.bit_depth = this->bits_per_sample_;
-    request.number_of_channels = 2;
+    request.number_of_channels = this->is_tdm() ? this->num_of_channels() : 2;
     this->valid_settings_ = pipeline_->request_settings(request);
   }
   return this->valid_settings_;
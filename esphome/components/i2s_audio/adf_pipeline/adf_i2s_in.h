@@ -7,6 +7,7 @@
 #include "esphome/core/component.h"
 
 #include "../../adf_pipeline/adf_audio_sources.h"
+#include "../../adf_pipeline/adf_aec.h"
 
 namespace esphome {
 using namespace esp_adf;
@@ -22,12 +23,19 @@ class ADFElementI2SIn : public I2SReader, public ADFPipelineSourceElement, publi
   void dump_config() override { this->dump_i2s_settings(); }
   bool is_ready() override;
 
+  // reports the captured frames to the echo canceller
+  void set_echo_reference(EchoReference *echo_reference) { this->echo_reference_ = echo_reference; }
+
   protected:
 
   bool valid_settings_{false};
   bool init_adf_elements_() override;
   void clear_adf_elements_() override;
   audio_element_handle_t adf_i2s_stream_reader_;
+
+  static void capture_tap_(audio_element_handle_t self, const char *buffer, int len, void *ctx);
+  EchoReference *echo_reference_{nullptr};
+  int bytes_per_frame_{4};
 };
 
 }  // namespace i2s_audio
@@ -33,12 +33,13 @@ bool ADFElementI2SOut::init_adf_elements_() {
 #endif
 
   i2s_driver_config_t i2s_config = this->get_i2s_cfg();
+  this->stream_bits_ = this->bits_per_sample_;
 
   i2s_stream_cfg_t i2s_cfg = {
       .type = AUDIO_STREAM_WRITER,
       .i2s_config = i2s_config,
       .i2s_port = this->parent_->get_port(),
-      .use_alc = this->use_adf_alc_,
+      .use_alc = false,
       .volume = 0,
       .out_rb_size = (4 * 1024),
       .task_stack = I2S_STREAM_TASK_STACK,
@@ -54,6 +55,11 @@ bool ADFElementI2SOut::init_adf_elements_() {
   this->adf_i2s_stream_writer_ = i2s_stream_init(&i2s_cfg);
   this->adf_i2s_stream_writer_->buf_size = 1 * 1024;
 
+  this->dma_frames_ = i2s_config.dma_buf_count * i2s_config.dma_buf_len;
+  if (this->echo_reference_ != nullptr) {
+    i2s_stream_set_tap(this->adf_i2s_stream_writer_, ADFElementI2SOut::playback_tap_, this);
+  }
+
   this->install_i2s_driver(i2s_config);
 
 #ifdef I2S_EXTERNAL_DAC
@@ -74,6 +80,41 @@ void ADFElementI2SOut::clear_adf_elements_(){
   this->uninstall_i2s_driver();
 }
 
+void ADFElementI2SOut::playback_tap_(audio_element_handle_t self, const char *buffer, int len, void *ctx) {
+  ADFElementI2SOut *this_ = (ADFElementI2SOut *) ctx;
+  const pcm_format format{(int) this_->sample_rate_, (int) this_->stream_bits_, this_->num_of_channels()};
+  this_->echo_reference_->on_playback((const uint8_t *) buffer, len, format, this_->dma_frames_);
+}
+
+uint32_t ADFElementI2SOut::get_output_latency_us() {
+  if (this->sdk_audio_elements_.empty() || this->sample_rate_ == 0) {
+    return 0;
+  }
+  uint32_t frames = this->dma_frames_;
+  ringbuf_handle_t rb = audio_element_get_input_ringbuf(this->adf_i2s_stream_writer_);
+  if (rb != nullptr) {
+    const int bytes_per_frame = (this->stream_bits_ > 16 ? 4 : 2) * this->num_of_channels();
+    frames += rb_bytes_filled(rb) / bytes_per_frame;
+  }
+  return (uint64_t) frames * 1000000 / this->sample_rate_;
+}
+
+uint32_t ADFElementI2SOut::get_underruns() const {
+  i2s_underrun_stats_t stats{};
+  if (this->sdk_audio_elements_.empty() || i2s_stream_get_stats(this->adf_i2s_stream_writer_, &stats) != ESP_OK) {
+    return 0;
+  }
+  return stats.underruns;
+}
+
+uint32_t ADFElementI2SOut::get_late_writes() const {
+  i2s_underrun_stats_t stats{};
+  if (this->sdk_audio_elements_.empty() || i2s_stream_get_stats(this->adf_i2s_stream_writer_, &stats) != ESP_OK) {
+    return 0;
+  }
+  return stats.late_writes;
+}
+
 bool ADFElementI2SOut::is_ready(){
   return this->claim_i2s_access();
 }
@@ -90,20 +131,24 @@ void ADFElementI2SOut::on_settings_request(AudioPipelineSettingsRequest &request
       rate_bits_channels_updated = true;
     }
 
-    if(request.number_of_channels > 0 && (uint8_t) request.number_of_channels != this->num_of_channels())
-    {
+    // TDM slots are fixed, the pipeline maps its channels onto them
+    if (!this->is_tdm() && request.number_of_channels > 0 &&
+        (uint8_t) request.number_of_channels != this->num_of_channels()) {
       this->channel_fmt_ = request.number_of_channels == 1 ? I2S_CHANNEL_FMT_ONLY_RIGHT : I2S_CHANNEL_FMT_RIGHT_LEFT;
       rate_bits_channels_updated = true;
     }
 
-    if (request.bit_depth > 0 && (uint8_t) request.bit_depth != this->bits_per_sample_) {
-      bool supported = request.bit_depth == 16;
+    if (request.bit_depth > 0 && (uint8_t) request.bit_depth != this->stream_bits_) {
+      bool supported = request.bit_depth == 16 || request.bit_depth == 24 || request.bit_depth == 32;
       if (!supported) {
         request.failed = true;
         request.failed_by = this;
         return;
       }
-      this->bits_per_sample_ = (i2s_bits_per_sample_t) request.bit_depth;
+      // 24 bit samples come in 32 bit containers and are sent MSB first in 32 bit slots,
+      // which carries them unchanged to 24 bit DACs
+      this->stream_bits_ = request.bit_depth;
+      this->bits_per_sample_ = request.bit_depth == 16 ? I2S_BITS_PER_SAMPLE_16BIT : I2S_BITS_PER_SAMPLE_32BIT;
       rate_bits_channels_updated = true;
     }
 
@@ -112,6 +157,7 @@ void ADFElementI2SOut::on_settings_request(AudioPipelineSettingsRequest &request
       audio_element_set_music_info(this->adf_i2s_stream_writer_,this->sample_rate_, this->num_of_channels(), this->bits_per_sample_ );
 
       esph_log_d(TAG, "update i2s clk settings: rate:%d bits:%d ch:%d",this->sample_rate_, this->bits_per_sample_, this->num_of_channels());
+      esph_log_d(TAG, "DMA latency: %.1f ms", this->dma_frames_ * 1000.f / this->sample_rate_);
       if (i2s_stream_set_clk(this->adf_i2s_stream_writer_, this->sample_rate_, this->bits_per_sample_,
                             this->num_of_channels()) != ESP_OK) {
         esph_log_e(TAG, "error while setting sample rate and bit depth,");
@@ -119,6 +165,18 @@ void ADFElementI2SOut::on_settings_request(AudioPipelineSettingsRequest &request
         request.failed_by = this;
         return;
       }
+      this->i2s_clk_changed();
+    }
+  } else if (request.bit_depth > 0) {
+    const uint8_t stream_bits = this->stream_bits_for_fixed_bus_(request.bit_depth);
+    if (stream_bits != this->stream_bits_) {
+      esph_log_d(TAG, "stream bits: %d, bus bits: %d", stream_bits, this->bits_per_sample_);
+      if (i2s_stream_set_expand(this->adf_i2s_stream_writer_, stream_bits) != ESP_OK) {
+        request.failed = true;
+        request.failed_by = this;
+        return;
+      }
+      this->stream_bits_ = stream_bits;
     }
   }
 
@@ -126,11 +184,11 @@ void ADFElementI2SOut::on_settings_request(AudioPipelineSettingsRequest &request
   if (request.final_sampling_rate == -1) {
     esph_log_d(TAG, "Set final i2s settings: %d", this->sample_rate_);
     request.final_sampling_rate = this->sample_rate_;
-    request.final_bit_depth = this->bits_per_sample_;
+    request.final_bit_depth = this->stream_bits_;
     request.final_number_of_channels = this->num_of_channels();
   } else if (
        request.final_sampling_rate != this->sample_rate_
-    || request.final_bit_depth != this->bits_per_sample_
+    || request.final_bit_depth != this->stream_bits_
     || request.final_number_of_channels != this->num_of_channels()
   )
   {
@@ -138,22 +196,32 @@ void ADFElementI2SOut::on_settings_request(AudioPipelineSettingsRequest &request
     request.failed_by = this;
   }
 
-  if (this->use_adf_alc_ && request.target_volume > -1) {
-    int target_volume = (int) (request.target_volume * 64.) - 32;
-    if (i2s_alc_volume_set(this->adf_i2s_stream_writer_, target_volume) != ESP_OK) {
-      esph_log_e(TAG, "error setting volume to %d", target_volume);
-      request.failed = true;
-      request.failed_by = this;
-      return;
-    }
-  }
 #ifdef I2S_EXTERNAL_DAC
-  if( this->external_dac_ != nullptr && request.target_volume > -1){
-    this->external_dac_->set_volume( request.target_volume);
+  if (this->external_dac_ != nullptr && this->external_dac_->supports_volume()) {
+    if (request.target_volume > -1 || request.mute > -1) {
+      this->volume_ = request.target_volume > -1 ? request.target_volume : this->volume_;
+      this->muted_ = request.mute > -1 ? request.mute == 1 : this->muted_;
+      const bool silent = this->muted_ || this->volume_ <= 0.f;
+      this->external_dac_->set_mute_audio(silent);
+      if (!silent) {
+        this->external_dac_->set_attenuation((uint8_t) (-2.f * volume_to_db(this->volume_)));
+      }
+    }
+    // volume is handled by the DAC, software gain stages can stay at unity
+    request.final_volume = this->muted_ ? 0.f : this->volume_;
   }
 #endif
 }
 
+uint8_t ADFElementI2SOut::stream_bits_for_fixed_bus_(int bit_depth) const {
+  // expanding while copying to DMA is cheaper than a conversion element, which moves twice the bytes
+  // through an additional ring buffer
+  if (bit_depth == 16 && this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_32BIT) {
+    return 16;
+  }
+  return this->bits_per_sample_;
+}
+
 }  // namespace i2s_audio
 }  // namespace esphome
 #endif
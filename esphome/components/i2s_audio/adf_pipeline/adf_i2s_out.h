@@ -7,6 +7,7 @@
 #include "esphome/core/component.h"
 
 #include "../../adf_pipeline/adf_audio_sinks.h"
+#include "../../adf_pipeline/adf_aec.h"
 
 namespace esphome {
 using namespace esp_adf;
@@ -22,17 +23,33 @@ class ADFElementI2SOut : public I2SWriter, public ADFPipelineSinkElement, public
   void dump_config() override { this->dump_i2s_settings(); }
   bool is_ready() override;
 
-  void set_use_adf_alc(bool use_alc){ this->use_adf_alc_ = use_alc; }
+  // time until a sample written to the pipeline's sink is played: queued in the ring buffer plus DMA depth
+  uint32_t get_output_latency_us();
+  // times the input ran dry and silence was inserted, and writes after the DMA buffers had played out
+  uint32_t get_underruns() const;
+  uint32_t get_late_writes() const;
 
+  // passes every block written to the driver to the echo canceller
+  void set_echo_reference(EchoReference *echo_reference) { this->echo_reference_ = echo_reference; }
 
  protected:
   void on_settings_request(AudioPipelineSettingsRequest &request) override;
-  bool use_adf_alc_{false};
+  // bit depth accepted from the pipeline for the requested one, with the bus width fixed
+  uint8_t stream_bits_for_fixed_bus_(int bit_depth) const;
   bool adjustable_{false};
+  float volume_{1.f};
+  bool muted_{false};
 
   bool init_adf_elements_() override;
   void clear_adf_elements_() override;
   audio_element_handle_t adf_i2s_stream_writer_;
+  // bit depth of the samples in the stream, 24 bit samples are left aligned in 32 bit containers.
+  // 16 bit streams on a 32 bit bus are expanded by the driver while copying to DMA.
+  uint8_t stream_bits_{16};
+
+  static void playback_tap_(audio_element_handle_t self, const char *buffer, int len, void *ctx);
+  EchoReference *echo_reference_{nullptr};
+  uint32_t dma_frames_{0};
 };
 
 }  // namespace i2s_audio
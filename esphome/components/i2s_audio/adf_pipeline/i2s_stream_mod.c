@@ -33,14 +33,15 @@
 #include "driver/i2s.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
 
 #include "audio_common.h"
 #include "audio_mem.h"
 #include "audio_element.h"
-#include "i2s_stream.h"
-#include "esp_alc.h"
+#include "i2s_stream_mod.h"
 #include "board_pins_config.h"
 #include "audio_idf_version.h"
+#include "esphome/components/audio_kernels/audio_kernels.h"
 
 static const char *TAG = "I2S_STREAM";
 
@@ -57,37 +58,26 @@ typedef struct i2s_stream {
     audio_stream_type_t type;
     i2s_stream_cfg_t    config;
     bool                is_open;
-    bool                use_alc;
-    void                *volume_handle;
-    int                 volume;
     bool                uninstall_drv;
+    i2s_stream_tap_cb_t tap_cb;
+    void                *tap_ctx;
+    char                *silence;           /*!< Preallocated, written while the input is empty */
+    int                 silence_len;
+    int                 tail_pos;           /*!< Held back bytes of the last block in the element's buffer */
+    int                 tail_len;
+    bool                underrun;
+    int64_t             last_write_end_us;
+    i2s_underrun_stats_t stats;
 } i2s_stream_t;
 #ifdef SOC_I2S_SUPPORTS_ADC_DAC
-static esp_err_t i2s_mono_fix(int bits, uint8_t *sbuff, uint32_t len)
+// the FIFO of the ESP32 swaps the samples of every pair in mono mode
+static void i2s_mono_fix(int bits, uint8_t *sbuff, uint32_t len)
 {
     if (bits == 16) {
-        int16_t *temp_buf = (int16_t *)sbuff;
-        int16_t temp_box;
-        int k = len >> 1;
-        for (int i = 0; i < k; i += 2) {
-            temp_box = temp_buf[i];
-            temp_buf[i] = temp_buf[i + 1];
-            temp_buf[i + 1] = temp_box;
-        }
-    } else if (bits == 32) {
-        int32_t *temp_buf = (int32_t *)sbuff;
-        int32_t temp_box;
-        int k = len >> 2;
-        for (int i = 0; i < k; i += 4) {
-            temp_box = temp_buf[i];
-            temp_buf[i] = temp_buf[i + 1];
-            temp_buf[i + 1] = temp_box;
-        }
+        audio_swap_pairs_s16((int16_t *)sbuff, len / sizeof(int16_t));
     } else {
-        ESP_LOGE(TAG, "%s %dbits is not supported", __func__, bits);
-        return ESP_FAIL;
+        audio_swap_pairs_s32((int32_t *)sbuff, len / sizeof(int32_t));
     }
-    return ESP_OK;
 }
 
 /**
@@ -95,54 +85,70 @@ static esp_err_t i2s_mono_fix(int bits, uint8_t *sbuff, uint32_t len)
  *        DAC can only output 8bit data value.
  *        I2S DMA will still send 16bit or 32bit data, the highest 8bit contains DAC data.
  */
-static int i2s_dac_data_scale(int bits, uint8_t *sBuff, uint32_t len)
+static void i2s_dac_data_scale(int bits, uint8_t *sBuff, uint32_t len)
 {
     if (bits == 16) {
-        short *buf16 = (short *)sBuff;
-        int k = len >> 1;
-        for (int i = 0; i < k; i++) {
-            buf16[i] &= 0xff00;
-            buf16[i] += 0x8000;//turn signed value into unsigned, expand negative value into positive range
-        }
-    } else if (bits == 32) {
-        int *buf32 = (int *)sBuff;
-        int k = len >> 2;
-        for (int i = 0; i < k; i++) {
-            buf32[i] &= 0xff000000;
-            buf32[i] += 0x80000000;//turn signed value into unsigned
-        }
+        audio_dac_scale_s16((int16_t *)sBuff, len / sizeof(int16_t));
     } else {
-        ESP_LOGE(TAG, "in %s %dbits is not supported", __func__, bits);
-        return -1;
+        audio_dac_scale_s32((int32_t *)sBuff, len / sizeof(int32_t));
     }
-
-    return 0;
 }
 #endif
 
-static int i2s_stream_clear_dma_buffer(audio_element_handle_t self)
+static bool i2s_stream_is_builtin_dac(i2s_stream_t *i2s)
 {
-    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
-    int index = i2s->config.i2s_config.dma_buf_count;
-    uint8_t *buf = audio_calloc(1, i2s->config.i2s_config.dma_buf_len * 4);
-    AUDIO_MEM_CHECK(TAG, buf, return ESP_ERR_NO_MEM);
 #if SOC_I2S_SUPPORTS_ADC_DAC
-    if ((i2s->config.i2s_config.mode & I2S_MODE_DAC_BUILT_IN) != 0) {
-        memset(buf, 0x80, i2s->config.i2s_config.dma_buf_len * 4);
-    }
+    return (i2s->config.i2s_config.mode & I2S_MODE_DAC_BUILT_IN) != 0;
+#else
+    return false;
 #endif
-    while (index--) {
-        audio_element_output(self, (char *)buf, i2s->config.i2s_config.dma_buf_len * 4);
-    }
-    if (buf) {
-        audio_free(buf);
+}
+
+// refills the silence buffer, writes modify it in place
+static char *i2s_stream_get_silence(i2s_stream_t *i2s)
+{
+    audio_silence(i2s->silence, i2s->silence_len, i2s_stream_is_builtin_dac(i2s));
+    return i2s->silence;
+}
+
+static int i2s_stream_clear_dma_buffer(audio_element_handle_t self)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    int remaining = i2s->config.i2s_config.dma_buf_count * i2s->config.i2s_config.dma_buf_len * 4;
+    while (remaining > 0) {
+        const int len = remaining < i2s->silence_len ? remaining : i2s->silence_len;
+        audio_element_output(self, i2s_stream_get_silence(i2s), len);
+        remaining -= len;
     }
     return ESP_OK;
 }
 
-static esp_err_t _i2s_set_clk(i2s_port_t i2s_num, uint32_t rate, uint32_t bits_cfg, int ch)
+static uint32_t i2s_stream_dma_us(i2s_stream_t *i2s, int rate)
+{
+    if (rate <= 0) {
+        return 0;
+    }
+    return (uint64_t)i2s->config.i2s_config.dma_buf_count * i2s->config.i2s_config.dma_buf_len * 1000000 / rate;
+}
+
+static esp_err_t _i2s_set_clk(i2s_stream_t *i2s, uint32_t rate, int bits, int ch)
 {
+    const i2s_driver_config_t *cfg = &i2s->config.i2s_config;
+    // wider slots are kept, the upper 16 bits carry the slot width
+    uint32_t bits_cfg = bits;
+    if (cfg->bits_per_chan > bits) {
+        bits_cfg |= (uint32_t)cfg->bits_per_chan << 16;
+    }
     i2s_channel_t channel;
+#if SOC_I2S_SUPPORTS_TDM
+    if (cfg->channel_format == I2S_CHANNEL_FMT_MULTIPLE) {
+        // the active slots are fixed at install, they define the number of channels
+        if (__builtin_popcount(cfg->chan_mask & 0xFFFF0000) != ch) {
+            return ESP_FAIL;
+        }
+        return i2s_set_clk(i2s->config.i2s_port, rate, bits_cfg, cfg->chan_mask);
+    }
+#endif
     if (ch == 1) {
         channel = I2S_CHANNEL_MONO;
     } else if (ch == 2) {
@@ -150,7 +156,7 @@ static esp_err_t _i2s_set_clk(i2s_port_t i2s_num, uint32_t rate, uint32_t bits_c
     } else {
         return ESP_FAIL;
     }
-    return i2s_set_clk(i2s_num, rate, bits_cfg, channel);
+    return i2s_set_clk(i2s->config.i2s_port, rate, bits_cfg, channel);
 }
 
 static esp_err_t _i2s_open(audio_element_handle_t self)
@@ -162,17 +168,18 @@ static esp_err_t _i2s_open(audio_element_handle_t self)
     }
 
     if (i2s->type == AUDIO_STREAM_WRITER) {
-        audio_element_set_input_timeout(self, 10 / portTICK_RATE_MS);
+        // silence is inserted before the DMA buffers play out, at most after 10ms
+        audio_element_info_t info;
+        audio_element_getinfo(self, &info);
+        uint32_t timeout_ms = i2s_stream_dma_us(i2s, info.sample_rates) / 2000;
+        TickType_t ticks = (timeout_ms < 10 ? timeout_ms : 10) / portTICK_RATE_MS;
+        audio_element_set_input_timeout(self, ticks > 0 ? ticks : 1);
+        i2s->tail_len = 0;
+        i2s->underrun = false;
+        i2s->last_write_end_us = 0;
         ESP_LOGI(TAG, "AUDIO_STREAM_WRITER");
     }
     i2s->is_open = true;
-    if (i2s->use_alc) {
-        i2s->volume_handle = alc_volume_setup_open();
-        if (i2s->volume_handle == NULL) {
-            ESP_LOGE(TAG, "i2s create the handle for setting volume failed, in line(%d)", __LINE__);
-            return ESP_FAIL;
-        }
-    }
     return ESP_OK;
 }
 
@@ -182,6 +189,7 @@ static esp_err_t _i2s_destroy(audio_element_handle_t self)
     if (i2s->uninstall_drv) {
         i2s_driver_uninstall(i2s->config.i2s_port);
     }
+    audio_free(i2s->silence);
     audio_free(i2s);
     return ESP_OK;
 }
@@ -194,15 +202,15 @@ static esp_err_t _i2s_close(audio_element_handle_t self)
         return ret;
     }
     i2s->is_open = false;
+    i2s->last_write_end_us = 0;
+    if (i2s->stats.underruns > 0 || i2s->stats.late_writes > 0) {
+        ESP_LOGI(TAG, "underruns: %u, late writes: %u", (unsigned)i2s->stats.underruns,
+                 (unsigned)i2s->stats.late_writes);
+    }
     if (AEL_STATE_PAUSED != audio_element_get_state(self)) {
         audio_element_report_pos(self);
         audio_element_set_byte_pos(self, 0);
     }
-    if (i2s->use_alc) {
-        if (i2s->volume_handle != NULL) {
-            alc_volume_setup_close(i2s->volume_handle);
-        }
-    }
     return ESP_OK;
 }
 
@@ -220,6 +228,9 @@ static int _i2s_read(audio_element_handle_t self, char *buffer, int len, TickTyp
             i2s_mono_fix(info.bits, (uint8_t *)buffer, bytes_read);
         }
 #endif
+        if (i2s->tap_cb) {
+            i2s->tap_cb(self, buffer, bytes_read, i2s->tap_ctx);
+        }
     }
 
     /*
@@ -249,12 +260,14 @@ static int _i2s_write(audio_element_handle_t self, char *buffer, int len, TickTy
         }
 #endif
 #if SOC_I2S_SUPPORTS_ADC_DAC
-        if ((i2s->config.i2s_config.mode & I2S_MODE_DAC_BUILT_IN) != 0) {
+        if (i2s_stream_is_builtin_dac(i2s)) {
             i2s_dac_data_scale(info.bits, (uint8_t *)buffer, len);
         }
 #endif
     }
 
+    i2s_underrun_check_late(&i2s->stats, i2s->last_write_end_us, esp_timer_get_time(),
+                            i2s_stream_dma_us(i2s, info.sample_rates));
     if (i2s->config.need_expand && (i2s->config.i2s_config.bits_per_sample != i2s->config.expand_src_bits)) {
         i2s_write_expand(i2s->config.i2s_port,
                          buffer,
@@ -266,33 +279,110 @@ static int _i2s_write(audio_element_handle_t self, char *buffer, int len, TickTy
     } else {
         i2s_write(i2s->config.i2s_port, buffer, len, &bytes_written, ticks_to_wait);
     }
+    i2s->last_write_end_us = esp_timer_get_time();
+
+    if (i2s->tap_cb && bytes_written > 0) {
+#ifdef CONFIG_IDF_TARGET_ESP32
+        if (info.channels == 1) {
+            // undo the swap, the tap expects the samples in order
+            i2s_mono_fix(info.bits, (uint8_t *)buffer, bytes_written);
+        }
+#endif
+        i2s->tap_cb(self, buffer, bytes_written, i2s->tap_ctx);
+    }
 
     return bytes_written;
 }
 
+static int i2s_stream_output(audio_element_handle_t self, char *buffer, int len)
+{
+    audio_element_multi_output(self, buffer, len, 0);
+    return audio_element_output(self, buffer, len);
+}
+
+/**
+ * Writers hold back the last frames of every block in the element's buffer. If the next block
+ * is late, they are faded out before silence is inserted, the first frames after the underrun
+ * are faded in. The element's buffer is reused, so nothing is allocated on this path.
+ */
+static int _i2s_process_writer(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    audio_element_info_t info;
+    audio_element_getinfo(self, &info);
+    const int bits = info.bits > 16 ? 32 : 16;
+    const int channels = info.channels > 0 ? info.channels : 1;
+    const int frame_size = bits / 8 * channels;
+    const int align = i2s_underrun_align(frame_size);
+    int hold = I2S_UNDERRUN_FADE_FRAMES * frame_size;
+    if (hold > in_len / 4) {
+        hold = in_len / 4 / frame_size * frame_size;
+    }
+
+    if (i2s->tail_len > 0 && i2s->tail_pos > 0) {
+        memmove(in_buffer, in_buffer + i2s->tail_pos, i2s->tail_len);
+    }
+    i2s->tail_pos = 0;
+    // whole frames are read, so the held back bytes always start at a frame
+    const int read_len = (in_len - i2s->tail_len) / frame_size * frame_size;
+    int r_size = audio_element_input(self, in_buffer + i2s->tail_len, read_len);
+    int w_size = 0;
+    if (r_size == AEL_IO_TIMEOUT) {
+        // before the first block there is nothing to fade out and nothing missing
+        if (!i2s->underrun && i2s->tail_len > 0) {
+            i2s->underrun = true;
+            const int len = i2s_underrun_flush_tail(in_buffer, i2s->tail_len, align, bits, channels, true);
+            if (len > 0) {
+                i2s_stream_output(self, in_buffer, len);
+            }
+            i2s->tail_len = 0;
+        }
+        char *silence = i2s_stream_get_silence(i2s);
+        w_size = i2s_stream_output(self, silence, i2s->silence_len);
+    } else if (r_size > 0) {
+        const int total = i2s->tail_len + r_size;
+        int write_len = i2s_underrun_next_block(in_buffer, total, hold, align, bits, channels, &i2s->underrun,
+                                                &i2s->stats);
+        if (write_len > 0) {
+            w_size = i2s_stream_output(self, in_buffer, write_len);
+            audio_element_update_byte_pos(self, w_size);
+        } else {
+            // nothing to write yet, but the input has been consumed
+            w_size = r_size;
+        }
+        i2s->tail_pos = write_len;
+        i2s->tail_len = total - write_len;
+    } else {
+        // the end of the stream is written as is, an aborted stream is faded out
+        const int len = i2s_underrun_flush_tail(in_buffer, i2s->tail_len, align, bits, channels, r_size != AEL_IO_DONE);
+        if (len > 0) {
+            i2s_stream_output(self, in_buffer, len);
+        }
+        i2s->tail_len = 0;
+        i2s->underrun = false;
+        esp_err_t ret = i2s_stream_clear_dma_buffer(self);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        w_size = r_size;
+    }
+    return w_size;
+}
+
 static int _i2s_process(audio_element_handle_t self, char *in_buffer, int in_len)
 {
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
+    if (i2s->type == AUDIO_STREAM_WRITER) {
+        return _i2s_process_writer(self, in_buffer, in_len);
+    }
     int r_size = audio_element_input(self, in_buffer, in_len);
     int w_size = 0;
-    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(self);
-    audio_element_info_t i2s_info = {0};
     if (r_size == AEL_IO_TIMEOUT) {
-#if SOC_I2S_SUPPORTS_ADC_DAC
-        if ((i2s->config.i2s_config.mode & I2S_MODE_DAC_BUILT_IN) != 0) {
-            memset(in_buffer, 0x80, in_len);
-        } else
-#endif
-        {
-            memset(in_buffer, 0x00, in_len);
-        }
+        audio_silence(in_buffer, in_len, i2s_stream_is_builtin_dac(i2s));
         r_size = in_len;
         audio_element_multi_output(self, in_buffer, r_size, 0);
         w_size = audio_element_output(self, in_buffer, r_size);
     } else if (r_size > 0) {
-        if (i2s->use_alc) {
-            audio_element_getinfo(self, &i2s_info);
-            alc_volume_setup_process(in_buffer, r_size, i2s_info.channels, i2s->volume_handle, i2s->volume);
-        }
         audio_element_multi_output(self, in_buffer, r_size, 0);
         w_size = audio_element_output(self, in_buffer, r_size);
         audio_element_update_byte_pos(self, w_size);
@@ -315,8 +405,12 @@ esp_err_t i2s_stream_set_clk(audio_element_handle_t i2s_stream, int rate, int bi
         audio_element_pause(i2s_stream);
     }
     audio_element_set_music_info(i2s_stream, rate, ch, bits);
+    i2s->config.i2s_config.bits_per_sample = (i2s_bits_per_sample_t)bits;
+    // the pause isn't a late write
+    i2s->last_write_end_us = 0;
+    i2s->config.need_expand = false;
 
-    if (_i2s_set_clk(i2s->config.i2s_port, rate, bits, ch) == ESP_FAIL) {
+    if (_i2s_set_clk(i2s, rate, bits, ch) == ESP_FAIL) {
         ESP_LOGE(TAG, "i2s_set_clk failed, type = %d,port:%d", i2s->config.type, i2s->config.i2s_port);
         err = ESP_FAIL;
     }
@@ -326,28 +420,26 @@ esp_err_t i2s_stream_set_clk(audio_element_handle_t i2s_stream, int rate, int bi
     return err;
 }
 
-int i2s_alc_volume_set(audio_element_handle_t i2s_stream, int volume)
+esp_err_t i2s_stream_set_expand(audio_element_handle_t i2s_stream, int src_bits)
 {
     i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
-    if (i2s->use_alc) {
-        i2s->volume = volume;
-        return ESP_OK;
-    } else {
-        ESP_LOGW(TAG, "The ALC don't be used. It can not be set.");
+    if (i2s->type != AUDIO_STREAM_WRITER || src_bits > i2s->config.i2s_config.bits_per_sample) {
         return ESP_FAIL;
     }
-}
-
-int i2s_alc_volume_get(audio_element_handle_t i2s_stream, int *volume)
-{
-    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
-    if (i2s->use_alc) {
-        *volume = i2s->volume;
-        return ESP_OK;
-    } else {
-        ESP_LOGW(TAG, "The ALC don't be used");
-        return ESP_FAIL;
+    audio_element_state_t state = audio_element_get_state(i2s_stream);
+    if (state == AEL_STATE_RUNNING) {
+        audio_element_pause(i2s_stream);
+    }
+    // the music info describes the samples in the buffers, the bus keeps its width
+    audio_element_info_t info;
+    audio_element_getinfo(i2s_stream, &info);
+    audio_element_set_music_info(i2s_stream, info.sample_rates, info.channels, src_bits);
+    i2s->config.need_expand = src_bits < i2s->config.i2s_config.bits_per_sample;
+    i2s->config.expand_src_bits = (i2s_bits_per_sample_t)src_bits;
+    if (state == AEL_STATE_RUNNING) {
+        audio_element_resume(i2s_stream, 0, 0);
     }
+    return ESP_OK;
 }
 
 audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config)
@@ -372,9 +464,13 @@ audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config)
     memcpy(&i2s->config, config, sizeof(i2s_stream_cfg_t));
 
     i2s->type = config->type;
-    i2s->use_alc = config->use_alc;
-    i2s->volume = config->volume;
     i2s->uninstall_drv = config->uninstall_drv;
+    i2s->silence_len = I2S_STREAM_BUF_SIZE;
+    i2s->silence = audio_calloc(1, i2s->silence_len);
+    AUDIO_MEM_CHECK(TAG, i2s->silence, {
+        audio_free(i2s);
+        return NULL;
+    });
 
     if (config->type == AUDIO_STREAM_READER) {
         cfg.read = _i2s_read;
@@ -385,14 +481,20 @@ audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config)
 
     el = audio_element_init(&cfg);
     AUDIO_MEM_CHECK(TAG, el, {
+        audio_free(i2s->silence);
         audio_free(i2s);
         return NULL;
     });
     audio_element_setdata(el, i2s);
 
-    audio_element_set_music_info(el, config->i2s_config.sample_rate,
-                                 config->i2s_config.channel_format < I2S_CHANNEL_FMT_ONLY_RIGHT ? 2 : 1,
-                                 config->i2s_config.bits_per_sample);
+    int channels = config->i2s_config.channel_format < I2S_CHANNEL_FMT_ONLY_RIGHT ? 2 : 1;
+#if SOC_I2S_SUPPORTS_TDM
+    if (config->i2s_config.channel_format == I2S_CHANNEL_FMT_MULTIPLE) {
+        channels = __builtin_popcount(config->i2s_config.chan_mask & 0xFFFF0000);
+    }
+#endif
+    audio_element_set_music_info(el, config->i2s_config.sample_rate, channels,
+                                 config->need_expand ? config->expand_src_bits : config->i2s_config.bits_per_sample);
 #if SOC_I2S_SUPPORTS_ADC_DAC
     if ((config->i2s_config.mode & I2S_MODE_DAC_BUILT_IN) != 0) {
         i2s_set_dac_mode(I2S_DAC_CHANNEL_BOTH_EN);
@@ -403,6 +505,27 @@ audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config)
     return el;
 }
 
+esp_err_t i2s_stream_set_tap(audio_element_handle_t i2s_stream, i2s_stream_tap_cb_t cb, void *ctx)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
+    if (i2s == NULL) {
+        return ESP_FAIL;
+    }
+    i2s->tap_cb = cb;
+    i2s->tap_ctx = ctx;
+    return ESP_OK;
+}
+
+esp_err_t i2s_stream_get_stats(audio_element_handle_t i2s_stream, i2s_underrun_stats_t *stats)
+{
+    i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
+    if (i2s == NULL || stats == NULL) {
+        return ESP_FAIL;
+    }
+    *stats = i2s->stats;
+    return ESP_OK;
+}
+
 esp_err_t i2s_stream_sync_delay(audio_element_handle_t i2s_stream, int delay_ms)
 {
     char *in_buffer = NULL;
@@ -414,15 +537,8 @@ esp_err_t i2s_stream_sync_delay(audio_element_handle_t i2s_stream, int delay_ms)
         uint32_t delay_size = (~delay_ms + 1) * ((uint32_t)(info.sample_rates * info.channels * info.bits / 8) / 1000);
         in_buffer = (char *)audio_malloc(delay_size);
         AUDIO_MEM_CHECK(TAG, in_buffer, return ESP_FAIL);
-#if SOC_I2S_SUPPORTS_ADC_DAC
         i2s_stream_t *i2s = (i2s_stream_t *)audio_element_getdata(i2s_stream);
-        if ((i2s->config.i2s_config.mode & I2S_MODE_DAC_BUILT_IN) != 0) {
-            memset(in_buffer, 0x80, delay_size);
-        } else
-#endif
-        {
-            memset(in_buffer, 0x00, delay_size);
-        }
+        audio_silence(in_buffer, delay_size, i2s_stream_is_builtin_dac(i2s));
         ringbuf_handle_t input_rb = audio_element_get_input_ringbuf(i2s_stream);
         if (input_rb) {
             rb_write(input_rb, in_buffer, delay_size, 0);
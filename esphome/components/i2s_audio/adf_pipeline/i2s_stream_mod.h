@@ -30,6 +30,8 @@
 #include "audio_error.h"
 #include "audio_idf_version.h"
 
+#include "../i2s_underrun.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -42,8 +44,8 @@ typedef struct {
     audio_stream_type_t     type;               /*!< Type of stream */
     i2s_config_t            i2s_config;         /*!< I2S driver configurations */
     i2s_port_t              i2s_port;           /*!< I2S driver hardware port */
-    bool                    use_alc;            /*!< It is a flag for ALC. If use ALC, the value is true. Or the value is false */
-    int                     volume;             /*!< The volume of audio input data will be set. */
+    bool                    use_alc;            /*!< Unused, the ALC was replaced by the gain element. Kept for the layout of i2s_stream.h */
+    int                     volume;             /*!< Unused, kept for the layout of i2s_stream.h */
     int                     out_rb_size;        /*!< Size of output ringbuffer */
     int                     task_stack;         /*!< Task stack size */
     int                     task_core;          /*!< Task running in core (0 or 1) */
@@ -253,7 +255,7 @@ audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config);
  * @param[in]  i2s_stream   The i2s element handle
  * @param[in]  rate  Clock rate (in Hz)
  * @param[in]  bits  Audio bit width (8, 16, 24, 32)
- * @param[in]  ch    Number of Audio channels (1: Mono, 2: Stereo)
+ * @param[in]  ch    Number of Audio channels (1: Mono, 2: Stereo), in TDM mode the number of active slots
  *
  * @return
  *     - ESP_OK
@@ -262,40 +264,65 @@ audio_element_handle_t i2s_stream_init(i2s_stream_cfg_t *config);
 esp_err_t i2s_stream_set_clk(audio_element_handle_t i2s_stream, int rate, int bits, int ch);
 
 /**
- * @brief      Setup volume of stream by using ALC
+ * @brief      Set the bit width of the samples written to the stream if it is narrower than the bus.
+ *             The samples are expanded by `i2s_write_expand` while they are copied to DMA, the clock
+ *             is left untouched. Only for writers, `i2s_stream_set_clk` disables the expansion.
  *
  * @param[in]  i2s_stream   The i2s element handle
- * @param[in]  volume       The volume of stream will be set.
+ * @param[in]  src_bits     Bit width of the samples in the stream, the bus width disables the expansion
  *
  * @return
  *     - ESP_OK
  *     - ESP_FAIL
  */
-esp_err_t i2s_alc_volume_set(audio_element_handle_t i2s_stream, int volume);
+esp_err_t i2s_stream_set_expand(audio_element_handle_t i2s_stream, int src_bits);
 
 /**
- * @brief      Get volume of stream
+ * @brief      Set sync delay of stream
  *
  * @param[in]  i2s_stream   The i2s element handle
- * @param[in]  volume       The volume of stream
+ * @param[in]  delay_ms     The delay of stream
  *
  * @return
  *     - ESP_OK
  *     - ESP_FAIL
  */
-esp_err_t i2s_alc_volume_get(audio_element_handle_t i2s_stream, int *volume);
+esp_err_t i2s_stream_sync_delay(audio_element_handle_t i2s_stream, int delay_ms);
 
 /**
- * @brief      Set sync delay of stream
+ * @brief      Callback invoked with every block transferred to or from the driver
  *
  * @param[in]  i2s_stream   The i2s element handle
- * @param[in]  delay_ms     The delay of stream
+ * @param[in]  buffer       The transferred samples
+ * @param[in]  len          The number of transferred bytes
+ * @param[in]  ctx          The context passed to `i2s_stream_set_tap`
+ */
+typedef void (*i2s_stream_tap_cb_t)(audio_element_handle_t i2s_stream, const char *buffer, int len, void *ctx);
+
+/**
+ * @brief      Set a tap on the stream, e.g. for providing an echo reference
+ *
+ * @param[in]  i2s_stream   The i2s element handle
+ * @param[in]  cb           The callback, NULL removes the tap
+ * @param[in]  ctx          The context passed to the callback
  *
  * @return
  *     - ESP_OK
  *     - ESP_FAIL
  */
-esp_err_t i2s_stream_sync_delay(audio_element_handle_t i2s_stream, int delay_ms);
+esp_err_t i2s_stream_set_tap(audio_element_handle_t i2s_stream, i2s_stream_tap_cb_t cb, void *ctx);
+
+/**
+ * @brief      Get the underrun counters of a writer since it was created
+ *
+ * @param[in]  i2s_stream   The i2s element handle
+ * @param[out] stats        The counters
+ *
+ * @return
+ *     - ESP_OK
+ *     - ESP_FAIL
+ */
+esp_err_t i2s_stream_get_stats(audio_element_handle_t i2s_stream, i2s_underrun_stats_t *stats);
 
 #ifdef __cplusplus
 }
@@ -87,6 +87,16 @@ bool ES7210::init_device(){
 
 bool ES7210::apply_i2s_settings(const i2s_driver_config_t&  i2s_cfg){
     //hard coded to 16bit,
+#if SOC_I2S_SUPPORTS_TDM
+    if (i2s_cfg.channel_format == I2S_CHANNEL_FMT_MULTIPLE && i2s_cfg.total_chan > 2) {
+      esph_log_d(TAG, "Enable TDM with all four ADCs");
+      this->reg(0x45) = 0x1B; // MIC3_GAIN [SELMIC3: select MIC3P and MIC3N, GAIN: 33dB]
+      this->reg(0x46) = 0x1B; // MIC4_GAIN [SELMIC4: select MIC4P and MIC4N, GAIN: 33dB]
+      this->reg(0x4C) = 0x00; // MIC 3/4 power down [all set to normal]
+      this->reg(0x12) = 0x02; // SDOUT_MODE [TDM: ADC1 to ADC4 in one frame on SDOUT1]
+      this->reg(0x01) = 0x00; // CLK_ON_OFF [all clocks on]
+    }
+#endif
     return true;
 }
 
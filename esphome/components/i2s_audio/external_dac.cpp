@@ -5,6 +5,8 @@
 #include "esphome/core/log.h"
 #include "esphome/core/hal.h"
 
+#include <algorithm>
+
 namespace esphome {
 namespace i2s_audio {
 
@@ -72,11 +74,11 @@ bool AW88298::apply_i2s_settings(const i2s_driver_config_t&  i2s_cfg){
   return true;
 }
 
-bool AW88298::set_volume( float volume ){
+bool AW88298::set_attenuation( uint8_t half_db ){
   // 0 to 96 dB
   // 7:4 in unit of -6dB
   // 3:0 in unit of -0.5dB
-  uint16_t val = (1. - volume) * 192.;
+  uint16_t val = std::min<uint16_t>(half_db, 192);
   val = (val / 12) << 4 | (val % 12);
   val = (val << 8 ) | 0x0064;
   this->write_bytes_16(0x0C, &val, 1 ); // AW88298_REG_HAGCCFG3
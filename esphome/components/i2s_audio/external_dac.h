@@ -19,7 +19,10 @@ public:
 
   virtual bool apply_i2s_settings(const i2s_driver_config_t&  i2s_cfg) {return true;}
   virtual bool set_mute_audio( bool mute ){return true;}
-  virtual bool set_volume( float volume ){return true;}
+  // true if the DAC can attenuate the output, volume requests are handled by the DAC then
+  virtual bool supports_volume() const {return false;}
+  // attenuation in steps of 0.5dB
+  virtual bool set_attenuation( uint8_t half_db ){return true;}
 
   void set_gpio_enable(GPIOPin* enable_pin){this->enable_pin_ = enable_pin;}
 protected:
@@ -30,7 +33,8 @@ class AW88298 : public ExternalDAC {
   bool init_device() override;
   bool apply_i2s_settings(const i2s_driver_config_t&  i2s_cfg) override;
   bool set_mute_audio( bool mute );
-  bool set_volume( float volume );
+  bool supports_volume() const override {return true;}
+  bool set_attenuation( uint8_t half_db ) override;
 };
 
 class ES8388 : public ExternalDAC {
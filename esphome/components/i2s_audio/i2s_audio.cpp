@@ -4,11 +4,23 @@
 
 #include "esphome/core/log.h"
 
+#include <esp_timer.h>
+
+#include <algorithm>
+
 namespace esphome {
 namespace i2s_audio {
 
 static const char *const TAG = "i2s_audio";
 
+static const int DEFAULT_DMA_BUF_COUNT = 4;
+// one buffer is played while the next is queued and the third is filled
+static const int LOW_LATENCY_DMA_BUF_COUNT = 3;
+static const int MIN_DMA_BUF_LEN = 8;
+// limits of the legacy driver for a single DMA buffer
+static const int MAX_DMA_BUF_LEN = 1024;
+static const int MAX_DMA_BUF_BYTES = 4092;
+
 void I2SAudioComponent::setup() {
   static i2s_port_t next_port_num = I2S_NUM_0;
 
@@ -28,6 +40,9 @@ void I2SAudioComponent::dump_config(){
   esph_log_config(TAG, "I2SController:");
   esph_log_config(TAG, "  AccessMode: %s", this->access_mode_ == I2SAccessMode::DUPLEX ? "duplex" : "exclusive" );
   esph_log_config(TAG, "  Port: %d", this->get_port() );
+  if( this->idle_timeout_ms_ > 0 ){
+    esph_log_config(TAG, "  Idle timeout: %u ms", (unsigned) this->idle_timeout_ms_ );
+  }
   if( this->audio_in_ != nullptr ){
     esph_log_config(TAG, "  Reader registered.");
   }
@@ -65,26 +80,51 @@ bool I2SAudioComponent::install_i2s_driver_(i2s_driver_config_t i2s_cfg, uint8_t
   bool success = false;
   this->lock();
   if( this->access_state_ == I2SAccess::FREE || this->access_state_ == access ){
-    if(this->access_mode_ == I2SAccessMode::DUPLEX){
-      i2s_cfg.mode = (i2s_mode_t) (i2s_cfg.mode | I2S_MODE_TX | I2S_MODE_RX);
+    const int64_t start_us = esp_timer_get_time();
+    if( this->driver_installed_ && this->can_reclock_(i2s_cfg) ){
+      success = this->reclock_(i2s_cfg);
+      esph_log_d(TAG, "Reclocking driver : %s", success ? "yes" : "no" );
     }
-    success = ESP_OK == i2s_driver_install(this->get_port(), &i2s_cfg, 0, nullptr);
-    esph_log_d(TAG, "Installing driver : %s", success ? "yes" : "no" );
-    i2s_pin_config_t pin_config = this->get_pin_config();
-    if( success ){
-      if( this->audio_in_ != nullptr )
-      {
-        pin_config.data_in_num = this->audio_in_->get_din_pin();
+    else {
+      if( this->driver_installed_ ){
+        // mode, DMA buffers or channel format differ from the resident driver
+        this->uninstall_();
       }
-      if( this->audio_out_ != nullptr )
-      {
-        pin_config.data_out_num = this->audio_out_->get_dout_pin();
+      const bool both_registered = this->audio_in_ != nullptr && this->audio_out_ != nullptr;
+      if(this->access_mode_ == I2SAccessMode::DUPLEX || (both_registered && this->keep_resident_(i2s_cfg))){
+        i2s_cfg.mode = (i2s_mode_t) (i2s_cfg.mode | I2S_MODE_TX | I2S_MODE_RX);
       }
-      success &= ESP_OK == i2s_set_pin(this->get_port(), &pin_config);
+      success = ESP_OK == i2s_driver_install(this->get_port(), &i2s_cfg, 0, nullptr);
+      esph_log_d(TAG, "Installing driver : %s", success ? "yes" : "no" );
+      i2s_pin_config_t pin_config = this->get_pin_config();
       if( success ){
-        this->access_state_ = access;
+        this->driver_installed_ = true;
         this->installed_cfg_ = i2s_cfg;
+        if( this->audio_in_ != nullptr )
+        {
+          pin_config.data_in_num = this->audio_in_->get_din_pin();
+        }
+        if( this->audio_out_ != nullptr )
+        {
+          pin_config.data_out_num = this->audio_out_->get_dout_pin();
+        }
+#if SOC_I2S_SUPPORTS_ADC
+        // the built-in ADC isn't connected via the pins
+        if( (i2s_cfg.mode & I2S_MODE_ADC_BUILT_IN) == 0 )
+#endif
+        success &= ESP_OK == i2s_set_pin(this->get_port(), &pin_config);
+      }
+    }
+    if( success ){
+      this->access_state_ = access;
+      const int64_t now_us = esp_timer_get_time();
+      esph_log_d(TAG, "Driver ready in %.1f ms", (now_us - start_us) / 1000.f);
+      if( this->released_access_ != I2SAccess::FREE && this->released_access_ != access ){
+        this->last_handover_us_ = now_us - this->released_us_;
+        esph_log_d(TAG, "Handover %s -> %s: %.1f ms", this->released_access_ == I2SAccess::RX ? "RX" : "TX",
+                   access == I2SAccess::RX ? "RX" : "TX", this->last_handover_us_ / 1000.f);
       }
+      this->released_access_ = I2SAccess::FREE;
     }
   } else if (this->access_mode_ == I2SAccessMode::DUPLEX && (this->access_state_ & access) == 0){
     success = this->validate_cfg_for_duplex_(i2s_cfg);
@@ -101,13 +141,18 @@ bool I2SAudioComponent::uninstall_i2s_driver_(uint8_t access){
   this->lock();
   // check that i2s is not occupied by others
   if( (this->access_state_ & ~access) == 0 ){
-    i2s_zero_dma_buffer(this->get_port());
-    esp_err_t err = i2s_driver_uninstall(this->get_port());
-    if (err == ESP_OK) {
+    if( this->driver_installed_ && this->keep_resident_(this->installed_cfg_) ){
+      // the next component reclocks the driver, loop() uninstalls it once it stayed idle
+      i2s_zero_dma_buffer(this->get_port());
       success = true;
+    }
+    else {
+      success = this->uninstall_();
+    }
+    if( success ){
       this->access_state_ = I2SAccess::FREE;
-    } else {
-      esph_log_e(TAG, "Couldn't unload driver");
+      this->released_access_ = access;
+      this->released_us_ = esp_timer_get_time();
     }
   }
   else {
@@ -120,12 +165,131 @@ bool I2SAudioComponent::uninstall_i2s_driver_(uint8_t access){
   return success;
 }
 
+bool I2SAudioComponent::uninstall_(){
+  const int64_t start_us = esp_timer_get_time();
+  i2s_zero_dma_buffer(this->get_port());
+  esp_err_t err = i2s_driver_uninstall(this->get_port());
+  if (err != ESP_OK) {
+    esph_log_e(TAG, "Couldn't unload driver");
+    return false;
+  }
+  this->driver_installed_ = false;
+  esph_log_d(TAG, "Driver uninstalled in %.1f ms", (esp_timer_get_time() - start_us) / 1000.f);
+  return true;
+}
+
+void I2SAudioComponent::loop(){
+  if( !this->driver_installed_ || this->access_state_ != I2SAccess::FREE ){
+    return;
+  }
+  if( esp_timer_get_time() - this->released_us_ < (int64_t) this->idle_timeout_ms_ * 1000 ){
+    return;
+  }
+  if( this->try_lock() ){
+    if( this->driver_installed_ && this->access_state_ == I2SAccess::FREE ){
+      esph_log_d(TAG, "Driver idle for %u ms", (unsigned) this->idle_timeout_ms_);
+      this->uninstall_();
+      this->released_access_ = I2SAccess::FREE;
+    }
+    this->unlock();
+  }
+}
+
+bool I2SAudioComponent::keep_resident_(const i2s_driver_config_t &i2s_cfg) const {
+  if( this->idle_timeout_ms_ == 0 ){
+    return false;
+  }
+  // PDM and the built-in ADC and DAC need a driver installed for their direction only
+  uint32_t special_modes = I2S_MODE_PDM;
+#if SOC_I2S_SUPPORTS_ADC
+  special_modes |= I2S_MODE_ADC_BUILT_IN;
+#endif
+#if SOC_I2S_SUPPORTS_DAC
+  special_modes |= I2S_MODE_DAC_BUILT_IN;
+#endif
+  return (i2s_cfg.mode & special_modes) == 0;
+}
+
+bool I2SAudioComponent::can_reclock_(const i2s_driver_config_t &i2s_cfg) const {
+  const i2s_driver_config_t &installed = this->installed_cfg_;
+  const uint32_t directions = I2S_MODE_TX | I2S_MODE_RX;
+  // the direction has to be installed already, everything else but the clock is fixed at install
+  if( (installed.mode & ~directions) != (i2s_cfg.mode & ~directions) ||
+      (installed.mode & i2s_cfg.mode & directions) != (i2s_cfg.mode & directions) ){
+    return false;
+  }
+  if( installed.use_apll != i2s_cfg.use_apll || installed.communication_format != i2s_cfg.communication_format ||
+      installed.dma_buf_count != i2s_cfg.dma_buf_count || installed.dma_buf_len != i2s_cfg.dma_buf_len ){
+    return false;
+  }
+  // i2s_set_clk selects the right channel in mono, in stereo it switches back to right_left,
+  // while the TDM capable chips keep the channel format of the driver
+#if SOC_I2S_SUPPORTS_TDM
+  if( installed.channel_format == I2S_CHANNEL_FMT_MULTIPLE || i2s_cfg.channel_format == I2S_CHANNEL_FMT_MULTIPLE ){
+    return installed.channel_format == i2s_cfg.channel_format && installed.total_chan == i2s_cfg.total_chan;
+  }
+  return i2s_cfg.channel_format == I2S_CHANNEL_FMT_ONLY_RIGHT ||
+         (i2s_cfg.channel_format == installed.channel_format && i2s_cfg.channel_format != I2S_CHANNEL_FMT_ONLY_LEFT);
+#else
+  return i2s_cfg.channel_format == I2S_CHANNEL_FMT_ONLY_RIGHT || i2s_cfg.channel_format == I2S_CHANNEL_FMT_RIGHT_LEFT;
+#endif
+}
+
+bool I2SAudioComponent::reclock_(const i2s_driver_config_t &i2s_cfg){
+  const uint32_t bits_cfg = ((uint32_t) i2s_cfg.bits_per_chan << 16) | i2s_cfg.bits_per_sample;
+  i2s_channel_t channel = I2S_CHANNEL_STEREO;
+#if SOC_I2S_SUPPORTS_TDM
+  if( i2s_cfg.channel_format == I2S_CHANNEL_FMT_MULTIPLE ){
+    channel = i2s_cfg.chan_mask;
+  } else
+#endif
+  if( i2s_cfg.channel_format == I2S_CHANNEL_FMT_ONLY_RIGHT || i2s_cfg.channel_format == I2S_CHANNEL_FMT_ONLY_LEFT ){
+    channel = I2S_CHANNEL_MONO;
+  }
+  if( i2s_set_clk(this->get_port(), i2s_cfg.sample_rate, bits_cfg, channel) != ESP_OK ){
+    return false;
+  }
+  this->clk_changed_(i2s_cfg);
+  return true;
+}
+
+void I2SAudioComponent::clk_changed_(const i2s_driver_config_t &i2s_cfg){
+  i2s_driver_config_t &installed = this->installed_cfg_;
+  installed.sample_rate = i2s_cfg.sample_rate;
+  installed.bits_per_sample = i2s_cfg.bits_per_sample;
+  installed.bits_per_chan = i2s_cfg.bits_per_chan;
+#if SOC_I2S_SUPPORTS_TDM
+  if( i2s_cfg.channel_format == I2S_CHANNEL_FMT_MULTIPLE ){
+    installed.chan_mask = i2s_cfg.chan_mask;
+    return;
+  }
+#endif
+  installed.channel_format = i2s_cfg.channel_format;
+}
+
 bool I2SAudioComponent::validate_cfg_for_duplex_(i2s_driver_config_t& i2s_cfg){
-  i2s_driver_config_t& installed = this->installed_cfg_;
-  return (
-         installed.sample_rate == i2s_cfg.sample_rate
-     &&  installed.bits_per_chan == i2s_cfg.bits_per_chan
-  );
+  // the legacy driver runs both directions of a port with the format of the first installation,
+  // a second direction can only join if it expects exactly the same frames on the bus
+  const i2s_driver_config_t& installed = this->installed_cfg_;
+  const char *mismatch = nullptr;
+  if (installed.sample_rate != i2s_cfg.sample_rate) {
+    mismatch = "sample rate";
+  } else if (installed.bits_per_sample != i2s_cfg.bits_per_sample ||
+             installed.bits_per_chan != i2s_cfg.bits_per_chan) {
+    mismatch = "bits per sample";
+  } else if (installed.channel_format != i2s_cfg.channel_format) {
+    mismatch = "channel format";
+  }
+#if SOC_I2S_SUPPORTS_TDM
+  else if (installed.chan_mask != i2s_cfg.chan_mask || installed.total_chan != i2s_cfg.total_chan) {
+    mismatch = "TDM slots";
+  }
+#endif
+  if (mismatch != nullptr) {
+    esph_log_e(TAG, "Duplex access refused, %s differs from the installed driver", mismatch);
+    return false;
+  }
+  return true;
 }
 
 
@@ -139,7 +303,56 @@ void I2SSettings::dump_i2s_settings() const {
   }
   esph_log_config(TAG, "  sample-rate: %d bits_per_sample: %d", this->sample_rate_, this->bits_per_sample_ );
   esph_log_config(TAG, "  channel_fmt: %d channels: %d", this->channel_fmt_, this->num_of_channels() );
+  if (this->is_tdm()) {
+    esph_log_config(TAG, "  TDM slots: %d, active: 0x%04X", this->tdm_slots_, this->tdm_slot_mask_);
+  }
+  if (this->slot_bit_width_ > 0) {
+    esph_log_config(TAG, "  slot bit width: %d", this->slot_bit_width_);
+  }
   esph_log_config(TAG, "  use_apll: %s, use_pdm: %s", this->use_apll_ ? "yes": "no", this->pdm_ ? "yes": "no");
+  int dma_buf_count, dma_buf_len;
+  this->get_dma_geometry(dma_buf_count, dma_buf_len);
+  esph_log_config(TAG, "  DMA: %d x %d frames (%.1f ms)%s", dma_buf_count, dma_buf_len,
+                  this->get_dma_latency_us() / 1000.f, this->target_latency_ms_ > 0 ? ", low latency" : "");
+}
+
+void I2SSettings::get_dma_geometry(int &dma_buf_count, int &dma_buf_len) const {
+  dma_buf_count = this->dma_buf_count_ > 0 ? this->dma_buf_count_ : DEFAULT_DMA_BUF_COUNT;
+  dma_buf_len = this->dma_buf_len_;
+  if (this->target_latency_ms_ == 0) {
+    return;
+  }
+  if (this->dma_buf_count_ == 0) {
+    dma_buf_count = LOW_LATENCY_DMA_BUF_COUNT;
+  }
+  const int bytes_per_frame = (this->bits_per_sample_ > I2S_BITS_PER_SAMPLE_16BIT ? 4 : 2) * this->num_of_channels();
+  const int max_len = std::min(MAX_DMA_BUF_LEN, MAX_DMA_BUF_BYTES / bytes_per_frame);
+  const int frames = std::max<int>(dma_buf_count * MIN_DMA_BUF_LEN, this->sample_rate_ * this->target_latency_ms_ / 1000);
+  // the latency is split into more buffers if the configured ones can't hold it
+  dma_buf_count = std::max(dma_buf_count, (frames + max_len - 1) / max_len);
+  dma_buf_len = frames / dma_buf_count;
+}
+
+uint32_t I2SSettings::get_i2s_channel() const {
+  if (this->is_tdm()) {
+    return (uint32_t) this->tdm_slot_mask_ << 16;
+  }
+  return this->num_of_channels() == 1 ? I2S_CHANNEL_MONO : I2S_CHANNEL_STEREO;
+}
+
+uint32_t I2SSettings::get_i2s_bits_cfg() const {
+  // the driver rejects slots narrower than the samples, e.g. after the bit depth followed the stream
+  const uint32_t slot_bits = this->slot_bit_width_ >= this->bits_per_sample_ ? this->slot_bit_width_ : 0;
+  return (slot_bits << 16) | this->bits_per_sample_;
+}
+
+uint32_t I2SSettings::get_dma_latency_us() const {
+  if (this->sample_rate_ == 0) {
+    return 0;
+  }
+  int dma_buf_count, dma_buf_len;
+  this->get_dma_geometry(dma_buf_count, dma_buf_len);
+  return (uint64_t) dma_buf_count * dma_buf_len * 1000000 / this->sample_rate_;
 }
 
 
@@ -157,13 +370,13 @@ i2s_driver_config_t I2SSettings::get_i2s_cfg() const {
       .channel_format = this->channel_fmt_,
       .communication_format = I2S_COMM_FORMAT_STAND_I2S,
       .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-      .dma_buf_count = 4,
+      .dma_buf_count = DEFAULT_DMA_BUF_COUNT,
       .dma_buf_len = 256,
       .use_apll = false,
       .tx_desc_auto_clear = true,
       .fixed_mclk = I2S_PIN_NO_CHANGE,
       .mclk_multiple = I2S_MCLK_MULTIPLE_DEFAULT,
-      .bits_per_chan = I2S_BITS_PER_CHAN_DEFAULT,
+      .bits_per_chan = (i2s_bits_per_chan_t) (this->get_i2s_bits_cfg() >> 16),
 #if SOC_I2S_SUPPORTS_TDM
       .chan_mask = I2S_CHANNEL_MONO,
       .total_chan = 0,
@@ -173,6 +386,14 @@ i2s_driver_config_t I2SSettings::get_i2s_cfg() const {
       .skip_msk = false,
 #endif
   };
+  this->get_dma_geometry(config.dma_buf_count, config.dma_buf_len);
+#if SOC_I2S_SUPPORTS_TDM
+  if (this->is_tdm()) {
+    config.channel_format = I2S_CHANNEL_FMT_MULTIPLE;
+    config.chan_mask = (i2s_channel_t) this->get_i2s_channel();
+    config.total_chan = this->tdm_slots_;
+  }
+#endif
 
   return config;
 }
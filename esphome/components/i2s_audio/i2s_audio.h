@@ -24,6 +24,7 @@ class I2SWriter;
 class I2SAudioComponent : public Component {
  public:
   void setup() override;
+  void loop() override;
   void dump_config() override;
 
   i2s_pin_config_t get_pin_config() const {
@@ -51,6 +52,14 @@ class I2SAudioComponent : public Component {
   void set_access_mode(I2SAccessMode access_mode){this->access_mode_ = access_mode;}
   bool is_exclusive(){return this->access_mode_ == I2SAccessMode::EXCLUSIVE;}
 
+  // the driver stays installed for this long after the last component released it, a change of
+  // direction or format in between only reclocks it, 0 uninstalls it right away
+  void set_idle_timeout(uint32_t idle_timeout_ms) { this->idle_timeout_ms_ = idle_timeout_ms; }
+
+  // time from the driver's release by one direction to its install or reclock by the other one,
+  // e.g. from the microphone stopping to the speaker being able to play, 0 before the first handover
+  uint32_t get_last_handover_us() const { return this->last_handover_us_; }
+
  protected:
   friend I2SReader;
   friend I2SWriter;
@@ -64,6 +73,11 @@ class I2SAudioComponent : public Component {
   bool install_i2s_driver_(i2s_driver_config_t i2s_cfg, uint8_t access);
   bool uninstall_i2s_driver_(uint8_t access);
   bool validate_cfg_for_duplex_(i2s_driver_config_t& i2s_cfg);
+  bool keep_resident_(const i2s_driver_config_t &i2s_cfg) const;
+  bool can_reclock_(const i2s_driver_config_t &i2s_cfg) const;
+  bool reclock_(const i2s_driver_config_t &i2s_cfg);
+  void clk_changed_(const i2s_driver_config_t &i2s_cfg);
+  bool uninstall_();
 
   I2SReader *audio_in_{nullptr};
   I2SWriter *audio_out_{nullptr};
@@ -74,6 +88,13 @@ class I2SAudioComponent : public Component {
   i2s_port_t port_{};
 
   i2s_driver_config_t installed_cfg_{};
+  bool driver_installed_{false};
+  uint32_t idle_timeout_ms_{0};
+
+  // direction which released the driver last and when it was done
+  uint8_t released_access_{I2SAccess::FREE};
+  int64_t released_us_{0};
+  uint32_t last_handover_us_{0};
 };
 
 class ExternalADC;
@@ -93,8 +114,34 @@ public:
   void set_pdm(bool pdm) { this->pdm_ = pdm; }
   void set_sample_rate(uint32_t sample_rate) { this->sample_rate_ = sample_rate; }
   void set_fixed_settings(bool is_fixed){ this->is_fixed_ = is_fixed; }
-  int num_of_channels() const { return (this->channel_fmt_ == I2S_CHANNEL_FMT_ONLY_RIGHT
-   || this->channel_fmt_ == I2S_CHANNEL_FMT_ONLY_LEFT) ? 1 : 2; }
+  // TDM with total_slots slots on the bus, of which the ones in slot_mask (bit n for slot n) carry the
+  // stream's channels, a mask of 0 is standard I2S with one or two channels
+  void set_tdm(uint16_t slot_mask, uint8_t total_slots) {
+    this->tdm_slot_mask_ = slot_mask;
+    this->tdm_slots_ = total_slots;
+  }
+  // bits per slot on the bus, 0 uses the sample width, wider slots are padded
+  void set_slot_bit_width(uint8_t slot_bit_width) { this->slot_bit_width_ = slot_bit_width; }
+  void set_dma_buf_count(uint8_t dma_buf_count) { this->dma_buf_count_ = dma_buf_count; }
+  // frames per DMA buffer
+  void set_dma_buf_len(uint16_t dma_buf_len) { this->dma_buf_len_ = dma_buf_len; }
+  // sizes the DMA buffers for the given latency at the configured sample rate, 0 disables it
+  void set_low_latency(uint32_t target_latency_ms) { this->target_latency_ms_ = target_latency_ms; }
+  // number of DMA buffers and frames per buffer, as installed with get_i2s_cfg()
+  void get_dma_geometry(int &dma_buf_count, int &dma_buf_len) const;
+  // time for the DMA buffers to play out (or fill up) at the current sample rate
+  uint32_t get_dma_latency_us() const;
+  bool is_tdm() const { return this->tdm_slot_mask_ != 0; }
+  // channels as passed to the driver's i2s_set_clk, in TDM mode the active slots in the upper 16 bits
+  uint32_t get_i2s_channel() const;
+  // bits per slot and per sample as passed to the driver's i2s_set_clk
+  uint32_t get_i2s_bits_cfg() const;
+  int num_of_channels() const {
+    if (this->is_tdm()) {
+      return __builtin_popcount(this->tdm_slot_mask_);
+    }
+    return (this->channel_fmt_ == I2S_CHANNEL_FMT_ONLY_RIGHT || this->channel_fmt_ == I2S_CHANNEL_FMT_ONLY_LEFT) ? 1 : 2;
+  }
 
 protected:
    bool use_apll_{false};
@@ -104,6 +151,13 @@ protected:
    i2s_mode_t i2s_access_mode_;
    bool pdm_{false};
    uint32_t sample_rate_;
+   uint16_t tdm_slot_mask_{0};
+   uint8_t tdm_slots_{0};
+   uint8_t slot_bit_width_{0};
+   // 0 keeps the default number of buffers
+   uint8_t dma_buf_count_{0};
+   uint16_t dma_buf_len_{256};
+   uint32_t target_latency_ms_{0};
 
    bool is_fixed_{false};
    uint8_t i2s_access_;
@@ -154,6 +208,12 @@ public:
    bool claim_i2s_access(){return this->parent_->claim_access_(I2SAccess::TX);}
    bool release_i2s_access(){return this->parent_->release_access_(I2SAccess::TX);}
    bool is_adjustable(){return !this->is_fixed_ && this->parent_->is_exclusive();}
+   // to be called after the installed driver was reclocked with the current settings
+   void i2s_clk_changed(){
+      this->parent_->lock();
+      this->parent_->clk_changed_(this->get_i2s_cfg());
+      this->parent_->unlock();
+   }
 
 #if SOC_I2S_SUPPORTS_DAC
   void set_internal_dac_mode(i2s_dac_mode_t mode) { this->internal_dac_mode_ = mode; }
@@ -9,6 +9,14 @@ CONF_BITS_PER_SAMPLE = "bits_per_sample"
 CONF_PDM = "pdm"
 CONF_USE_APLL = "use_apll"
 CONF_FIXED_SETTINGS = "fixed_settings"
+CONF_TDM_CHANNELS = "tdm_channels"
+CONF_TDM = "tdm"
+CONF_SLOTS = "slots"
+CONF_ACTIVE_SLOTS = "active_slots"
+CONF_SLOT_BIT_WIDTH = "slot_bit_width"
+CONF_DMA_BUF_COUNT = "dma_buf_count"
+CONF_DMA_BUF_LEN = "dma_buf_len"
+CONF_LOW_LATENCY = "low_latency"
 
 i2s_mode_t = cg.global_ns.enum("i2s_mode_t")
 I2S_CLK_MODE_OPTIONS = {
@@ -65,5 +73,13 @@ CONFIG_SCHEMA_I2S_COMMON = cv.Schema(
         ),
         cv.Optional(CONF_USE_APLL, default=False): cv.boolean,
         cv.Optional(CONF_FIXED_SETTINGS, default=False): cv.boolean,
+        cv.Optional(CONF_DMA_BUF_COUNT): cv.int_range(min=2, max=128),
+        cv.Exclusive(CONF_DMA_BUF_LEN, "dma_geometry"): cv.int_range(min=8, max=1024),
+        cv.Exclusive(CONF_LOW_LATENCY, "dma_geometry"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(
+                min=cv.TimePeriod(milliseconds=2), max=cv.TimePeriod(milliseconds=200)
+            ),
+        ),
     }
 )
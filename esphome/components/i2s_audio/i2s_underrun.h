@@ -0,0 +1,97 @@
+#pragma once
+
+/*
+Helpers for I2S writers which keep the DMA fed with silence while their input runs dry.
+The last frames of every block are held back, so they can be faded out if the next block
+is late, and the first frames after an underrun are faded in. Shared by the C stream
+element of the adf_pipeline and the speaker, hence plain C.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "esphome/components/audio_kernels/audio_kernels.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// frames held back for the fade into an underrun and faded in after it, 1.3ms at 48kHz
+#define I2S_UNDERRUN_FADE_FRAMES 64
+
+typedef struct {
+  // number of times the input ran dry while playing and silence was inserted until it continued
+  uint32_t underruns;
+  // writes which started after the DMA buffers had played out, the driver sent zeros in between
+  uint32_t late_writes;
+} i2s_underrun_stats_t;
+
+// linear fade of interleaved frames with 16 bit or 32 bit containers, fade_in ramps up from silence
+static inline void i2s_underrun_fade(void *buffer, int bits, int channels, size_t num_frames, bool fade_in) {
+  // Q15
+  const int32_t from = fade_in ? 0 : 1 << 15;
+  const int32_t to = fade_in ? 1 << 15 : 0;
+  if (bits > 16) {
+    audio_mix_ramp_s32((int32_t *) buffer, (const int32_t *) buffer, from, to, NULL, 0, 0, num_frames, channels, 15);
+  } else {
+    audio_mix_ramp_s16((int16_t *) buffer, (const int16_t *) buffer, from, to, NULL, 0, 0, num_frames, channels, 15);
+  }
+}
+
+// writes are whole frames and whole 32 bit words
+static inline size_t i2s_underrun_align(size_t frame_size) {
+  size_t align = frame_size;
+  while (align % 4) {
+    align += frame_size;
+  }
+  return align;
+}
+
+// the buffer holds the bytes held back from the previous block followed by the new data, total in all,
+// fades in after an underrun and counts it, returns the bytes to write now, whole units of align which
+// leave at least hold bytes for the next block
+static inline size_t i2s_underrun_next_block(void *buffer, size_t total, size_t hold, size_t align, int bits,
+                                             int channels, bool *underrun, i2s_underrun_stats_t *stats) {
+  if (*underrun) {
+    // counted once the audio continues, the end of the audio isn't an underrun
+    *underrun = false;
+    stats->underruns++;
+    const size_t frames = total / (size_t) (bits / 8 * channels);
+    i2s_underrun_fade(buffer, bits, channels, frames < I2S_UNDERRUN_FADE_FRAMES ? frames : I2S_UNDERRUN_FADE_FRAMES,
+                      true);
+  }
+  return total > hold ? (total - hold) / align * align : 0;
+}
+
+// the whole frames of the tail_len held back bytes at the start of the buffer, faded out unless the audio
+// ends as is, and padded with silence to whole units of align, returns the bytes to write,
+// an incomplete frame at the end is overwritten and the buffer needs room for the padding
+static inline size_t i2s_underrun_flush_tail(void *buffer, size_t tail_len, size_t align, int bits, int channels,
+                                             bool fade_out) {
+  const size_t frame_size = (size_t) (bits / 8 * channels);
+  const size_t tail = tail_len / frame_size * frame_size;
+  if (tail == 0) {
+    return 0;
+  }
+  if (fade_out) {
+    i2s_underrun_fade(buffer, bits, channels, tail / frame_size, false);
+  }
+  const size_t padded = (tail + align - 1) / align * align;
+  memset((uint8_t *) buffer + tail, 0, padded - tail);
+  return padded;
+}
+
+// counts a late write if the DMA buffers had played out since the end of the previous write,
+// last_write_end_us 0 skips the check, e.g. after starting or pausing
+static inline void i2s_underrun_check_late(i2s_underrun_stats_t *stats, int64_t last_write_end_us, int64_t now_us,
+                                           uint32_t dma_us) {
+  if (last_write_end_us > 0 && now_us - last_write_end_us > (int64_t) dma_us) {
+    stats->late_writes++;
+  }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,6 +5,7 @@
 #include <driver/i2s.h>
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
+#include "esphome/components/audio_kernels/audio_kernels.h"
 
 #ifdef I2S_EXTERNAL_ADC
 #include "../external_adc.h"
@@ -64,7 +65,7 @@ i2s_driver_config_t config = this->get_i2s_cfg();
 #if SOC_I2S_SUPPORTS_ADC
   if (this->use_internal_adc_) {
     config.mode = (i2s_mode_t) (config.mode | I2S_MODE_ADC_BUILT_IN);
-    i2s_driver_install(this->parent_->get_port(), &config, 0, nullptr);
+    this->install_i2s_driver(config);
 
     i2s_set_adc_mode(ADC_UNIT_1, this->adc_channel_);
     i2s_adc_enable(this->parent_->get_port());
@@ -122,15 +123,9 @@ size_t I2SAudioMicrophone::read(int16_t *buf, size_t len) {
   if (this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_16BIT) {
     return bytes_read;
   } else if (this->bits_per_sample_ == I2S_BITS_PER_SAMPLE_32BIT) {
-    std::vector<int16_t> samples;
+    // convert in place, each 16 bit sample is written below the 32 bit sample it was taken from
     size_t samples_read = bytes_read / sizeof(int32_t);
-    uint8_t shift = 16 - this->gain_log2_ ;
-    samples.resize(samples_read);
-    for (size_t i = 0; i < samples_read; i++) {
-      int32_t temp = reinterpret_cast<int32_t *>(buf)[i] >> shift;
-      samples[i] = static_cast<int16_t>(clamp<int32_t>(temp, INT16_MIN, INT16_MAX));
-    }
-    memcpy(buf, samples.data(), samples_read * sizeof(int16_t));
+    audio_s32_to_s16(reinterpret_cast<const int32_t *>(buf), buf, samples_read, 16 - this->gain_log2_);
     return samples_read * sizeof(int16_t);
   } else {
     ESP_LOGE(TAG, "Unsupported bits per sample: %d", this->bits_per_sample_);
@@ -3,6 +3,9 @@
 #ifdef USE_ESP32
 
 #include <driver/i2s.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cstring>
 #include "esphome/core/application.h"
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
@@ -14,6 +17,11 @@ namespace esphome {
 namespace i2s_audio {
 
 static const size_t BUFFER_COUNT = 20;
+// the player stops if no data arrives for this long
+static const uint32_t END_OF_AUDIO_MS = 100;
+// silence is inserted before the DMA buffers play out, but at most after this
+static const uint32_t MAX_UNDERRUN_WAIT_MS = 10;
+static const uint8_t SILENCE[BUFFER_SIZE] = {};
 
 static const char *const TAG = "i2s_audio.speaker";
 
@@ -78,15 +86,9 @@ void I2SAudioSpeaker::player_task(void *params) {
     }
   }
 
+  // the pins are set up by the I2S component when it installs the driver
 #if SOC_I2S_SUPPORTS_DAC
-  if (this_speaker->internal_dac_mode_ == I2S_DAC_CHANNEL_DISABLE) {
-#endif
-    i2s_pin_config_t pin_config = this_speaker->parent_->get_pin_config();
-    pin_config.data_out_num = this_speaker->dout_pin_;
-
-    i2s_set_pin(this_speaker->parent_->get_port(), &pin_config);
-#if SOC_I2S_SUPPORTS_DAC
-  } else {
+  if (this_speaker->internal_dac_mode_ != I2S_DAC_CHANNEL_DISABLE) {
     i2s_set_dac_mode(this_speaker->internal_dac_mode_);
   }
 #endif
@@ -99,21 +101,72 @@ void I2SAudioSpeaker::player_task(void *params) {
 
   DataEvent data_event;
 
+  // the last frames of every event are held back, so they can be faded out if the next one is late,
+  // the first frames after an underrun are faded in
+  const int bits = this_speaker->bits_per_sample_ > I2S_BITS_PER_SAMPLE_16BIT ? 32 : 16;
+  const int channels = std::min(this_speaker->num_of_channels(), 2);
+  const size_t frame_size = bits / 8 * channels;
+  const size_t align = i2s_underrun_align(frame_size);
+  const size_t hold = I2S_UNDERRUN_FADE_FRAMES * frame_size;
+  // the held back frames plus less than a write unit, events aren't necessarily frame aligned
+  uint8_t block[(I2S_UNDERRUN_FADE_FRAMES + 1) * 8 + BUFFER_SIZE];
+  size_t tail_len = 0;
+  bool underrun = false;
+
+  int dma_buf_count, dma_buf_len;
+  this_speaker->get_dma_geometry(dma_buf_count, dma_buf_len);
+  const size_t silence_len = std::min(BUFFER_SIZE, dma_buf_len * frame_size);
+  this_speaker->dma_us_ = this_speaker->get_dma_latency_us();
+  this_speaker->last_write_end_us_ = 0;
+  const uint32_t wait_ms = std::min(MAX_UNDERRUN_WAIT_MS, this_speaker->dma_us_ / 2000);
+  const TickType_t wait_ticks = std::max<TickType_t>(1, wait_ms / portTICK_PERIOD_MS);
+  TickType_t waited_ticks = 0;
+
   event.type = TaskEventType::STARTED;
   xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
 
   while (true) {
-    if (xQueueReceive(this_speaker->buffer_queue_, &data_event, 100 / portTICK_PERIOD_MS) != pdTRUE) {
-      break;  // End of audio from main thread
+    if (xQueueReceive(this_speaker->buffer_queue_, &data_event, wait_ticks) != pdTRUE) {
+      waited_ticks += wait_ticks;
+      if (waited_ticks * portTICK_PERIOD_MS >= END_OF_AUDIO_MS) {
+        break;  // End of audio from main thread
+      }
+      if (!underrun && tail_len > 0) {
+        underrun = true;
+        // an incomplete frame continues with the next event
+        const size_t partial_len = tail_len % frame_size;
+        uint8_t partial[8];
+        memcpy(partial, block + tail_len - partial_len, partial_len);
+        const size_t len = i2s_underrun_flush_tail(block, tail_len, align, bits, channels, true);
+        if (len > 0) {
+          this_speaker->write_i2s_(block, len);
+        }
+        memcpy(block, partial, partial_len);
+        tail_len = partial_len;
+      }
+      if (underrun) {
+        this_speaker->write_i2s_(SILENCE, silence_len);
+      }
+      continue;
     }
+    waited_ticks = 0;
     if (data_event.stop) {
       // Stop signal from main thread
       xQueueReset(this_speaker->buffer_queue_);  // Flush queue
+      const size_t len = i2s_underrun_flush_tail(block, tail_len, align, bits, channels, true);
+      if (len > 0) {
+        this_speaker->write_i2s_(block, len);
+      }
       break;
     }
-    size_t bytes_written;
-    esp_err_t err = i2s_write(this_speaker->parent_->get_port(), data_event.data, data_event.len, &bytes_written,
-                                (10 / portTICK_PERIOD_MS));
+
+    memcpy(block + tail_len, data_event.data, data_event.len);
+    const size_t total = tail_len + data_event.len;
+    const size_t write_len =
+        i2s_underrun_next_block(block, total, hold, align, bits, channels, &underrun, &this_speaker->stats_);
+    esp_err_t err = write_len > 0 ? this_speaker->write_i2s_(block, write_len) : ESP_OK;
+    tail_len = total - write_len;
+    memmove(block, block + write_len, tail_len);
     if (err != ESP_OK) {
       event = {.type = TaskEventType::WARNING, .err = err};
       xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
@@ -124,8 +177,6 @@ void I2SAudioSpeaker::player_task(void *params) {
     xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
   }
 
-  i2s_zero_dma_buffer(this_speaker->parent_->get_port());
-
   event.type = TaskEventType::STOPPING;
   xQueueSend(this_speaker->event_queue_, &event, portMAX_DELAY);
 
@@ -139,6 +190,17 @@ void I2SAudioSpeaker::player_task(void *params) {
   }
 }
 
+esp_err_t I2SAudioSpeaker::write_i2s_(const uint8_t *data, size_t len) {
+  if (len == 0) {
+    return ESP_OK;
+  }
+  i2s_underrun_check_late(&this->stats_, this->last_write_end_us_, esp_timer_get_time(), this->dma_us_);
+  size_t bytes_written;
+  esp_err_t err = i2s_write(this->parent_->get_port(), data, len, &bytes_written, (10 / portTICK_PERIOD_MS));
+  this->last_write_end_us_ = esp_timer_get_time();
+  return err;
+}
+
 void I2SAudioSpeaker::stop() {
   if (this->state_ == speaker::STATE_STOPPED)
     return;
@@ -164,6 +226,10 @@ void I2SAudioSpeaker::watch_() {
         break;
       case TaskEventType::STOPPING:
         ESP_LOGD(TAG, "Stopping I2S Audio Speaker");
+        if (this->stats_.underruns > 0 || this->stats_.late_writes > 0) {
+          ESP_LOGD(TAG, "Underruns: %u, late writes: %u", (unsigned) this->stats_.underruns,
+                   (unsigned) this->stats_.late_writes);
+        }
         break;
       case TaskEventType::PLAYING:
         this->status_clear_warning();
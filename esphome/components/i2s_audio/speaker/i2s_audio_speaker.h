@@ -3,6 +3,7 @@
 #ifdef USE_ESP32
 
 #include "../i2s_audio.h"
+#include "../i2s_underrun.h"
 
 #include <driver/i2s.h>
 #include <freertos/FreeRTOS.h>
@@ -59,9 +60,15 @@ class I2SAudioSpeaker : public Component, public speaker::Speaker, public I2SWri
 
   bool has_buffered_data() const override;
 
+  // times the queue ran dry while playing and silence was inserted, and writes after the DMA buffers had played out
+  uint32_t get_underruns() const { return this->stats_.underruns; }
+  uint32_t get_late_writes() const { return this->stats_.late_writes; }
+
  protected:
   void start_();
   void watch_();
+  // called from the player task
+  esp_err_t write_i2s_(const uint8_t *data, size_t len);
 
   static void player_task(void *params);
 
@@ -75,6 +82,11 @@ class I2SAudioSpeaker : public Component, public speaker::Speaker, public I2SWri
   i2s_dac_mode_t internal_dac_mode_{I2S_DAC_CHANNEL_DISABLE};
 #endif
   uint8_t external_dac_channels_;
+
+  // written by the player task
+  i2s_underrun_stats_t stats_{};
+  int64_t last_write_end_us_{0};
+  uint32_t dma_us_{0};
 };
 
 }  // namespace i2s_audio
@@ -41,6 +41,7 @@ CONF_VAD_THRESHOLD = "vad_threshold"
 CONF_AUTO_GAIN = "auto_gain"
 CONF_NOISE_SUPPRESSION_LEVEL = "noise_suppression_level"
 CONF_VOLUME_MULTIPLIER = "volume_multiplier"
+CONF_ON_DEVICE_PROCESSING = "on_device_processing"
 
 
 voice_assistant_ns = cg.esphome_ns.namespace("voice_assistant")
@@ -73,6 +74,16 @@ def tts_stream_validate(config):
     return config
 
 
+def on_device_processing_validate(config):
+    if config[CONF_ON_DEVICE_PROCESSING] and (
+        config[CONF_NOISE_SUPPRESSION_LEVEL] > 0 or config[CONF_AUTO_GAIN] > 0
+    ):
+        raise cv.Invalid(
+            f"{CONF_NOISE_SUPPRESSION_LEVEL} and {CONF_AUTO_GAIN} can't be used with {CONF_ON_DEVICE_PROCESSING}, configure the processing element of the microphone pipeline instead"
+        )
+    return config
+
+
 CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
@@ -92,6 +103,7 @@ CONFIG_SCHEMA = cv.All(
             cv.Optional(CONF_VOLUME_MULTIPLIER, default=1.0): cv.float_range(
                 min=0.0, min_included=False
             ),
+            cv.Optional(CONF_ON_DEVICE_PROCESSING, default=False): cv.boolean,
             cv.Optional(CONF_ON_LISTENING): automation.validate_automation(single=True),
             cv.Optional(CONF_ON_START): automation.validate_automation(single=True),
             cv.Optional(CONF_ON_WAKE_WORD_DETECTED): automation.validate_automation(
@@ -130,6 +142,7 @@ CONFIG_SCHEMA = cv.All(
         }
     ).extend(cv.COMPONENT_SCHEMA),
     tts_stream_validate,
+    on_device_processing_validate,
 )
 
 
@@ -156,6 +169,7 @@ async def to_code(config):
     cg.add(var.set_noise_suppression_level(config[CONF_NOISE_SUPPRESSION_LEVEL]))
     cg.add(var.set_auto_gain(config[CONF_AUTO_GAIN]))
     cg.add(var.set_volume_multiplier(config[CONF_VOLUME_MULTIPLIER]))
+    cg.add(var.set_on_device_processing(config[CONF_ON_DEVICE_PROCESSING]))
 
     if CONF_ON_LISTENING in config:
         await automation.build_automation(
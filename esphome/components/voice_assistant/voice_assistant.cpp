@@ -25,6 +25,8 @@ static const size_t BUFFER_SIZE = BUFFER_LENGTH_MSEC * SAMPLE_RATE_HZ / 1000;
 #else
 static const size_t BUFFER_SIZE = 1024 * SAMPLE_RATE_HZ / 1000;
 #endif
+// room on top of the wake word pre-roll for the audio captured until streaming has started
+static const size_t PRE_ROLL_SLACK_MSEC = 512;
 static const size_t SEND_BUFFER_SIZE = INPUT_BUFFER_SIZE * sizeof(int16_t);
 static const size_t RECEIVE_SIZE = 1024;
 static const size_t SPEAKER_BUFFER_SIZE = 16 * RECEIVE_SIZE;
@@ -97,7 +99,13 @@ void VoiceAssistant::setup() {
   }
 #endif
 
-  this->ring_buffer_ = RingBuffer::create(BUFFER_SIZE * sizeof(int16_t));
+  // the buffer holds the pre-roll of the on-device wake word
+  size_t buffer_size = BUFFER_SIZE;
+  if (this->local_wake_word_) {
+    buffer_size = std::max<size_t>(buffer_size,
+                                   (this->wake_word_pre_roll_ms_ + PRE_ROLL_SLACK_MSEC) * SAMPLE_RATE_HZ / 1000);
+  }
+  this->ring_buffer_ = RingBuffer::create(buffer_size * sizeof(int16_t));
   if (this->ring_buffer_ == nullptr) {
     ESP_LOGW(TAG, "Could not allocate ring buffer");
     this->mark_failed();
@@ -111,10 +119,93 @@ void VoiceAssistant::setup() {
     this->mark_failed();
     return;
   }
+
+  if (this->opus_frame_duration_ms_ > 0) {
+    this->opus_packet_ = send_allocator.allocate(SEND_BUFFER_SIZE);
+    if (this->opus_packet_ == nullptr) {
+      ESP_LOGW(TAG, "Could not allocate Opus packet buffer");
+      this->mark_failed();
+      return;
+    }
+  }
+}
+
+void VoiceAssistant::reset_ring_buffer_() {
+  this->ring_buffer_->reset();
+  this->opus_packets_buffered_ = 0;
+}
+
+void VoiceAssistant::write_opus_packets_(const uint8_t *data, size_t len) {
+  while (len > 0) {
+    if (this->opus_header_fill_ < sizeof(this->opus_header_)) {
+      this->opus_header_[this->opus_header_fill_++] = *data++;
+      len--;
+      if (this->opus_header_fill_ == sizeof(this->opus_header_)) {
+        this->opus_packet_len_ = (this->opus_header_[0] << 8) | this->opus_header_[1];
+        this->opus_packet_fill_ = 0;
+        if (this->opus_packet_len_ > SEND_BUFFER_SIZE) {
+          // the packet boundaries are lost, anything read from here on would be misread
+          ESP_LOGW(TAG, "Invalid Opus packet length: %u, restarting the microphone", this->opus_packet_len_);
+          this->opus_restart_ = true;
+          return;
+        }
+      }
+      continue;
+    }
+    const size_t to_copy = std::min(len, this->opus_packet_len_ - this->opus_packet_fill_);
+    memcpy(this->opus_packet_ + this->opus_packet_fill_, data, to_copy);
+    this->opus_packet_fill_ += to_copy;
+    data += to_copy;
+    len -= to_copy;
+    if (this->opus_packet_fill_ == this->opus_packet_len_) {
+      // drop the oldest packets instead of letting the ring buffer drop parts of them
+      const size_t needed = sizeof(this->opus_header_) + this->opus_packet_len_;
+      while (this->ring_buffer_->free() < needed && this->opus_packets_buffered_ > 0) {
+        this->read_opus_packet_();
+      }
+      if (this->ring_buffer_->free() >= needed) {
+        this->ring_buffer_->write((void *) this->opus_header_, sizeof(this->opus_header_));
+        this->ring_buffer_->write((void *) this->opus_packet_, this->opus_packet_len_);
+        this->opus_packets_buffered_++;
+      } else {
+        ESP_LOGW(TAG, "No room for an Opus packet of %u bytes, dropped", this->opus_packet_len_);
+      }
+      this->opus_header_fill_ = 0;
+    }
+  }
+}
+
+size_t VoiceAssistant::read_opus_packet_() {
+  if (this->opus_packets_buffered_ == 0) {
+    return 0;
+  }
+  uint8_t header[2];
+  if (this->ring_buffer_->read((void *) header, sizeof(header), 0) == sizeof(header)) {
+    const size_t len = (header[0] << 8) | header[1];
+    if (len > 0 && this->ring_buffer_->read((void *) this->send_buffer_, len, 0) == len) {
+      this->opus_packets_buffered_--;
+      return len;
+    }
+  }
+  // a short read means the packet boundaries in the ring buffer are lost, nothing buffered can be sent
+  ESP_LOGW(TAG, "Opus packets out of sync, dropping %u buffered packets", this->opus_packets_buffered_);
+  this->reset_ring_buffer_();
+  return 0;
 }
 
 int VoiceAssistant::read_microphone_() {
   size_t bytes_read = 0;
+  if (this->opus_restart_) {
+    // the encoder starts a new packet stream with the microphone, the complete packets buffered are kept
+    if (this->mic_->is_running()) {
+      this->mic_->stop();
+    } else if (this->mic_->is_stopped()) {
+      this->opus_header_fill_ = 0;
+      this->opus_restart_ = false;
+      this->mic_->start();
+    }
+    return 0;
+  }
   if (this->mic_->is_running()) {  // Read audio into input buffer
     bytes_read = this->mic_->read(this->input_buffer_, INPUT_BUFFER_SIZE * sizeof(int16_t));
     if (bytes_read == 0) {
@@ -122,7 +213,11 @@ int VoiceAssistant::read_microphone_() {
       return 0;
     }
     // Write audio into ring buffer
-    this->ring_buffer_->write((void *) this->input_buffer_, bytes_read);
+    if (this->use_opus_) {
+      this->write_opus_packets_((const uint8_t *) this->input_buffer_, bytes_read);
+    } else {
+      this->ring_buffer_->write((void *) this->input_buffer_, bytes_read);
+    }
   } else {
     ESP_LOGD(TAG, "microphone not running");
   }
@@ -170,7 +265,10 @@ void VoiceAssistant::loop() {
     case State::IDLE: {
       if (this->continuous_ && this->desired_state_ == State::IDLE) {
         this->idle_trigger_->trigger();
-        this->ring_buffer_->reset();
+        this->reset_ring_buffer_();
+        if (this->use_wake_word_ && this->local_wake_word_) {
+          this->set_state_(State::START_MICROPHONE, State::WAIT_FOR_WAKE_WORD);
+        } else
 #ifdef USE_ESP_ADF_VAD
         if (this->use_wake_word_ && this->vad_threshold_ > 0) {
           this->set_state_(State::START_MICROPHONE, State::WAIT_FOR_VAD);
@@ -188,7 +286,18 @@ void VoiceAssistant::loop() {
       ESP_LOGD(TAG, "Starting Microphone");
       memset(this->send_buffer_, 0, SEND_BUFFER_SIZE);
       memset(this->input_buffer_, 0, INPUT_BUFFER_SIZE * sizeof(int16_t));
-      this->ring_buffer_->reset();
+      this->reset_ring_buffer_();
+      // the encoder starts a new packet stream with the microphone
+      this->opus_header_fill_ = 0;
+      this->opus_restart_ = false;
+      // Opus only once the server has accepted it, the VAD needs uncompressed audio
+      this->use_opus_ = this->opus_frame_duration_ms_ > 0 && this->opus_accepted_;
+#ifdef USE_ESP_ADF_VAD
+      if (this->desired_state_ == State::WAIT_FOR_VAD) {
+        this->use_opus_ = false;
+      }
+#endif
+      this->opus_audio_callback_.call(this->use_opus_);
       this->mic_->start();
       this->high_freq_.start();
       prior_invoke = millis();
@@ -241,6 +350,38 @@ void VoiceAssistant::loop() {
       break;
     }
 #endif
+    case State::WAIT_FOR_WAKE_WORD: {
+      this->local_wake_word_detected_ = false;
+      ESP_LOGD(TAG, "Waiting for wake word...");
+      this->set_state_(State::WAITING_FOR_WAKE_WORD);
+      break;
+    }
+    case State::WAITING_FOR_WAKE_WORD: {
+      // the ring buffer drops the oldest audio when it is full, so it holds the latest audio as pre-roll
+      this->read_microphone_();
+      if (this->local_wake_word_detected_) {
+        this->local_wake_word_detected_ = false;
+        if (this->use_opus_) {
+          const size_t pre_roll_packets = this->wake_word_pre_roll_ms_ / this->opus_frame_duration_ms_;
+          while (this->opus_packets_buffered_ > pre_roll_packets) {
+            this->read_opus_packet_();
+          }
+          this->set_state_(State::START_PIPELINE, State::STREAMING_MICROPHONE);
+          break;
+        }
+        const size_t pre_roll_bytes = this->wake_word_pre_roll_ms_ * SAMPLE_RATE_HZ / 1000 * sizeof(int16_t);
+        size_t available = this->ring_buffer_->available();
+        while (available > pre_roll_bytes) {
+          size_t to_discard = std::min(available - pre_roll_bytes, SEND_BUFFER_SIZE);
+          if (this->ring_buffer_->read((void *) this->send_buffer_, to_discard, 0) == 0) {
+            break;
+          }
+          available = this->ring_buffer_->available();
+        }
+        this->set_state_(State::START_PIPELINE, State::STREAMING_MICROPHONE);
+      }
+      break;
+    }
     case State::START_PIPELINE: {
       this->read_microphone_();
       ESP_LOGD(TAG, "Requesting start...");
@@ -249,9 +390,18 @@ void VoiceAssistant::loop() {
         flags |= api::enums::VOICE_ASSISTANT_REQUEST_USE_WAKE_WORD;
       if (this->silence_detection_)
         flags |= api::enums::VOICE_ASSISTANT_REQUEST_USE_VAD;
+      if (this->opus_frame_duration_ms_ > 0)
+        flags |= LOCAL_REQUEST_FLAG_OPUS_SUPPORTED;
+      if (this->use_opus_)
+        flags |= LOCAL_REQUEST_FLAG_OPUS_AUDIO;
       api::VoiceAssistantAudioSettings audio_settings;
-      audio_settings.noise_suppression_level = this->noise_suppression_level_;
-      audio_settings.auto_gain = this->auto_gain_;
+      if (this->on_device_processing_) {
+        audio_settings.noise_suppression_level = 0;
+        audio_settings.auto_gain = 0;
+      } else {
+        audio_settings.noise_suppression_level = this->noise_suppression_level_;
+        audio_settings.auto_gain = this->auto_gain_;
+      }
       audio_settings.volume_multiplier = this->volume_multiplier_;
 
       api::VoiceAssistantRequest msg;
@@ -277,6 +427,17 @@ void VoiceAssistant::loop() {
     }
     case State::STREAMING_MICROPHONE: {
       this->read_microphone_();
+      if (this->use_opus_) {
+        while (this->opus_packets_buffered_ > 0) {
+          size_t packet_len = this->read_opus_packet_();
+          if (packet_len == 0) {
+            break;
+          }
+          this->socket_->sendto(this->send_buffer_, packet_len, 0, (struct sockaddr *) &this->dest_addr_,
+                                sizeof(this->dest_addr_));
+        }
+        break;
+      }
       size_t available = this->ring_buffer_->available();
       while (available >= SEND_BUFFER_SIZE) {
         size_t read_bytes = this->ring_buffer_->read((void *) this->send_buffer_, SEND_BUFFER_SIZE, 0);
@@ -402,6 +563,7 @@ void VoiceAssistant::client_subscription(api::APIConnection *client, bool subscr
       return;
     }
     this->api_client_ = nullptr;
+    this->opus_accepted_ = false;
     this->client_disconnected_trigger_->trigger();
     return;
   }
@@ -414,6 +576,7 @@ void VoiceAssistant::client_subscription(api::APIConnection *client, bool subscr
   }
 
   this->api_client_ = client;
+  this->opus_accepted_ = false;
   this->client_connected_trigger_->trigger();
 }
 
@@ -429,6 +592,10 @@ static const LogString *voice_assistant_state_to_string(State state) {
       return LOG_STR("WAIT_FOR_VAD");
     case State::WAITING_FOR_VAD:
       return LOG_STR("WAITING_FOR_VAD");
+    case State::WAIT_FOR_WAKE_WORD:
+      return LOG_STR("WAIT_FOR_WAKE_WORD");
+    case State::WAITING_FOR_WAKE_WORD:
+      return LOG_STR("WAITING_FOR_WAKE_WORD");
     case State::START_PIPELINE:
       return LOG_STR("START_PIPELINE");
     case State::STARTING_PIPELINE:
@@ -508,7 +675,10 @@ void VoiceAssistant::request_start(bool continuous, bool silence_detection) {
   if (this->state_ == State::IDLE) {
     this->continuous_ = continuous;
     this->silence_detection_ = silence_detection;
-    this->ring_buffer_->reset();
+    this->reset_ring_buffer_();
+    if (this->use_wake_word_ && this->local_wake_word_) {
+      this->set_state_(State::START_MICROPHONE, State::WAIT_FOR_WAKE_WORD);
+    } else
 #ifdef USE_ESP_ADF_VAD
     if (this->use_wake_word_ && vad_threshold_ > 0) {
       this->set_state_(State::START_MICROPHONE, State::WAIT_FOR_VAD);
@@ -530,6 +700,8 @@ void VoiceAssistant::request_stop() {
     case State::STARTING_MICROPHONE:
     case State::WAIT_FOR_VAD:
     case State::WAITING_FOR_VAD:
+    case State::WAIT_FOR_WAKE_WORD:
+    case State::WAITING_FOR_WAKE_WORD:
     case State::START_PIPELINE:
       this->set_state_(State::STOP_MICROPHONE, State::IDLE);
       break;
@@ -549,6 +721,14 @@ void VoiceAssistant::request_stop() {
   }
 }
 
+void VoiceAssistant::on_wake_word_detected(const std::string &wake_word) {
+  if (this->state_ != State::WAITING_FOR_WAKE_WORD) {
+    return;
+  }
+  ESP_LOGD(TAG, "Wake word '%s' detected on device", wake_word.c_str());
+  this->local_wake_word_detected_ = true;
+}
+
 void VoiceAssistant::signal_stop_() {
   memset(&this->dest_addr_, 0, sizeof(this->dest_addr_));
   if (this->api_client_ == nullptr) {
@@ -565,6 +745,15 @@ void VoiceAssistant::on_event(const api::VoiceAssistantEventResponse &msg) {
   switch (msg.event_type) {
     case api::enums::VOICE_ASSISTANT_RUN_START:
       ESP_LOGD(TAG, "Assist Pipeline running");
+      if (this->opus_frame_duration_ms_ > 0) {
+        for (auto arg : msg.data) {
+          if (arg.name == "audio_format" && arg.value == "opus" && !this->opus_accepted_) {
+            // takes effect with the next start of the microphone, the current run stays uncompressed
+            ESP_LOGD(TAG, "Server accepts Opus audio");
+            this->opus_accepted_ = true;
+          }
+        }
+      }
       this->defer([this]() { this->start_trigger_->trigger(); });
       break;
     case api::enums::VOICE_ASSISTANT_WAKE_WORD_START:
@@ -661,7 +850,10 @@ void VoiceAssistant::on_event(const api::VoiceAssistantEventResponse &msg) {
       ESP_LOGD(TAG, "Assist Pipeline ended");
       ESP_LOGD(TAG, "Current State: %s", LOG_STR_ARG(voice_assistant_state_to_string(this->state_)) );
       if (this->state_ == State::STREAMING_MICROPHONE) {
-        this->ring_buffer_->reset();
+        this->reset_ring_buffer_();
+        if (this->use_wake_word_ && this->local_wake_word_) {
+          this->set_state_(State::WAIT_FOR_WAKE_WORD, State::WAITING_FOR_WAKE_WORD);
+        } else
 #ifdef USE_ESP_ADF_VAD
         if (this->use_wake_word_ && vad_threshold_ > 0) {
           // No need to stop the microphone since we didn't use the speaker
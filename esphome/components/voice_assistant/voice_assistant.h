@@ -33,12 +33,28 @@ namespace voice_assistant {
 static const uint32_t INITIAL_VERSION = 1;
 static const uint32_t SPEAKER_SUPPORT = 2;
 
+// Local request flags, not part of the API's VoiceAssistantRequestFlag. They are sent in the bits above the
+// API's flags, servers which don't know them ignore them.
+// The device can send Opus compressed microphone audio, one packet per datagram. A server supporting it
+// accepts with `audio_format: opus` in the data of the run start event.
+static const uint32_t LOCAL_REQUEST_FLAG_OPUS_SUPPORTED = 1 << 2;
+// The audio of this run is Opus, only set once the server has accepted it on the current connection.
+static const uint32_t LOCAL_REQUEST_FLAG_OPUS_AUDIO = 1 << 3;
+static const uint32_t LOCAL_REQUEST_FLAGS = LOCAL_REQUEST_FLAG_OPUS_SUPPORTED | LOCAL_REQUEST_FLAG_OPUS_AUDIO;
+// The flags of the API the local ones are checked against, new flags of the API have to be added here.
+static const uint32_t API_REQUEST_FLAGS =
+    api::enums::VOICE_ASSISTANT_REQUEST_USE_VAD | api::enums::VOICE_ASSISTANT_REQUEST_USE_WAKE_WORD;
+static_assert((LOCAL_REQUEST_FLAGS & API_REQUEST_FLAGS) == 0 && LOCAL_REQUEST_FLAGS > API_REQUEST_FLAGS,
+              "the local request flags collide with the API's VoiceAssistantRequestFlag");
+
 enum class State {
   IDLE,
   START_MICROPHONE,
   STARTING_MICROPHONE,
   WAIT_FOR_VAD,
   WAITING_FOR_VAD,
+  WAIT_FOR_WAKE_WORD,
+  WAITING_FOR_WAKE_WORD,
   START_PIPELINE,
   STARTING_PIPELINE,
   STREAMING_MICROPHONE,
@@ -90,6 +106,17 @@ class VoiceAssistant : public Component {
   bool is_continuous() const { return this->continuous_; }
 
   void set_use_wake_word(bool use_wake_word) { this->use_wake_word_ = use_wake_word; }
+  // the wake word is detected by the microphone pipeline, audio is only streamed after a detection
+  void set_local_wake_word(bool local_wake_word) { this->local_wake_word_ = local_wake_word; }
+  // audio sent from before the detection, so the server can verify the wake word
+  void set_wake_word_pre_roll(uint32_t pre_roll_ms) { this->wake_word_pre_roll_ms_ = pre_roll_ms; }
+  void on_wake_word_detected(const std::string &wake_word);
+  // the microphone delivers length prefixed Opus packets of this duration instead of 16 bit samples
+  void set_opus_frame_duration(uint32_t frame_duration_ms) { this->opus_frame_duration_ms_ = frame_duration_ms; }
+  // called before the microphone starts, true if the encoder has to compress, false if it has to pass PCM
+  void add_on_opus_audio_callback(std::function<void(bool)> &&callback) {
+    this->opus_audio_callback_.add(std::move(callback));
+  }
 #ifdef USE_ESP_ADF_VAD
   void set_vad_threshold(uint8_t vad_threshold) { this->vad_threshold_ = vad_threshold; }
 #endif
@@ -99,6 +126,8 @@ class VoiceAssistant : public Component {
   }
   void set_auto_gain(uint8_t auto_gain) { this->auto_gain_ = auto_gain; }
   void set_volume_multiplier(float volume_multiplier) { this->volume_multiplier_ = volume_multiplier; }
+  // noise suppression and auto gain are done by the microphone pipeline, the server must not apply them again
+  void set_on_device_processing(bool on_device_processing) { this->on_device_processing_ = on_device_processing; }
 
   Trigger<> *get_intent_end_trigger() const { return this->intent_end_trigger_; }
   Trigger<> *get_intent_start_trigger() const { return this->intent_start_trigger_; }
@@ -126,6 +155,12 @@ class VoiceAssistant : public Component {
 
  protected:
   int read_microphone_();
+  void reset_ring_buffer_();
+  // restores the packets from the microphone's byte stream, whole packets are kept in the ring buffer
+  void write_opus_packets_(const uint8_t *data, size_t len);
+  // reads the oldest packet from the ring buffer into the send buffer, returns its length, or 0 if there is
+  // none or it is incomplete, which also drops the buffered packets
+  size_t read_opus_packet_();
 #ifdef USE_ESP_ADF_VAD
   int read_microphone_vad_(size_t request_samples);
 #endif
@@ -190,10 +225,30 @@ class VoiceAssistant : public Component {
 
   std::unique_ptr<RingBuffer> ring_buffer_;
 
+  bool local_wake_word_{false};
+  bool local_wake_word_detected_{false};
+  uint32_t wake_word_pre_roll_ms_{1000};
+
+  uint32_t opus_frame_duration_ms_{0};
+  CallbackManager<void(bool)> opus_audio_callback_;
+  // the server of the current connection has accepted Opus audio
+  bool opus_accepted_{false};
+  // the microphone delivers Opus packets in the current run
+  bool use_opus_{false};
+  uint8_t *opus_packet_{nullptr};
+  uint8_t opus_header_[2];
+  size_t opus_header_fill_{0};
+  size_t opus_packet_len_{0};
+  size_t opus_packet_fill_{0};
+  size_t opus_packets_buffered_{0};
+  // set if the packet boundaries got lost, the microphone is restarted
+  bool opus_restart_{false};
+
   bool use_wake_word_;
   uint8_t noise_suppression_level_;
   uint8_t auto_gain_;
   float volume_multiplier_;
+  bool on_device_processing_{false};
 
   uint8_t *send_buffer_;
   int16_t *input_buffer_;
@@ -0,0 +1,267 @@
+/*
+Micro benchmark of the kernels, prints ns per sample for blocks of the size the pipeline
+elements process. Host timings only indicate relative costs, the numbers that matter are the
+cycles per frame the elements log on the ESP32 when they are closed.
+
+  bench_audio_kernels [rounds]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_kernels.h"
+
+// samples per block, a 2 KiB buffer of 16 bit stereo
+#define BLOCK 1024
+
+static int16_t buf16[BLOCK], src16[BLOCK], planes16[BLOCK];
+static int32_t buf32[BLOCK], src32[BLOCK], planes32[BLOCK];
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+Copy loop of i2s_write_expand in the legacy ESP-IDF I2S driver, which widens 16 bit samples while
+copying them to DMA: every sample gets its zero bytes and its data bytes copied separately.
+*/
+static void idf_write_expand_model(uint8_t *dst, const uint8_t *src, size_t num_samples, int src_bytes,
+                                   int dst_bytes) {
+  const int zero_bytes = dst_bytes - src_bytes;
+  for (size_t i = 0; i < num_samples; i++) {
+    memset(dst, 0, zero_bytes);
+    dst += zero_bytes;
+    memcpy(dst, src, src_bytes);
+    dst += src_bytes;
+    src += src_bytes;
+  }
+}
+
+/*
+Stand-in for alc_volume_setup_process of the ESP-ADF, which the gain element replaced. The library
+is closed source and only built for Xtensa, so this models its per-sample work: a Q14 gain from a dB
+table and a peak limiter that pulls the gain down when the output would clip.
+*/
+struct alc_model {
+  int16_t gain;
+  int32_t limit;
+};
+
+static void alc_model_process(int16_t *samples, size_t num_samples, struct alc_model *alc) {
+  const int32_t threshold = 29000;
+  int32_t limit = alc->limit;
+  for (size_t i = 0; i < num_samples; i++) {
+    int32_t y = ((int32_t) samples[i] * alc->gain) >> 14;
+    y = (int32_t) (((int64_t) y * limit) >> 15);
+    const int32_t peak = y < 0 ? -y : y;
+    if (peak > threshold) {
+      // fast attack, the sample itself is clipped
+      limit -= limit >> 4;
+      y = y < 0 ? -threshold : threshold;
+    } else if (limit < 32768) {
+      limit += 1;
+    }
+    samples[i] = (int16_t) y;
+  }
+  alc->limit = limit;
+}
+
+// keeps the compiler from dropping the benchmarked calls
+static volatile int32_t sink;
+
+static void report(const char *name, double start, long rounds) {
+  const double ns = (now_ns() - start) / ((double) rounds * BLOCK);
+  sink += buf16[rounds % BLOCK] + buf32[rounds % BLOCK];
+  printf("%-18s %6.2f ns/sample\n", name, ns);
+}
+
+int main(int argc, char **argv) {
+  const long rounds = argc > 1 ? atol(argv[1]) : 100000;
+  for (int i = 0; i < BLOCK; i++) {
+    src16[i] = (int16_t) (i * 7919);
+    src32[i] = (int32_t) ((uint32_t) i * 2654435761u);
+  }
+  int16_t *p16[2] = {planes16, planes16 + BLOCK / 2};
+  int32_t *p32[2] = {planes32, planes32 + BLOCK / 2};
+  double start;
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_s32_to_s16(src32, buf16, BLOCK, 16);
+  }
+  report("s32_to_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_s16_to_s32(src16, buf32, BLOCK);
+  }
+  report("s16_to_s32", start, rounds);
+
+  // the I2S writer's copy path for 16 bit streams on a 32 bit bus: the samples pass through and are
+  // widened by the driver, or by a conversion element that writes them to its ring buffer
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    memcpy(buf16, src16, sizeof(buf16));
+  }
+  report("copy_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    memcpy(buf32, src32, sizeof(buf32));
+  }
+  report("copy_s32", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_s16_to_s32(src16, planes32, BLOCK);
+    memcpy(buf32, planes32, sizeof(buf32));
+  }
+  report("s16_to_s32 + copy", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    idf_write_expand_model((uint8_t *) buf32, (const uint8_t *) src16, BLOCK, 2, 4);
+  }
+  report("idf_expand_model", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_scale_s16(buf16, BLOCK, 0xC000, 16);
+  }
+  report("scale_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_scale_s32(buf32, BLOCK, 0xC000, 16);
+  }
+  report("scale_s32", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_mix_ramp_s16(buf16, src16, 1 << 15, 0, src16, 0, 1 << 15, BLOCK / 2, 2, 15);
+  }
+  report("mix_ramp_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_mix_ramp_s32(buf32, src32, 1 << 15, 0, src32, 0, 1 << 15, BLOCK / 2, 2, 15);
+  }
+  report("mix_ramp_s32", start, rounds);
+
+  // the level meter's per-block measurement
+  uint32_t peak = 0;
+  uint64_t sum_squares = 0;
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    sum_squares += audio_level_s16(src16, BLOCK, &peak);
+  }
+  report("level_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    sum_squares += audio_level_s32(src32, BLOCK, &peak);
+  }
+  report("level_s32", start, rounds);
+  sink += (int32_t) (sum_squares + peak);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_swap_pairs_s16(buf16, BLOCK);
+  }
+  report("swap_pairs_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_dac_scale_s16(buf16, BLOCK);
+  }
+  report("dac_scale_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_deinterleave_s16(p16, src16, BLOCK / 2, 2);
+  }
+  report("deinterleave_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_interleave_s16(buf16, (const int16_t *const *) p16, BLOCK / 2, 2);
+  }
+  report("interleave_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_deinterleave_s32(p32, src32, BLOCK / 2, 2);
+  }
+  report("deinterleave_s32", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_interleave_s32(buf32, (const int32_t *const *) p32, BLOCK / 2, 2);
+  }
+  report("interleave_s32", start, rounds);
+
+  // the gain element: a ramp over the whole block and the constant gain after it, vs. the ALC
+  memcpy(buf16, src16, sizeof(buf16));
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    int32_t gain = 1 << 23;
+    uint32_t remaining = BLOCK / 2;
+    audio_gain_ramp_s16(buf16, BLOCK / 2, 2, &gain, (1 << 23) / (BLOCK / 2), &remaining, 1 << 24, 24);
+  }
+  report("gain_ramp_s16", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_scale_s16(buf16, BLOCK, 0xB504F3, 24);
+  }
+  report("gain_const_s16", start, rounds);
+
+  struct alc_model alc = {.gain = 0x2D41, .limit = 32768};
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    alc_model_process(buf16, BLOCK, &alc);
+  }
+  report("alc_model_s16", start, rounds);
+
+  // 4 bands on stereo, the equalizer's Q27 format, a mild peaking filter keeps the values bounded
+  int32_t coeffs[4 * 5];
+  int32_t state[4 * 2 * 4] = {0};
+  for (int b = 0; b < 4; b++) {
+    const int32_t c[5] = {136000000, -260000000, 125000000, -260000000, 126000000};
+    for (int k = 0; k < 5; k++) {
+      coeffs[b * 5 + k] = c[k];
+    }
+  }
+  for (int i = 0; i < BLOCK; i++) {
+    buf32[i] = src32[i] >> 2;
+  }
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_biquad_cascade_s32(buf32, BLOCK / 2, 2, coeffs, state, 4, 27);
+  }
+  report("biquad x4 stereo", start, rounds);
+
+  // a 1 kHz sweep with attack and release at 16 kHz, the tone generator's synthesis
+  const audio_tone_t tone = {
+      .phase_inc = 268435456u,
+      .phase_inc_delta = 64,
+      .target = 0x4000 << 15,
+      .attack_delta = (0x4000 << 15) / 160,
+      .release_delta = (0x4000 << 15) / 160,
+      .length = BLOCK,
+      .attack_samples = 160,
+      .release_samples = 160,
+  };
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    audio_tone_t t = tone;
+    t.remaining = BLOCK;
+    audio_tone_render_s16(buf16, BLOCK, &t);
+  }
+  report("tone_s16", start, rounds);
+  return 0;
+}
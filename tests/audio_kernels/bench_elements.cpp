@@ -0,0 +1,112 @@
+/*
+Micro benchmark of the element cores which don't depend on the SDK, prints ns per frame for blocks
+of the size the pipeline elements process. Like bench_audio_kernels, host timings only indicate
+relative costs.
+
+  bench_elements [rounds]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "esphome/components/adf_pipeline/adf_channel_map.h"
+#include "esphome/components/adf_pipeline/adf_polyphase_resampler.h"
+
+using namespace esphome::esp_adf;
+
+// stereo frames per block, the resampler's input buffer of 16 bit samples
+static const size_t FRAMES = 512;
+
+static int16_t src[FRAMES * 2];
+static int16_t buf[FRAMES * 2];
+static int16_t out[FRAMES * 2];
+
+// keeps the compiler from dropping the benchmarked calls
+static volatile int32_t sink;
+
+static double now_ns() {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char *name, double start, long rounds) {
+  const double ns = (now_ns() - start) / ((double) rounds * FRAMES);
+  sink += buf[rounds % FRAMES] + out[rounds % FRAMES];
+  printf("%-24s %6.2f ns/frame\n", name, ns);
+}
+
+int main(int argc, char **argv) {
+  const long rounds = argc > 1 ? atol(argv[1]) : 20000;
+  for (size_t i = 0; i < FRAMES * 2; i++) {
+    src[i] = (int16_t) (i * 7919);
+  }
+  double start;
+
+  // the mic path: stereo I2S reader to the mono microphone sink at the same rate
+  ChannelMap left;
+  left.configure(ChannelMixMode::LEFT, {}, 2, 1);
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    std::copy(src, src + FRAMES * 2, buf);
+    left.apply<int16_t>(buf, FRAMES);
+  }
+  report("channel_map left 2->1", start, rounds);
+
+  ChannelMap average;
+  average.configure(ChannelMixMode::AVERAGE, {}, 2, 1);
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    std::copy(src, src + FRAMES * 2, buf);
+    average.apply<int16_t>(buf, FRAMES);
+  }
+  report("channel_map avg 2->1", start, rounds);
+
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    std::copy(src, src + FRAMES * 2, buf);
+  }
+  report("copy (baseline)", start, rounds);
+
+  /*
+  rsp_filter (esp_resample) is only shipped as an Xtensa library. Before the channel map, the mic
+  path ran the resampling filter at an unchanged rate, the polyphase resampler's low tier at 1:1 after
+  selecting the channel stands in for that filter pass.
+  */
+  PolyphaseResampler filter;
+  filter.configure(16000, 16000, 1, ResampleQuality::LOW, FRAMES);
+  start = now_ns();
+  for (long r = 0; r < rounds; r++) {
+    std::copy(src, src + FRAMES * 2, buf);
+    left.apply<int16_t>(buf, FRAMES);
+    filter.process(buf, FRAMES, out);
+  }
+  report("filter 1:1 + left 2->1", start, rounds);
+
+  // the quality tiers on mono
+  const struct {
+    ResampleQuality quality;
+    const char *name;
+  } tiers[] = {{ResampleQuality::LOW, "low"}, {ResampleQuality::MEDIUM, "medium"}, {ResampleQuality::HIGH, "high"}};
+  const int pairs[][2] = {{44100, 48000}, {48000, 16000}};
+  for (const auto &tier : tiers) {
+    for (const auto &pair : pairs) {
+      PolyphaseResampler rsp;
+      rsp.configure(pair[0], pair[1], 1, tier.quality, FRAMES);
+      std::vector<int16_t> dst(rsp.max_out_frames(FRAMES));
+      size_t out_frames = 0;
+      start = now_ns();
+      for (long r = 0; r < rounds; r++) {
+        out_frames += rsp.process(src, FRAMES, dst.data());
+      }
+      const double ns = (now_ns() - start) / (double) std::max<size_t>(1, out_frames);
+      sink += dst[0];
+      char name[32];
+      snprintf(name, sizeof(name), "%s %d->%d", tier.name, pair[0], pair[1]);
+      printf("%-24s %6.2f ns/out frame\n", name, ns);
+    }
+  }
+  return 0;
+}
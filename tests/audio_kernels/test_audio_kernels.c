@@ -0,0 +1,336 @@
+/*
+Checks the kernels against straightforward reference loops on random input, including the
+unaligned tails of the unrolled loops and in place use. Exits with 1 on the first mismatch.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_kernels.h"
+
+#define MAX_SAMPLES 1031
+#define ROUNDS 200
+
+static int failures = 0;
+
+#define CHECK(cond, ...) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+      fprintf(stderr, __VA_ARGS__); \
+      fprintf(stderr, "\n"); \
+      failures++; \
+      return; \
+    } \
+  } while (0)
+
+static uint32_t rng_state = 0x12345678;
+
+static uint32_t rand_u32(void) {
+  // xorshift32, deterministic on every host
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static void fill_s16(int16_t *buf, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    buf[i] = (int16_t) rand_u32();
+  }
+  // the extremes are where saturation goes wrong
+  if (n > 1) {
+    buf[0] = INT16_MAX;
+    buf[1] = INT16_MIN;
+  }
+}
+
+static void fill_s32(int32_t *buf, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    buf[i] = (int32_t) rand_u32();
+  }
+  if (n > 1) {
+    buf[0] = INT32_MAX;
+    buf[1] = INT32_MIN;
+  }
+}
+
+static int64_t clamp(int64_t v, int64_t lo, int64_t hi) { return v < lo ? lo : v > hi ? hi : v; }
+
+static void test_s32_to_s16(size_t n) {
+  int32_t src[MAX_SAMPLES] = {0};
+  int16_t dst[MAX_SAMPLES];
+  int32_t inplace[MAX_SAMPLES];
+  fill_s32(src, n);
+  const int shift = 12 + (int) (rand_u32() % 5);
+  memcpy(inplace, src, n * sizeof(int32_t));
+  audio_s32_to_s16(src, dst, n, shift);
+  audio_s32_to_s16(inplace, (int16_t *) inplace, n, shift);
+  for (size_t i = 0; i < n; i++) {
+    const int16_t ref = (int16_t) clamp(src[i] >> shift, INT16_MIN, INT16_MAX);
+    CHECK(dst[i] == ref, "s32_to_s16 n=%zu i=%zu: %d != %d", n, i, dst[i], ref);
+    CHECK(((int16_t *) inplace)[i] == ref, "s32_to_s16 in place n=%zu i=%zu", n, i);
+  }
+}
+
+static void test_s16_to_s32(size_t n) {
+  int16_t src[MAX_SAMPLES] = {0};
+  int32_t dst[MAX_SAMPLES];
+  int32_t inplace[MAX_SAMPLES];
+  fill_s16(src, n);
+  memcpy(inplace, src, n * sizeof(int16_t));
+  audio_s16_to_s32(src, dst, n);
+  audio_s16_to_s32((int16_t *) inplace, inplace, n);
+  for (size_t i = 0; i < n; i++) {
+    const int32_t ref = (int32_t) src[i] * 65536;
+    CHECK(dst[i] == ref, "s16_to_s32 n=%zu i=%zu", n, i);
+    CHECK(inplace[i] == ref, "s16_to_s32 in place n=%zu i=%zu", n, i);
+  }
+}
+
+static void test_scale(size_t n) {
+  int16_t s16[MAX_SAMPLES], ref16[MAX_SAMPLES];
+  int32_t s32[MAX_SAMPLES], ref32[MAX_SAMPLES];
+  fill_s16(s16, n);
+  fill_s32(s32, n);
+  memcpy(ref16, s16, sizeof(s16));
+  memcpy(ref32, s32, sizeof(s32));
+  const int shift = 16;
+  const int32_t gain = (int32_t) (rand_u32() % (4 << shift));
+  audio_scale_s16(s16, n, gain, shift);
+  audio_scale_s32(s32, n, gain, shift);
+  for (size_t i = 0; i < n; i++) {
+    const int16_t r16 = (int16_t) clamp(((int64_t) ref16[i] * gain) >> shift, INT16_MIN, INT16_MAX);
+    const int32_t r32 = (int32_t) clamp(((int64_t) ref32[i] * gain) >> shift, INT32_MIN, INT32_MAX);
+    CHECK(s16[i] == r16, "scale_s16 n=%zu i=%zu gain=%d", n, i, gain);
+    CHECK(s32[i] == r32, "scale_s32 n=%zu i=%zu gain=%d", n, i, gain);
+  }
+}
+
+static void test_gain_ramp(size_t n) {
+  const int channels = 1 + (int) (rand_u32() % 4);
+  const size_t frames = n / channels;
+  int16_t s16[MAX_SAMPLES], ref16[MAX_SAMPLES];
+  int32_t s32[MAX_SAMPLES], ref32[MAX_SAMPLES];
+  fill_s16(s16, n);
+  fill_s32(s32, n);
+  memcpy(ref16, s16, sizeof(s16));
+  memcpy(ref32, s32, sizeof(s32));
+  const int shift = 24;
+  const int32_t from = (int32_t) (rand_u32() % (2 << shift));
+  const int32_t target = (int32_t) (rand_u32() % (2 << shift));
+  // the ramp may end inside the block, the rest is left alone
+  const uint32_t length = 1 + rand_u32() % (frames + 1);
+  const int32_t step = (target - from) / (int32_t) length;
+  int32_t gain16 = from, gain32 = from;
+  uint32_t left16 = length, left32 = length;
+  const size_t done16 = audio_gain_ramp_s16(s16, frames, channels, &gain16, step, &left16, target, shift);
+  const size_t done32 = audio_gain_ramp_s32(s32, frames, channels, &gain32, step, &left32, target, shift);
+  const size_t expected = length < frames ? length : frames;
+  CHECK(done16 == expected && done32 == expected, "gain_ramp frames %zu, %zu != %zu", done16, done32, expected);
+  CHECK(left16 == length - expected && left32 == length - expected, "gain_ramp remaining");
+  int64_t gain = from;
+  for (size_t f = 0; f < frames; f++) {
+    if (f < expected) {
+      gain = f + 1 == length ? target : gain + step;
+    }
+    for (int ch = 0; ch < channels; ch++) {
+      const size_t i = f * channels + ch;
+      const int16_t r16 = f < expected ? (int16_t) clamp((ref16[i] * gain) >> shift, INT16_MIN, INT16_MAX) : ref16[i];
+      const int32_t r32 = f < expected ? (int32_t) clamp((ref32[i] * gain) >> shift, INT32_MIN, INT32_MAX) : ref32[i];
+      CHECK(s16[i] == r16, "gain_ramp_s16 f=%zu ch=%d", f, ch);
+      CHECK(s32[i] == r32, "gain_ramp_s32 f=%zu ch=%d", f, ch);
+    }
+  }
+  CHECK(expected == 0 || gain16 == (int32_t) gain, "gain_ramp gain %d != %lld", gain16, (long long) gain);
+}
+
+static void test_mix_ramp(size_t n) {
+  const int channels = 1 + (int) (rand_u32() % 4);
+  const size_t frames = n / channels;
+  int16_t a16[MAX_SAMPLES], b16[MAX_SAMPLES], d16[MAX_SAMPLES];
+  int32_t a32[MAX_SAMPLES], b32[MAX_SAMPLES], d32[MAX_SAMPLES];
+  fill_s16(a16, n);
+  fill_s16(b16, n);
+  fill_s32(a32, n);
+  fill_s32(b32, n);
+  const int shift = 15;
+  const int32_t a_from = 1 << shift, a_to = 0, b_from = 0, b_to = 1 << shift;
+  const int use_b = rand_u32() & 1;
+  audio_mix_ramp_s16(d16, a16, a_from, a_to, use_b ? b16 : NULL, b_from, b_to, frames, channels, shift);
+  audio_mix_ramp_s32(d32, a32, a_from, a_to, use_b ? b32 : NULL, b_from, b_to, frames, channels, shift);
+  if (frames == 0) {
+    return;
+  }
+  const int32_t a_step = (a_to - a_from) / (int32_t) frames;
+  const int32_t b_step = (b_to - b_from) / (int32_t) frames;
+  for (size_t f = 0; f < frames; f++) {
+    const int64_t ga = a_from + (int64_t) a_step * f;
+    const int64_t gb = b_from + (int64_t) b_step * f;
+    for (int ch = 0; ch < channels; ch++) {
+      const size_t i = f * channels + ch;
+      const int64_t v16 = a16[i] * ga + (use_b ? b16[i] * gb : 0);
+      const int64_t v32 = a32[i] * ga + (use_b ? b32[i] * gb : 0);
+      CHECK(d16[i] == (int16_t) clamp(v16 >> shift, INT16_MIN, INT16_MAX), "mix_ramp_s16 f=%zu ch=%d", f, ch);
+      CHECK(d32[i] == (int32_t) clamp(v32 >> shift, INT32_MIN, INT32_MAX), "mix_ramp_s32 f=%zu ch=%d", f, ch);
+    }
+  }
+}
+
+static void test_level(size_t n) {
+  int16_t s16[MAX_SAMPLES] = {0};
+  int32_t s32[MAX_SAMPLES] = {0};
+  fill_s16(s16, n);
+  fill_s32(s32, n);
+  // the peak only rises, start from something in between
+  const uint32_t start = rand_u32() >> 1;
+  uint32_t peak16 = start, peak32 = start;
+  const uint64_t sum16 = audio_level_s16(s16, n, &peak16);
+  const uint64_t sum32 = audio_level_s32(s32, n, &peak32);
+  uint64_t ref_sum16 = 0, ref_sum32 = 0;
+  uint32_t ref_peak16 = start, ref_peak32 = start;
+  for (size_t i = 0; i < n; i++) {
+    ref_sum16 += (uint64_t) ((int64_t) s16[i] * s16[i]);
+    ref_sum32 += (uint64_t) ((int64_t) (s32[i] >> 16) * (s32[i] >> 16));
+    const uint32_t mag16 = (uint32_t) (s16[i] < 0 ? -(int64_t) s16[i] : s16[i]) << 16;
+    const uint32_t mag32 = (uint32_t) (s32[i] < 0 ? -(int64_t) s32[i] : s32[i]);
+    ref_peak16 = mag16 > ref_peak16 ? mag16 : ref_peak16;
+    ref_peak32 = mag32 > ref_peak32 ? mag32 : ref_peak32;
+  }
+  CHECK(sum16 == ref_sum16 && peak16 == ref_peak16, "level_s16 n=%zu", n);
+  CHECK(sum32 == ref_sum32 && peak32 == ref_peak32, "level_s32 n=%zu", n);
+}
+
+static void test_swap_and_dac(size_t n) {
+  int16_t s16[MAX_SAMPLES], ref16[MAX_SAMPLES];
+  int32_t s32[MAX_SAMPLES], ref32[MAX_SAMPLES];
+  fill_s16(ref16, n);
+  fill_s32(ref32, n);
+  memcpy(s16, ref16, sizeof(s16));
+  memcpy(s32, ref32, sizeof(s32));
+  audio_swap_pairs_s16(s16, n);
+  audio_swap_pairs_s32(s32, n);
+  for (size_t i = 0; i < n; i++) {
+    const size_t j = (i + 1 < n || i % 2 == 1) ? (i ^ 1) : i;
+    CHECK(s16[i] == ref16[j], "swap_pairs_s16 n=%zu i=%zu", n, i);
+    CHECK(s32[i] == ref32[j], "swap_pairs_s32 n=%zu i=%zu", n, i);
+  }
+
+  memcpy(s16, ref16, sizeof(s16));
+  memcpy(s32, ref32, sizeof(s32));
+  audio_dac_scale_s16(s16, n);
+  audio_dac_scale_s32(s32, n);
+  for (size_t i = 0; i < n; i++) {
+    // the upper byte, offset to unsigned
+    const uint16_t r16 = (uint16_t) (((ref16[i] >> 8) + 128) << 8);
+    const uint32_t r32 = (uint32_t) ((ref32[i] >> 24) + 128) << 24;
+    CHECK((uint16_t) s16[i] == r16, "dac_scale_s16 i=%zu", i);
+    CHECK((uint32_t) s32[i] == r32, "dac_scale_s32 i=%zu", i);
+  }
+}
+
+static void test_interleave(size_t n) {
+  const int channels = 1 + (int) (rand_u32() % 8);
+  const size_t frames = n / channels;
+  int16_t i16[MAX_SAMPLES] = {0}, p16[MAX_SAMPLES], o16[MAX_SAMPLES];
+  int32_t i32[MAX_SAMPLES] = {0}, p32[MAX_SAMPLES], o32[MAX_SAMPLES];
+  int16_t *planes16[8];
+  int32_t *planes32[8];
+  for (int ch = 0; ch < channels; ch++) {
+    planes16[ch] = p16 + ch * frames;
+    planes32[ch] = p32 + ch * frames;
+  }
+  fill_s16(i16, n);
+  fill_s32(i32, n);
+  audio_deinterleave_s16(planes16, i16, frames, channels);
+  audio_deinterleave_s32(planes32, i32, frames, channels);
+  for (size_t f = 0; f < frames; f++) {
+    for (int ch = 0; ch < channels; ch++) {
+      CHECK(planes16[ch][f] == i16[f * channels + ch], "deinterleave_s16 channels=%d f=%zu", channels, f);
+      CHECK(planes32[ch][f] == i32[f * channels + ch], "deinterleave_s32 channels=%d f=%zu", channels, f);
+    }
+  }
+  audio_interleave_s16(o16, (const int16_t *const *) planes16, frames, channels);
+  audio_interleave_s32(o32, (const int32_t *const *) planes32, frames, channels);
+  CHECK(memcmp(o16, i16, frames * channels * sizeof(int16_t)) == 0, "interleave_s16 channels=%d", channels);
+  CHECK(memcmp(o32, i32, frames * channels * sizeof(int32_t)) == 0, "interleave_s32 channels=%d", channels);
+}
+
+static audio_tone_t make_tone(uint32_t freq, uint32_t rate, uint32_t length, uint32_t attack, uint32_t release) {
+  audio_tone_t tone = {0};
+  tone.phase_inc = (uint32_t) (((uint64_t) freq << 32) / rate);
+  tone.length = length;
+  tone.remaining = length;
+  tone.target = 0x7FFF << 15;
+  tone.attack_samples = attack;
+  tone.release_samples = release;
+  tone.attack_delta = attack ? tone.target / (int32_t) attack : 0;
+  tone.release_delta = release ? tone.target / (int32_t) release : 0;
+  tone.envelope = attack ? 0 : tone.target;
+  return tone;
+}
+
+static void test_tone(void) {
+  enum { LENGTH = 4000 };
+  static int16_t whole[LENGTH], blocks[LENGTH];
+
+  // a steady tone is within a few LSB of the exact sine, the table is interpolated linearly
+  audio_tone_t tone = make_tone(1000, 16000, LENGTH, 0, 0);
+  CHECK(audio_tone_render_s16(whole, LENGTH + 100, &tone) == LENGTH, "tone renders beyond the step");
+  CHECK(tone.remaining == 0, "tone remaining %u", tone.remaining);
+  for (size_t i = 0; i < LENGTH; i++) {
+    const double ref = 32767. * 32767. / 32768. * sin(2. * 3.14159265358979323846 * 1000. * i / 16000.);
+    CHECK(fabs(whole[i] - ref) <= 4., "tone i=%zu: %d != %.1f", i, whole[i], ref);
+  }
+
+  // the state carries over between blocks, a sweep with envelope renders the same in any split
+  tone = make_tone(200, 16000, LENGTH, 400, 800);
+  tone.phase_inc_delta = (int32_t) (((int64_t) tone.phase_inc * 20 - tone.phase_inc) / LENGTH);
+  audio_tone_t split = tone;
+  audio_tone_render_s16(whole, LENGTH, &tone);
+  size_t done = 0;
+  while (split.remaining > 0) {
+    done += audio_tone_render_s16(blocks + done, 1 + rand_u32() % 300, &split);
+  }
+  CHECK(done == LENGTH, "tone split rendered %zu", done);
+  CHECK(memcmp(whole, blocks, sizeof(whole)) == 0, "tone differs when rendered in blocks");
+  CHECK(tone.envelope == 0, "tone envelope %d after the release", tone.envelope);
+  CHECK(abs(whole[0]) <= 1 && abs(whole[LENGTH - 1]) <= 64, "tone not faded: %d, %d", whole[0], whole[LENGTH - 1]);
+}
+
+static void test_silence(void) {
+  uint8_t buf[17];
+  audio_silence(buf, sizeof(buf), false);
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    CHECK(buf[i] == 0x00, "silence i=%zu", i);
+  }
+  audio_silence(buf, sizeof(buf), true);
+  for (size_t i = 0; i < sizeof(buf); i++) {
+    CHECK(buf[i] == 0x80, "silence builtin dac i=%zu", i);
+  }
+}
+
+int main(void) {
+  for (int round = 0; round < ROUNDS; round++) {
+    // small sizes hit the tails of the unrolled loops, large ones the main loop
+    const size_t n = round < 16 ? (size_t) round : 1 + rand_u32() % MAX_SAMPLES;
+    test_s32_to_s16(n);
+    test_s16_to_s32(n);
+    test_scale(n);
+    test_gain_ramp(n);
+    test_mix_ramp(n);
+    test_level(n);
+    test_swap_and_dac(n);
+    test_interleave(n);
+  }
+  test_tone();
+  test_silence();
+  if (failures > 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  printf("audio_kernels: all checks passed\n");
+  return 0;
+}
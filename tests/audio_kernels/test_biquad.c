@@ -0,0 +1,222 @@
+/*
+Checks audio_biquad_cascade_s32 against a double precision reference of the same cascade, in
+the format the equalizer uses it: Q27 coefficients from the RBJ cookbook and Q30 samples.
+Also checks that every lane matches a mono run of its channel bit for bit and that splitting
+the stream into blocks doesn't change the result.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_kernels.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define COEF_SHIFT 27
+#define RATE 48000
+#define FRAMES 4800
+#define MAX_CHANNELS 4
+#define NUM_BANDS 4
+// the error of the fixed point cascade has to stay below this level relative to full scale
+#define MIN_SNR_DB 100.
+
+static int failures = 0;
+
+enum { PEAKING, LOW_SHELF, HIGH_SHELF, LOW_PASS };
+
+struct band {
+  int type;
+  double frequency;
+  double gain_db;
+  double q;
+};
+
+static const struct band bands[NUM_BANDS] = {
+    {LOW_SHELF, 120., 6., 0.707},
+    {PEAKING, 1000., -9., 1.4},
+    {HIGH_SHELF, 8000., 4., 0.707},
+    {LOW_PASS, 16000., 0., 0.707},
+};
+
+// same as calc_coefficients in adf_equalizer.cpp, normalized by a0
+static void design(const struct band *band, double out[5]) {
+  const double w0 = 2. * M_PI * band->frequency / RATE;
+  const double cos_w0 = cos(w0);
+  const double alpha = sin(w0) / (2. * band->q);
+  const double a = pow(10., band->gain_db / 40.);
+  const double sqrt_a_alpha = 2. * sqrt(a) * alpha;
+  double b0, b1, b2, a0, a1, a2;
+  switch (band->type) {
+    case LOW_SHELF:
+      b0 = a * ((a + 1) - (a - 1) * cos_w0 + sqrt_a_alpha);
+      b1 = 2 * a * ((a - 1) - (a + 1) * cos_w0);
+      b2 = a * ((a + 1) - (a - 1) * cos_w0 - sqrt_a_alpha);
+      a0 = (a + 1) + (a - 1) * cos_w0 + sqrt_a_alpha;
+      a1 = -2 * ((a - 1) + (a + 1) * cos_w0);
+      a2 = (a + 1) + (a - 1) * cos_w0 - sqrt_a_alpha;
+      break;
+    case HIGH_SHELF:
+      b0 = a * ((a + 1) + (a - 1) * cos_w0 + sqrt_a_alpha);
+      b1 = -2 * a * ((a - 1) + (a + 1) * cos_w0);
+      b2 = a * ((a + 1) + (a - 1) * cos_w0 - sqrt_a_alpha);
+      a0 = (a + 1) - (a - 1) * cos_w0 + sqrt_a_alpha;
+      a1 = 2 * ((a - 1) - (a + 1) * cos_w0);
+      a2 = (a + 1) - (a - 1) * cos_w0 - sqrt_a_alpha;
+      break;
+    case LOW_PASS:
+      b0 = (1 - cos_w0) / 2;
+      b1 = 1 - cos_w0;
+      b2 = (1 - cos_w0) / 2;
+      a0 = 1 + alpha;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha;
+      break;
+    case PEAKING:
+    default:
+      b0 = 1 + alpha * a;
+      b1 = -2 * cos_w0;
+      b2 = 1 - alpha * a;
+      a0 = 1 + alpha / a;
+      a1 = -2 * cos_w0;
+      a2 = 1 - alpha / a;
+      break;
+  }
+  out[0] = b0 / a0;
+  out[1] = b1 / a0;
+  out[2] = b2 / a0;
+  out[3] = a1 / a0;
+  out[4] = a2 / a0;
+}
+
+static uint32_t rng_state = 0x9e3779b9;
+
+static uint32_t rand_u32(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+// a sweep plus noise at -12 dBFS in Q30, leaves headroom for the boosts like 16 bit input does
+static void make_input(int32_t *samples, int channels) {
+  for (size_t f = 0; f < FRAMES; f++) {
+    for (int ch = 0; ch < channels; ch++) {
+      const double t = (double) f / RATE;
+      const double sweep = sin(2. * M_PI * (50. + 10000. * t) * t * (1 + ch));
+      const double noise = ((int32_t) rand_u32() / 2147483648.) * 0.25;
+      samples[f * channels + ch] = (int32_t) lround((0.75 * sweep + noise) * 0.25 * (1 << 30));
+    }
+  }
+}
+
+static void test_against_reference(int channels) {
+  static int32_t samples[FRAMES * MAX_CHANNELS];
+  static double reference[FRAMES * MAX_CHANNELS];
+  int32_t coeffs[NUM_BANDS * 5];
+  int32_t state[NUM_BANDS * MAX_CHANNELS * 4];
+  double dcoeffs[NUM_BANDS][5];
+  for (int b = 0; b < NUM_BANDS; b++) {
+    design(&bands[b], dcoeffs[b]);
+    for (int k = 0; k < 5; k++) {
+      coeffs[b * 5 + k] = (int32_t) lround(dcoeffs[b][k] * (1 << COEF_SHIFT));
+    }
+  }
+  make_input(samples, channels);
+  for (size_t i = 0; i < FRAMES * (size_t) channels; i++) {
+    reference[i] = samples[i];
+  }
+
+  // reference with the unquantized coefficients, so the quantization of the coefficients is part of the error
+  for (int b = 0; b < NUM_BANDS; b++) {
+    const double *c = dcoeffs[b];
+    for (int ch = 0; ch < channels; ch++) {
+      double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+      for (size_t f = 0; f < FRAMES; f++) {
+        const double x = reference[f * channels + ch];
+        const double y = c[0] * x + c[1] * x1 + c[2] * x2 - c[3] * y1 - c[4] * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        reference[f * channels + ch] = y;
+      }
+    }
+  }
+
+  memset(state, 0, sizeof(state));
+  audio_biquad_cascade_s32(samples, FRAMES, channels, coeffs, state, NUM_BANDS, COEF_SHIFT);
+
+  double error = 0;
+  for (size_t i = 0; i < FRAMES * (size_t) channels; i++) {
+    const double diff = samples[i] - reference[i];
+    error += diff * diff;
+  }
+  const double full_scale = (double) (1 << 30);
+  const double snr_db = 10. * log10(full_scale * full_scale / (error / (FRAMES * channels) + 1e-30));
+  printf("biquad cascade, %d channels: %.1f dB below full scale\n", channels, snr_db);
+  if (snr_db < MIN_SNR_DB) {
+    fprintf(stderr, "biquad cascade, %d channels: error too large\n", channels);
+    failures++;
+  }
+}
+
+static void test_lanes_and_blocks(int channels) {
+  static int32_t samples[FRAMES * MAX_CHANNELS];
+  static int32_t mono[FRAMES];
+  int32_t coeffs[NUM_BANDS * 5];
+  int32_t state[NUM_BANDS * MAX_CHANNELS * 4];
+  int32_t mono_state[NUM_BANDS * 4];
+  for (int b = 0; b < NUM_BANDS; b++) {
+    double c[5];
+    design(&bands[b], c);
+    for (int k = 0; k < 5; k++) {
+      coeffs[b * 5 + k] = (int32_t) lround(c[k] * (1 << COEF_SHIFT));
+    }
+  }
+  make_input(samples, channels);
+  static int32_t input[FRAMES * MAX_CHANNELS];
+  memcpy(input, samples, sizeof(input));
+
+  // random block sizes, the state has to carry over
+  memset(state, 0, sizeof(state));
+  size_t done = 0;
+  while (done < FRAMES) {
+    size_t block = 1 + rand_u32() % 300;
+    if (block > FRAMES - done) {
+      block = FRAMES - done;
+    }
+    audio_biquad_cascade_s32(samples + done * channels, block, channels, coeffs, state, NUM_BANDS, COEF_SHIFT);
+    done += block;
+  }
+
+  for (int ch = 0; ch < channels; ch++) {
+    for (size_t f = 0; f < FRAMES; f++) {
+      mono[f] = input[f * channels + ch];
+    }
+    memset(mono_state, 0, sizeof(mono_state));
+    audio_biquad_cascade_s32(mono, FRAMES, 1, coeffs, mono_state, NUM_BANDS, COEF_SHIFT);
+    for (size_t f = 0; f < FRAMES; f++) {
+      if (samples[f * channels + ch] != mono[f]) {
+        fprintf(stderr, "biquad cascade, %d channels: lane %d differs from mono at frame %zu\n", channels, ch, f);
+        failures++;
+        return;
+      }
+    }
+  }
+}
+
+int main(void) {
+  for (int channels = 1; channels <= MAX_CHANNELS; channels++) {
+    test_against_reference(channels);
+    test_lanes_and_blocks(channels);
+  }
+  if (failures > 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  printf("biquad: all checks passed\n");
+  return 0;
+}
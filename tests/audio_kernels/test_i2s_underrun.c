@@ -0,0 +1,268 @@
+/*
+Simulates the hold-back steps of the I2S writers (i2s_underrun.h) on a stream of random blocks
+with random gaps, the way the speaker's player task and the ADF stream element use them.
+Checks that the audio passes unchanged without gaps, that every gap is faded out before and
+faded in after, that the underruns are counted once per gap, and that the writes stay frame
+and word aligned, in the same buffer size as the speaker's.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esphome/components/i2s_audio/i2s_underrun.h"
+
+// the speaker's event size
+#define BLOCK_SIZE 1024
+#define INPUT_BYTES (256 * 1024)
+#define MAX_OUTPUT (4 * INPUT_BYTES)
+
+enum { SILENCE, DATA, PADDING };
+
+static int failures = 0;
+
+static uint32_t rng_state = 0x2545f491;
+
+static uint32_t rand_u32(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+struct output {
+  uint8_t bytes[MAX_OUTPUT];
+  uint8_t kind[MAX_OUTPUT];
+  size_t len;
+  size_t align;
+};
+
+static void write_out(struct output *out, const uint8_t *data, size_t len, int kind) {
+  if (len % out->align != 0) {
+    fprintf(stderr, "write of %zu bytes isn't a multiple of %zu\n", len, out->align);
+    failures++;
+  }
+  memcpy(out->bytes + out->len, data, len);
+  memset(out->kind + out->len, kind, len);
+  out->len += len;
+}
+
+// writes the flushed tail, the silence appended to its whole frames is marked as padding
+static void write_tail(struct output *out, const uint8_t *block, size_t len, size_t tail_len, size_t frame_size) {
+  const size_t tail = tail_len / frame_size * frame_size;
+  write_out(out, block, len, DATA);
+  memset(out->kind + out->len - (len - tail), PADDING, len - tail);
+}
+
+/*
+Same steps as the speaker's player task: blocks of 1 to BLOCK_SIZE bytes, or whole frames as the
+stream element reads them, a gap is one or more timeouts, an incomplete frame in the tail survives
+an underrun. Returns the number of gaps followed by more audio.
+*/
+static uint32_t simulate(const uint8_t *input, size_t input_len, int bits, int channels, bool whole_frames,
+                         int gap_percent, struct output *out, i2s_underrun_stats_t *stats) {
+  const size_t frame_size = bits / 8 * channels;
+  const size_t align = i2s_underrun_align(frame_size);
+  const size_t hold = I2S_UNDERRUN_FADE_FRAMES * frame_size;
+  uint8_t block[(I2S_UNDERRUN_FADE_FRAMES + 1) * 8 + BLOCK_SIZE];
+  static const uint8_t silence[64] = {0};
+  size_t tail_len = 0;
+  bool underrun = false;
+  bool in_gap = false;
+  uint32_t gaps = 0;
+  size_t pos = 0;
+  out->len = 0;
+  out->align = align;
+
+  while (pos < input_len) {
+    if (pos > 0 && rand_u32() % 100 < (uint32_t) gap_percent) {
+      in_gap = true;
+      if (!underrun && tail_len > 0) {
+        underrun = true;
+        const size_t partial_len = tail_len % frame_size;
+        uint8_t partial[8];
+        memcpy(partial, block + tail_len - partial_len, partial_len);
+        const size_t len = i2s_underrun_flush_tail(block, tail_len, align, bits, channels, true);
+        if (len > 0) {
+          write_tail(out, block, len, tail_len, frame_size);
+        }
+        memcpy(block, partial, partial_len);
+        tail_len = partial_len;
+      }
+      if (underrun) {
+        write_out(out, silence, sizeof(silence), SILENCE);
+      }
+      continue;
+    }
+    if (in_gap) {
+      in_gap = false;
+      gaps++;
+    }
+    size_t len = 1 + rand_u32() % BLOCK_SIZE;
+    if (whole_frames) {
+      len = len < frame_size ? frame_size : len / frame_size * frame_size;
+    }
+    if (len > input_len - pos) {
+      len = input_len - pos;
+    }
+    if (tail_len + len > sizeof(block)) {
+      fprintf(stderr, "%zu held back bytes and a block of %zu overflow the buffer\n", tail_len, len);
+      failures++;
+      return gaps;
+    }
+    memcpy(block + tail_len, input + pos, len);
+    pos += len;
+    const size_t total = tail_len + len;
+    const size_t write_len = i2s_underrun_next_block(block, total, hold, align, bits, channels, &underrun, stats);
+    if (write_len > 0) {
+      write_out(out, block, write_len, DATA);
+    }
+    tail_len = total - write_len;
+    memmove(block, block + write_len, tail_len);
+  }
+  // the end of the audio is written as is
+  const size_t len = i2s_underrun_flush_tail(block, tail_len, align, bits, channels, false);
+  if (len > 0) {
+    write_tail(out, block, len, tail_len, frame_size);
+  }
+  return gaps;
+}
+
+static int32_t sample_at(const uint8_t *bytes, size_t i, int bits) {
+  if (bits > 16) {
+    int32_t value;
+    memcpy(&value, bytes + i * 4, 4);
+    return value;
+  }
+  int16_t value;
+  memcpy(&value, bytes + i * 2, 2);
+  return value;
+}
+
+static void test_without_gaps(int bits, int channels, bool whole_frames) {
+  static uint8_t input[INPUT_BYTES];
+  static struct output out;
+  for (size_t i = 0; i < sizeof(input); i++) {
+    input[i] = (uint8_t) rand_u32();
+  }
+  const size_t frame_size = bits / 8 * channels;
+  // an odd length, the incomplete last frame is dropped
+  const size_t input_len = sizeof(input) - 1;
+  const size_t expected = input_len / frame_size * frame_size;
+  i2s_underrun_stats_t stats = {0, 0};
+  simulate(input, input_len, bits, channels, whole_frames, 0, &out, &stats);
+
+  size_t data_len = 0;
+  for (size_t i = 0; i < out.len; i++) {
+    data_len += out.kind[i] == DATA;
+  }
+  if (data_len != expected || memcmp(out.bytes, input, expected) != 0 || stats.underruns != 0) {
+    fprintf(stderr, "%d bits, %d channels: the audio doesn't pass unchanged without gaps\n", bits, channels);
+    failures++;
+  }
+  for (size_t i = expected; i < out.len; i++) {
+    if (out.bytes[i] != 0) {
+      fprintf(stderr, "%d bits, %d channels: the padding isn't silent\n", bits, channels);
+      failures++;
+      break;
+    }
+  }
+}
+
+/*
+With a different constant level per channel, a misaligned frame shows as a wrong level. Data
+frames are the level, or faded towards silence within the fade frames next to a gap.
+*/
+static void test_with_gaps(int bits, int channels, bool whole_frames) {
+  static uint8_t input[INPUT_BYTES];
+  static struct output out;
+  const int32_t levels[2] = {bits > 16 ? 0x30000000 : 0x3000, bits > 16 ? -0x50000000 : -0x5000};
+  const size_t frame_size = bits / 8 * channels;
+  const size_t num_frames = sizeof(input) / frame_size;
+  for (size_t f = 0; f < num_frames; f++) {
+    for (int ch = 0; ch < channels; ch++) {
+      if (bits > 16) {
+        memcpy(input + f * frame_size + ch * 4, &levels[ch], 4);
+      } else {
+        const int16_t value = (int16_t) levels[ch];
+        memcpy(input + f * frame_size + ch * 2, &value, 2);
+      }
+    }
+  }
+  i2s_underrun_stats_t stats = {0, 0};
+  const uint32_t gaps = simulate(input, sizeof(input) - 1, bits, channels, whole_frames, 5, &out, &stats);
+  if (stats.underruns != gaps || gaps == 0) {
+    fprintf(stderr, "%d bits, %d channels: %u underruns counted for %u gaps\n", bits, channels, stats.underruns, gaps);
+    failures++;
+  }
+
+  // runs of data frames between the silence
+  size_t data_frames = 0;
+  size_t f = 0;
+  const size_t out_frames = out.len / frame_size;
+  while (f < out_frames) {
+    if (out.kind[f * frame_size] != DATA) {
+      f++;
+      continue;
+    }
+    const size_t start = f;
+    while (f < out_frames && out.kind[f * frame_size] == DATA) {
+      f++;
+    }
+    const size_t end = f;
+    data_frames += end - start;
+    const bool after_gap = start > 0;
+    // the padding of a faded out tail is followed by silence, that of the end of the audio isn't
+    size_t next = end;
+    while (next < out_frames && out.kind[next * frame_size] == PADDING) {
+      next++;
+    }
+    const bool before_gap = next < out_frames && out.kind[next * frame_size] == SILENCE;
+    for (size_t i = start; i < end; i++) {
+      const bool fade_in = after_gap && i - start < I2S_UNDERRUN_FADE_FRAMES;
+      // the faded tail is the held back frames plus less than a write unit
+      const bool fade_out = before_gap && end - i <= I2S_UNDERRUN_FADE_FRAMES + 4;
+      for (int ch = 0; ch < channels; ch++) {
+        const int32_t value = sample_at(out.bytes, i * channels + ch, bits);
+        const int64_t level = levels[ch];
+        const bool faded = (int64_t) value * level >= 0 && llabs(value) <= llabs(level);
+        if ((fade_in || fade_out) ? !faded : value != level) {
+          fprintf(stderr, "%d bits, %d channels: frame %zu, channel %d is %d\n", bits, channels, i, ch, (int) value);
+          failures++;
+          return;
+        }
+      }
+    }
+    const int32_t first = sample_at(out.bytes, start * channels, bits);
+    const int32_t last = sample_at(out.bytes, (end - 1) * channels, bits);
+    if ((after_gap && first != 0) ||
+        (before_gap && end - start >= I2S_UNDERRUN_FADE_FRAMES && llabs(last) > llabs(levels[0]) / 8)) {
+      fprintf(stderr, "%d bits, %d channels: the gap at frame %zu isn't faded\n", bits, channels,
+              after_gap ? start : end);
+      failures++;
+      return;
+    }
+  }
+  if (data_frames != (sizeof(input) - 1) / frame_size) {
+    fprintf(stderr, "%d bits, %d channels: %zu of %zu frames written\n", bits, channels, data_frames,
+            (sizeof(input) - 1) / frame_size);
+    failures++;
+  }
+}
+
+int main(void) {
+  for (int bits = 16; bits <= 32; bits += 16) {
+    for (int channels = 1; channels <= 2; channels++) {
+      for (int whole_frames = 0; whole_frames <= 1; whole_frames++) {
+        test_without_gaps(bits, channels, whole_frames);
+        test_with_gaps(bits, channels, whole_frames);
+      }
+    }
+  }
+  if (failures > 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  printf("i2s_underrun: all checks passed\n");
+  return 0;
+}
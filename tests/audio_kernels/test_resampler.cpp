@@ -0,0 +1,136 @@
+/*
+Measures the THD+N of the polyphase resampler's quality tiers over the common rate pairs and checks
+the worst case against the limits documented in the README. A sine near full scale is converted, the
+ideal sine at the output rate is fitted by least squares and everything else counts as distortion and
+noise.
+
+  test_resampler [-v]
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "esphome/components/adf_pipeline/adf_polyphase_resampler.h"
+
+using namespace esphome::esp_adf;
+
+struct Tier {
+  ResampleQuality quality;
+  const char *name;
+  // worst case THD+N in dB, as documented in the README
+  double limit_db;
+};
+
+static const Tier TIERS[] = {
+    {ResampleQuality::LOW, "low", -57.},
+    {ResampleQuality::MEDIUM, "medium", -77.},
+    {ResampleQuality::HIGH, "high", -93.},
+};
+
+static const int RATE_PAIRS[][2] = {
+    {44100, 48000}, {48000, 44100}, {48000, 16000}, {16000, 48000}, {44100, 16000},
+    {22050, 16000}, {32000, 48000}, {8000, 16000},  {16000, 8000},  {24000, 16000},
+};
+
+// input frames per call, the resampler element's buffer
+static const size_t BLOCK = 512;
+static const double DURATION_S = 0.5;
+
+// THD+N of a sine of freq Hz converted from src_rate to dst_rate in dB relative to the fitted sine
+static double thd_n(PolyphaseResampler &rsp, int src_rate, int dst_rate, double freq) {
+  const size_t in_frames = (size_t) (DURATION_S * src_rate);
+  std::vector<int16_t> in(in_frames);
+  const double amplitude = 0.89 * 32767.;  // -1 dBFS
+  for (size_t n = 0; n < in_frames; n++) {
+    in[n] = (int16_t) lround(amplitude * sin(2. * M_PI * freq * n / src_rate));
+  }
+  std::vector<int16_t> out(rsp.max_out_frames(in_frames) + BLOCK);
+  size_t out_frames = 0;
+  for (size_t done = 0; done < in_frames;) {
+    const size_t n = std::min(BLOCK, in_frames - done);
+    out_frames += rsp.process(&in[done], n, &out[out_frames]);
+    done += n;
+  }
+
+  // skip the filter's settling at both ends
+  const size_t skip = out_frames / 8;
+  const size_t first = skip, last = out_frames - skip;
+  // least squares fit of a cos + b sin + c, the delay of the filter only shows up in the phase
+  const double w = 2. * M_PI * freq / dst_rate;
+  double m[3][3] = {}, v[3] = {};
+  for (size_t n = first; n < last; n++) {
+    const double basis[3] = {cos(w * n), sin(w * n), 1.};
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        m[i][j] += basis[i] * basis[j];
+      }
+      v[i] += basis[i] * out[n];
+    }
+  }
+  // Gaussian elimination, the system is well conditioned for many periods
+  for (int i = 0; i < 3; i++) {
+    for (int k = i + 1; k < 3; k++) {
+      const double f = m[k][i] / m[i][i];
+      for (int j = i; j < 3; j++) {
+        m[k][j] -= f * m[i][j];
+      }
+      v[k] -= f * v[i];
+    }
+  }
+  double coef[3];
+  for (int i = 2; i >= 0; i--) {
+    double sum = v[i];
+    for (int j = i + 1; j < 3; j++) {
+      sum -= m[i][j] * coef[j];
+    }
+    coef[i] = sum / m[i][i];
+  }
+  double signal = 0., error = 0.;
+  for (size_t n = first; n < last; n++) {
+    const double fit = coef[0] * cos(w * n) + coef[1] * sin(w * n);
+    const double residual = out[n] - fit - coef[2];
+    signal += fit * fit;
+    error += residual * residual;
+  }
+  return 10. * log10(error / signal);
+}
+
+int main(int argc, char **argv) {
+  const bool verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+  int failures = 0;
+  for (const Tier &tier : TIERS) {
+    double worst = -200.;
+    for (const auto &pair : RATE_PAIRS) {
+      PolyphaseResampler rsp;
+      if (!rsp.configure(pair[0], pair[1], 1, tier.quality, BLOCK)) {
+        fprintf(stderr, "%s %d -> %d: not supported by the polyphase resampler\n", tier.name, pair[0], pair[1]);
+        failures++;
+        continue;
+      }
+      // a low and a high tone in the passband of both rates
+      const double min_rate = std::min(pair[0], pair[1]);
+      for (double freq : {997., 0.35 * min_rate}) {
+        const double db = thd_n(rsp, pair[0], pair[1], freq);
+        rsp.reset();
+        worst = std::max(worst, db);
+        if (verbose) {
+          printf("%-6s %5d -> %5d %7.0f Hz: %6.1f dB\n", tier.name, pair[0], pair[1], freq, db);
+        }
+      }
+    }
+    printf("%-6s worst THD+N %6.1f dB (limit %.0f dB)\n", tier.name, worst, tier.limit_db);
+    if (worst > tier.limit_db) {
+      fprintf(stderr, "%s: THD+N above the documented limit\n", tier.name);
+      failures++;
+    }
+  }
+  if (failures > 0) {
+    fprintf(stderr, "%d failures\n", failures);
+    return 1;
+  }
+  printf("resampler: all checks passed\n");
+  return 0;
+}